@@ -0,0 +1,182 @@
+#include "AffectedRunTableHandler.h"
+#include "Logger.h"
+#include <sstream>
+#include <cctype>
+#include <vector>
+
+AffectedRunTableHandler::AffectedRunTableHandler(const std::string& host,
+                                                 const std::string& port,
+                                                 const std::string& dbname,
+                                                 const std::string& user,
+                                                 const std::string& password)
+    : conn(nullptr), host(host), port(port), dbname(dbname), user(user), password(password) {
+    connect();
+
+    // Automatically create table if it doesn't exist
+    if (isConnected()) {
+        createAffectedRunTable();
+    }
+}
+
+AffectedRunTableHandler::~AffectedRunTableHandler() {
+    disconnect();
+}
+
+void AffectedRunTableHandler::connect() {
+    std::ostringstream conninfo;
+    conninfo << "host=" << host
+             << " port=" << port
+             << " dbname=" << dbname
+             << " user=" << user
+             << " password=" << password;
+
+    conn = PQconnectdb(conninfo.str().c_str());
+
+    if (PQstatus(conn) != CONNECTION_OK) {
+        LOG_ERROR("Connection to database failed: " << PQerrorMessage(conn));
+        PQfinish(conn);
+        conn = nullptr;
+    } else {
+        LOG_INFO("Successfully connected to database: " << dbname);
+    }
+}
+
+void AffectedRunTableHandler::disconnect() {
+    if (conn) {
+        PQfinish(conn);
+        conn = nullptr;
+        LOG_INFO("Disconnected from database");
+    }
+}
+
+bool AffectedRunTableHandler::isValidRunDate(const std::string& runDate) {
+    if (runDate.size() != 10 || runDate[4] != '-' || runDate[7] != '-') {
+        return false;
+    }
+    for (size_t i = 0; i < runDate.size(); i++) {
+        if (i != 4 && i != 7 && !std::isdigit(static_cast<unsigned char>(runDate[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AffectedRunTableHandler::isConnected() const {
+    return conn != nullptr && PQstatus(conn) == CONNECTION_OK;
+}
+
+bool AffectedRunTableHandler::createAffectedRunTable() {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    std::string createTableQuery =
+        "CREATE TABLE IF NOT EXISTS affected_runs ("
+        "    run_date DATE PRIMARY KEY,"
+        "    parcel_count BIGINT NOT NULL,"
+        "    parcels BYTEA NOT NULL,"
+        "    previous_run_date DATE,"
+        "    newly_affected_count BIGINT NOT NULL,"
+        "    newly_affected BYTEA NOT NULL,"
+        "    no_longer_affected_count BIGINT NOT NULL,"
+        "    no_longer_affected BYTEA NOT NULL,"
+        "    created_at TIMESTAMPTZ NOT NULL DEFAULT now()"
+        ")";
+
+    PGresult* res = PQexec(conn, createTableQuery.c_str());
+
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("CREATE TABLE failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+
+    PQclear(res);
+    return true;
+}
+
+bool AffectedRunTableHandler::storeAffectedRun(const AffectedRun& run) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    // Dates and counts as text, the bitmaps as raw bytea
+    std::vector<unsigned char> parcels, newlyAffected, noLongerAffected;
+    run.parcels.serialize(parcels);
+    run.newlyAffected.serialize(newlyAffected);
+    run.noLongerAffected.serialize(noLongerAffected);
+    const std::string parcelCount = std::to_string(run.parcels.cardinality());
+    const std::string newlyCount = std::to_string(run.newlyAffected.cardinality());
+    const std::string noLongerCount = std::to_string(run.noLongerAffected.cardinality());
+
+    const char* values[8] = {run.runDate.c_str(), parcelCount.c_str(),
+                             reinterpret_cast<const char*>(parcels.data()),
+                             run.previousRunDate.empty() ? nullptr : run.previousRunDate.c_str(),
+                             newlyCount.c_str(), reinterpret_cast<const char*>(newlyAffected.data()),
+                             noLongerCount.c_str(), reinterpret_cast<const char*>(noLongerAffected.data())};
+    const int lengths[8] = {0, 0, static_cast<int>(parcels.size()), 0,
+                            0, static_cast<int>(newlyAffected.size()),
+                            0, static_cast<int>(noLongerAffected.size())};
+    const int formats[8] = {0, 0, 1, 0, 0, 1, 0, 1};
+
+    const char* query =
+        "INSERT INTO affected_runs (run_date, parcel_count, parcels, previous_run_date, "
+        "newly_affected_count, newly_affected, no_longer_affected_count, no_longer_affected) "
+        "VALUES ($1::date, $2::bigint, $3::bytea, $4::date, $5::bigint, $6::bytea, $7::bigint, $8::bytea) "
+        "ON CONFLICT (run_date) DO UPDATE SET parcel_count = EXCLUDED.parcel_count, parcels = EXCLUDED.parcels, "
+        "previous_run_date = EXCLUDED.previous_run_date, "
+        "newly_affected_count = EXCLUDED.newly_affected_count, newly_affected = EXCLUDED.newly_affected, "
+        "no_longer_affected_count = EXCLUDED.no_longer_affected_count, "
+        "no_longer_affected = EXCLUDED.no_longer_affected, created_at = now()";
+    PGresult* res = PQexecParams(conn, query, 8, nullptr, values, lengths, formats, 0);
+
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("INSERT/UPDATE failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+
+    PQclear(res);
+    return true;
+}
+
+bool AffectedRunTableHandler::getPreviousAffectedRun(const std::string& runDate, AffectedRun& previous, bool& found) {
+    found = false;
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    // Binary results: the date cast to text arrives as its characters, the
+    // bitmap without hex encoding
+    const char* values[1] = {runDate.c_str()};
+    const char* query =
+        "SELECT run_date::text, parcels FROM affected_runs WHERE run_date < $1::date "
+        "ORDER BY run_date DESC LIMIT 1";
+    PGresult* res = PQexecParams(conn, query, 1, nullptr, values, nullptr, nullptr, 1);
+
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+
+    if (PQntuples(res) == 0) {
+        PQclear(res);
+        return true;
+    }
+
+    previous.runDate.assign(PQgetvalue(res, 0, 0), PQgetlength(res, 0, 0));
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(PQgetvalue(res, 0, 1));
+    if (!previous.parcels.deserialize(bytes, PQgetlength(res, 0, 1))) {
+        LOG_ERROR("Affected parcel set of run " << previous.runDate << " is corrupt");
+        PQclear(res);
+        return false;
+    }
+
+    PQclear(res);
+    found = true;
+    return true;
+}
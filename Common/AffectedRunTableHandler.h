@@ -0,0 +1,55 @@
+#ifndef AFFECTED_RUN_TABLE_HANDLER_H
+#define AFFECTED_RUN_TABLE_HANDLER_H
+
+#include <string>
+#include <libpq-fe.h>
+#include "ParcelBitmap.h"
+
+// Affected parcel set of one daily run and its change since the run before
+struct AffectedRun {
+    std::string runDate;                // YYYY-MM-DD
+    ParcelBitmap parcels;               // affected by any hazard layer
+    std::string previousRunDate;        // empty for the first run
+    ParcelBitmap newlyAffected;         // in parcels, not in the previous run
+    ParcelBitmap noLongerAffected;      // in the previous run, not in parcels
+};
+
+// Table affected_runs: one row per run date, the sets stored as ParcelBitmap
+// bytes (Roaring portable format) so downstream jobs can read the diffs
+// without re-running the join
+class AffectedRunTableHandler {
+private:
+    PGconn* conn;
+    std::string host;
+    std::string port;
+    std::string dbname;
+    std::string user;
+    std::string password;
+
+    void connect();
+    void disconnect();
+
+public:
+    AffectedRunTableHandler(const std::string& host = "polygons_db",
+                            const std::string& port = "5432",
+                            const std::string& dbname = "polygons_db",
+                            const std::string& user = "polygons_user",
+                            const std::string& password = "polygons_pass");
+
+    ~AffectedRunTableHandler();
+
+    // YYYY-MM-DD with digits in place
+    static bool isValidRunDate(const std::string& runDate);
+
+    bool isConnected() const;
+    bool createAffectedRunTable();
+
+    // Insert or replace the row of run.runDate
+    bool storeAffectedRun(const AffectedRun& run);
+
+    // Latest run strictly before runDate; fills runDate and parcels only.
+    // found is false if there is none.
+    bool getPreviousAffectedRun(const std::string& runDate, AffectedRun& previous, bool& found);
+};
+
+#endif // AFFECTED_RUN_TABLE_HANDLER_H
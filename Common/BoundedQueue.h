@@ -0,0 +1,95 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+struct QueueStats {
+    size_t pushed = 0;
+    size_t peakDepth = 0;
+    size_t blockedPushes = 0;                  // producer found the queue full
+    std::chrono::nanoseconds pushWait{0};      // time producers spent blocked (backpressure)
+    std::chrono::nanoseconds popWait{0};       // time consumers spent starved
+};
+
+// Blocking multi-producer / multi-consumer queue with a fixed capacity.
+// A full queue blocks producers, so a slow stage throttles the stage before it.
+template <typename T>
+class BoundedQueue {
+private:
+    std::deque<T> items;
+    size_t capacity;
+    bool closed;
+    mutable std::mutex mutex;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+    QueueStats stats;
+
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(capacity == 0 ? 1 : capacity), closed(false) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Blocks while the queue is full. Returns false if the queue was closed.
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (items.size() >= capacity && !closed) {
+            auto start = std::chrono::steady_clock::now();
+            stats.blockedPushes++;
+            notFull.wait(lock, [this] { return items.size() < capacity || closed; });
+            stats.pushWait += std::chrono::steady_clock::now() - start;
+        }
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(item));
+        stats.pushed++;
+        if (items.size() > stats.peakDepth) {
+            stats.peakDepth = items.size();
+        }
+        lock.unlock();
+        notEmpty.notify_one();
+        return true;
+    }
+
+    // Blocks while the queue is empty. Returns nullopt once closed and drained.
+    std::optional<T> pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (items.empty() && !closed) {
+            auto start = std::chrono::steady_clock::now();
+            notEmpty.wait(lock, [this] { return !items.empty() || closed; });
+            stats.popWait += std::chrono::steady_clock::now() - start;
+        }
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        notFull.notify_one();
+        return item;
+    }
+
+    // No further pushes are accepted; consumers drain what is left.
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        notFull.notify_all();
+        notEmpty.notify_all();
+    }
+
+    QueueStats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+};
+
+#endif // BOUNDED_QUEUE_H
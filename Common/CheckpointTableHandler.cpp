@@ -0,0 +1,163 @@
+#include "CheckpointTableHandler.h"
+#include "Logger.h"
+#include <sstream>
+
+CheckpointTableHandler::CheckpointTableHandler(const std::string& host,
+                                               const std::string& port,
+                                               const std::string& dbname,
+                                               const std::string& user,
+                                               const std::string& password)
+    : conn(nullptr), host(host), port(port), dbname(dbname), user(user), password(password) {
+    connect();
+
+    // Automatically create table if it doesn't exist
+    if (isConnected()) {
+        createCheckpointTable();
+    }
+}
+
+CheckpointTableHandler::~CheckpointTableHandler() {
+    disconnect();
+}
+
+void CheckpointTableHandler::connect() {
+    std::ostringstream conninfo;
+    conninfo << "host=" << host
+             << " port=" << port
+             << " dbname=" << dbname
+             << " user=" << user
+             << " password=" << password;
+
+    conn = PQconnectdb(conninfo.str().c_str());
+
+    if (PQstatus(conn) != CONNECTION_OK) {
+        LOG_ERROR("Connection to database failed: " << PQerrorMessage(conn));
+        PQfinish(conn);
+        conn = nullptr;
+    } else {
+        LOG_INFO("Successfully connected to database: " << dbname);
+    }
+}
+
+void CheckpointTableHandler::disconnect() {
+    if (conn) {
+        PQfinish(conn);
+        conn = nullptr;
+        LOG_INFO("Disconnected from database");
+    }
+}
+
+bool CheckpointTableHandler::isConnected() const {
+    return conn != nullptr && PQstatus(conn) == CONNECTION_OK;
+}
+
+// BIGINT is signed; the hash keeps its bits
+static std::string hashKey(uint64_t inputHash) {
+    return std::to_string(static_cast<int64_t>(inputHash));
+}
+
+bool CheckpointTableHandler::createCheckpointTable() {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    std::string createTableQuery =
+        "CREATE TABLE IF NOT EXISTS intersect_checkpoints ("
+        "    input_hash BIGINT PRIMARY KEY,"
+        "    parcel_rows BIGINT NOT NULL,"
+        "    state BYTEA NOT NULL,"
+        "    updated_at TIMESTAMPTZ NOT NULL DEFAULT now()"
+        ")";
+
+    PGresult* res = PQexec(conn, createTableQuery.c_str());
+
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("CREATE TABLE failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+
+    PQclear(res);
+    return true;
+}
+
+bool CheckpointTableHandler::storeCheckpoint(uint64_t inputHash, uint64_t parcelRows,
+                                             const std::vector<unsigned char>& state) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    const std::string key = hashKey(inputHash);
+    const std::string rows = std::to_string(parcelRows);
+    const char* values[3] = {key.c_str(), rows.c_str(), reinterpret_cast<const char*>(state.data())};
+    const int lengths[3] = {0, 0, static_cast<int>(state.size())};
+    const int formats[3] = {0, 0, 1};
+
+    const char* query =
+        "INSERT INTO intersect_checkpoints (input_hash, parcel_rows, state) "
+        "VALUES ($1::bigint, $2::bigint, $3::bytea) "
+        "ON CONFLICT (input_hash) DO UPDATE SET parcel_rows = EXCLUDED.parcel_rows, "
+        "state = EXCLUDED.state, updated_at = now()";
+    PGresult* res = PQexecParams(conn, query, 3, nullptr, values, lengths, formats, 0);
+
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("INSERT/UPDATE failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+
+    PQclear(res);
+    return true;
+}
+
+bool CheckpointTableHandler::getCheckpoint(uint64_t inputHash, std::vector<unsigned char>& state, bool& found) {
+    found = false;
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    // Binary result: the state without hex encoding
+    const std::string key = hashKey(inputHash);
+    const char* values[1] = {key.c_str()};
+    const char* query = "SELECT state FROM intersect_checkpoints WHERE input_hash = $1::bigint";
+    PGresult* res = PQexecParams(conn, query, 1, nullptr, values, nullptr, nullptr, 1);
+
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+
+    if (PQntuples(res) > 0) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(PQgetvalue(res, 0, 0));
+        state.assign(bytes, bytes + PQgetlength(res, 0, 0));
+        found = true;
+    }
+
+    PQclear(res);
+    return true;
+}
+
+bool CheckpointTableHandler::deleteCheckpoint(uint64_t inputHash) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    const std::string key = hashKey(inputHash);
+    const char* values[1] = {key.c_str()};
+    PGresult* res = PQexecParams(conn, "DELETE FROM intersect_checkpoints WHERE input_hash = $1::bigint",
+                                 1, nullptr, values, nullptr, nullptr, 0);
+
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("DELETE failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+
+    PQclear(res);
+    return true;
+}
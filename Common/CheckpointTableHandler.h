@@ -0,0 +1,46 @@
+#ifndef CHECKPOINT_TABLE_HANDLER_H
+#define CHECKPOINT_TABLE_HANDLER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <libpq-fe.h>
+
+// Table intersect_checkpoints: the latest progress checkpoint of each
+// unfinished IntersectCalculation run, keyed by the hash of its inputs.
+// The state is opaque bytes (RunCheckpoint::serialize); the row is deleted
+// when the run completes.
+class CheckpointTableHandler {
+private:
+    PGconn* conn;
+    std::string host;
+    std::string port;
+    std::string dbname;
+    std::string user;
+    std::string password;
+
+    void connect();
+    void disconnect();
+
+public:
+    CheckpointTableHandler(const std::string& host = "polygons_db",
+                           const std::string& port = "5432",
+                           const std::string& dbname = "polygons_db",
+                           const std::string& user = "polygons_user",
+                           const std::string& password = "polygons_pass");
+
+    ~CheckpointTableHandler();
+
+    bool isConnected() const;
+    bool createCheckpointTable();
+
+    // Insert or replace the checkpoint of inputHash
+    bool storeCheckpoint(uint64_t inputHash, uint64_t parcelRows, const std::vector<unsigned char>& state);
+
+    // found is false if there is none
+    bool getCheckpoint(uint64_t inputHash, std::vector<unsigned char>& state, bool& found);
+
+    bool deleteCheckpoint(uint64_t inputHash);
+};
+
+#endif // CHECKPOINT_TABLE_HANDLER_H
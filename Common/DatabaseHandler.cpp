@@ -1,6 +1,11 @@
 #include "DatabaseHandler.h"
-#include <iostream>
+#include "GeometryHash.h"
+#include "Logger.h"
+#include <algorithm>
+#include <charconv>
 #include <sstream>
+#include <stdexcept>
+#include <cstdlib>
 #include <cstring>
 
 DatabaseHandler::DatabaseHandler(const std::string& host, 
@@ -8,7 +13,7 @@ DatabaseHandler::DatabaseHandler(const std::string& host,
                                  const std::string& dbname,
                                  const std::string& user,
                                  const std::string& password)
-    : conn(nullptr), host(host), port(port), dbname(dbname), user(user), password(password) {
+    : conn(nullptr), host(host), port(port), dbname(dbname), user(user), password(password), hilbertOrder(-1) {
     connect();
 }
 
@@ -27,20 +32,20 @@ void DatabaseHandler::connect() {
     conn = PQconnectdb(conninfo.str().c_str());
     
     if (PQstatus(conn) != CONNECTION_OK) {
-        std::cerr << "Connection to database failed: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Connection to database failed: " << PQerrorMessage(conn));
         PQfinish(conn);
         conn = nullptr;
         throw std::runtime_error("Failed to connect to database");
     }
     
-    std::cout << "Successfully connected to database: " << dbname << std::endl;
+    LOG_INFO("Successfully connected to database: " << dbname);
 }
 
 void DatabaseHandler::disconnect() {
     if (conn) {
         PQfinish(conn);
         conn = nullptr;
-        std::cout << "Disconnected from database" << std::endl;
+        LOG_INFO("Disconnected from database");
     }
 }
 
@@ -48,78 +53,492 @@ bool DatabaseHandler::isConnected() const {
     return conn != nullptr && PQstatus(conn) == CONNECTION_OK;
 }
 
+std::string DatabaseHandler::parcelOrder() {
+    if (hilbertOrder < 0) {
+        PGresult* res = PQexec(conn,
+            "SELECT 1 FROM information_schema.columns"
+            " WHERE table_name = 'parcels_data' AND column_name = 'hilbert'");
+        hilbertOrder = (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) ? 1 : 0;
+        PQclear(res);
+        if (hilbertOrder == 0) {
+            LOG_INFO("parcels_data has no hilbert column, parcels are read in id order");
+        }
+    }
+    return hilbertOrder == 1 ? " ORDER BY hilbert, id" : " ORDER BY id";
+}
+
 std::vector<LandProperty> DatabaseHandler::getLandProperties() {
     std::vector<LandProperty> properties;
     
     if (!isConnected()) {
-        std::cerr << "Not connected to database" << std::endl;
+        LOG_ERROR("Not connected to database");
         return properties;
     }
     
-    const char* query = "SELECT id, owner, polygon FROM parcels_data ORDER BY id";
-    PGresult* res = PQexec(conn, query);
+    const std::string query = "SELECT id, owner, polygon FROM parcels_data" + parcelOrder();
+    PGresult* res = PQexec(conn, query.c_str());
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "SELECT query failed: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
         PQclear(res);
         return properties;
     }
     
     int rows = PQntuples(res);
-    std::cout << "Retrieved " << rows << " land properties from database" << std::endl;
+    LOG_INFO("Retrieved " << rows << " land properties from database");
     
-    for (int i = 0; i < rows; i++) {
-        int id = std::atoi(PQgetvalue(res, i, 0));
-        std::string owner = PQgetvalue(res, i, 1);
-        std::string polygonJson = PQgetvalue(res, i, 2);
-        
-        // Parse the JSONB polygon data
-        // Format: [[x1,y1],[x2,y2],...]
-        OGRPolygon coords;
-        
-        // Remove outer brackets and parse
-        size_t start = polygonJson.find('[');
-        size_t end = polygonJson.rfind(']');
-        
-        if (start != std::string::npos && end != std::string::npos) {
-            std::string coordsStr = polygonJson.substr(start + 1, end - start - 1);
-            
-            // Parse each coordinate pair [x,y]
-            size_t pos = 0;
-            OGRLinearRing t_ring;
-            while ((pos = coordsStr.find('[', pos)) != std::string::npos) {
-                size_t endBracket = coordsStr.find(']', pos);
-                if (endBracket != std::string::npos) {
-                    std::string pair = coordsStr.substr(pos + 1, endBracket - pos - 1);
-                    size_t comma = pair.find(',');
-                    if (comma != std::string::npos) {
-                        double x = std::stod(pair.substr(0, comma));
-                        double y = std::stod(pair.substr(comma + 1));
-                        t_ring.addPoint(x, y);
-                    }
-                    pos = endBracket + 1;
-                } else {
-                    break;
+    properties.reserve(rows);
+    try {
+        for (int i = 0; i < rows; i++) {
+            properties.push_back(parseLandProperty(res, i));
+        }
+    } catch (const std::invalid_argument& error) {
+        LOG_ERROR(error.what() << " of parcel " << PQgetvalue(res, static_cast<int>(properties.size()), 0));
+        properties.clear();
+    }
+    
+    PQclear(res);
+    return properties;
+}
+
+// One coordinate of a [x, y] pair; JSONB text puts a space after the comma
+static double parseCoordinate(std::string_view text) {
+    while (!text.empty() && text.front() == ' ') {
+        text.remove_prefix(1);
+    }
+    double value = 0.0;
+    if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc()) {
+        throw std::invalid_argument("Invalid coordinate in parcel polygon");
+    }
+    return value;
+}
+
+LandProperty DatabaseHandler::parseLandProperty(PGresult* res, int row) {
+    int id = std::atoi(PQgetvalue(res, row, 0));
+    // Owner and polygon are read in place from the result buffer: the owner
+    // is interned, the coordinates go straight into the parcel's ring
+    std::string_view owner(PQgetvalue(res, row, 1), PQgetlength(res, row, 1));
+    std::string_view polygonJson(PQgetvalue(res, row, 2), PQgetlength(res, row, 2));
+
+    // Parse the JSONB polygon data
+    // Format: [[x1,y1],[x2,y2],...]
+    std::vector<double> ring;
+
+    // Remove outer brackets and parse
+    size_t start = polygonJson.find('[');
+    size_t end = polygonJson.rfind(']');
+
+    if (start != std::string_view::npos && end != std::string_view::npos && end > start) {
+        std::string_view coordsStr = polygonJson.substr(start + 1, end - start - 1);
+        ring.reserve(2 * std::count(coordsStr.begin(), coordsStr.end(), '['));
+
+        // Parse each coordinate pair [x,y]
+        size_t pos = 0;
+        while ((pos = coordsStr.find('[', pos)) != std::string_view::npos) {
+            size_t endBracket = coordsStr.find(']', pos);
+            if (endBracket != std::string_view::npos) {
+                std::string_view pair = coordsStr.substr(pos + 1, endBracket - pos - 1);
+                size_t comma = pair.find(',');
+                if (comma != std::string_view::npos) {
+                    ring.push_back(parseCoordinate(pair.substr(0, comma)));
+                    ring.push_back(parseCoordinate(pair.substr(comma + 1)));
                 }
+                pos = endBracket + 1;
+            } else {
+                break;
             }
-            coords.addRing(&t_ring);
         }
-        
-        // Create a LandProperty and add this property to it
-        LandProperty prop;
-        prop.addProperty(id, owner, coords);
-        
-        // DEBUG: Print polygon
+    }
+
+    LandProperty prop(id, owner, std::move(ring));
 
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+    // WKT export is only paid for when debug logging is compiled in and enabled
+    if (Logger::instance().isEnabled(LogLevel::Debug)) {
         char *wkt = nullptr;
-        coords.exportToWkt(&wkt);
-        std::cout << "OGRPolygon WKT: " << wkt << std::endl;
+        prop.toPolygon()->exportToWkt(&wkt);
+        LOG_DEBUG("OGRPolygon WKT: " << wkt);
         CPLFree(wkt);
-        // END DEBUG
-        
-        properties.push_back(prop);
     }
+#endif
     
+    return prop;
+}
+
+bool DatabaseHandler::fingerprintQuery(const std::string& query, uint64_t& hash) {
+    PGresult* res = PQexec(conn, query.c_str());
+    if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1) {
+        LOG_ERROR("Fingerprint query failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+
+    // FNV-1a over the row count and the sum of the row hashes, as text,
+    // each followed by a 0xff byte that never occurs in it
+    static constexpr unsigned char kTerminator = 0xff;
+    hash = kFnvOffsetBasis;
+    for (int column = 0; column < PQnfields(res); column++) {
+        hash = fnv1a(hash, PQgetvalue(res, 0, column), PQgetlength(res, 0, column));
+        hash = fnv1a(hash, &kTerminator, 1);
+    }
     PQclear(res);
-    return properties;
+    return true;
+}
+
+bool DatabaseHandler::fingerprintParcels(uint64_t& hash) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    // Only the columns the join reads, so adding envelope columns to the
+    // table does not change it
+    return fingerprintQuery(
+        "SELECT count(*)::text, coalesce(sum(hashtextextended(concat_ws('|', id, owner, polygon), 0)), 0)::text"
+        " FROM parcels_data", hash);
+}
+
+bool DatabaseHandler::fingerprintTable(const std::string& table, uint64_t& hash) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    char* escaped = PQescapeIdentifier(conn, table.c_str(), table.size());
+    if (escaped == nullptr) {
+        LOG_ERROR("Invalid table name " << table << ": " << PQerrorMessage(conn));
+        return false;
+    }
+    const std::string identifier = escaped;
+    PQfreemem(escaped);
+
+    const char* values[1] = {identifier.c_str()};
+    PGresult* res = PQexecParams(conn, "SELECT to_regclass($1) IS NOT NULL", 1, nullptr, values, nullptr, nullptr, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    const bool exists = PQgetvalue(res, 0, 0)[0] == 't';
+    PQclear(res);
+
+    if (!exists) {
+        return fingerprintQuery("SELECT '0', '0'", hash);
+    }
+    return fingerprintQuery("SELECT count(*)::text, coalesce(sum(hashtextextended(t::text, 0)), 0)::text FROM "
+                            + identifier + " t", hash);
+}
+
+bool DatabaseHandler::getQuarantinedParcels(std::unordered_map<int, uint64_t>& hashes) {
+    hashes.clear();
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    const char* ddl =
+        "CREATE TABLE IF NOT EXISTS quarantine_parcels ("
+        "    parcel_id INTEGER PRIMARY KEY,"
+        "    source_hash BIGINT NOT NULL,"
+        "    operation TEXT NOT NULL,"
+        "    vertex_count BIGINT NOT NULL,"
+        "    elapsed_ms DOUBLE PRECISION NOT NULL,"
+        "    quarantined_at TIMESTAMPTZ NOT NULL DEFAULT now()"
+        ")";
+    if (!execCommand(ddl)) {
+        return false;
+    }
+
+    PGresult* res = PQexec(conn, "SELECT parcel_id, source_hash FROM quarantine_parcels");
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    int rows = PQntuples(res);
+    hashes.reserve(rows);
+    for (int i = 0; i < rows; i++) {
+        hashes[std::atoi(PQgetvalue(res, i, 0))] =
+            static_cast<uint64_t>(std::strtoll(PQgetvalue(res, i, 1), nullptr, 10));
+    }
+    PQclear(res);
+    return true;
+}
+
+bool DatabaseHandler::updateQuarantinedParcels(const std::vector<QuarantineRecord>& records,
+                                               const std::vector<int>& released) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    if (records.empty() && released.empty()) {
+        return true;
+    }
+    if (!execCommand("BEGIN")) {
+        return false;
+    }
+
+    // Text parameters; the hash travels as the signed BIGINT it is stored as
+    bool ok = true;
+    const char* upsert =
+        "INSERT INTO quarantine_parcels (parcel_id, source_hash, operation, vertex_count, elapsed_ms) "
+        "VALUES ($1::int4, $2::int8, $3, $4::int8, $5::float8) "
+        "ON CONFLICT (parcel_id) DO UPDATE SET source_hash = EXCLUDED.source_hash, "
+        "operation = EXCLUDED.operation, vertex_count = EXCLUDED.vertex_count, "
+        "elapsed_ms = EXCLUDED.elapsed_ms, quarantined_at = now()";
+    for (const auto& record : records) {
+        const std::string id = std::to_string(record.id);
+        const std::string hash = std::to_string(static_cast<int64_t>(record.sourceHash));
+        const std::string vertices = std::to_string(record.vertexCount);
+        std::ostringstream elapsed;
+        elapsed << record.elapsedMs;
+        const std::string elapsedText = elapsed.str();
+        const char* values[5] = {id.c_str(), hash.c_str(), record.operation.c_str(), vertices.c_str(),
+                                 elapsedText.c_str()};
+        PGresult* res = PQexecParams(conn, upsert, 5, nullptr, values, nullptr, nullptr, 0);
+        ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        if (!ok) {
+            LOG_ERROR("INSERT/UPDATE failed: " << PQerrorMessage(conn));
+        }
+        PQclear(res);
+        if (!ok) {
+            break;
+        }
+    }
+    for (size_t i = 0; ok && i < released.size(); i++) {
+        const std::string id = std::to_string(released[i]);
+        const char* values[1] = {id.c_str()};
+        PGresult* res = PQexecParams(conn, "DELETE FROM quarantine_parcels WHERE parcel_id = $1::int4",
+                                     1, nullptr, values, nullptr, nullptr, 0);
+        ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+        if (!ok) {
+            LOG_ERROR("DELETE failed: " << PQerrorMessage(conn));
+        }
+        PQclear(res);
+    }
+
+    PQclear(PQexec(conn, ok ? "COMMIT" : "ROLLBACK"));
+    return ok;
+}
+
+bool DatabaseHandler::execCommand(const char* sql) {
+    PGresult* res = PQexec(conn, sql);
+    bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    if (!ok) {
+        LOG_ERROR("Command failed: " << PQerrorMessage(conn));
+    }
+    PQclear(res);
+    return ok;
+}
+
+bool DatabaseHandler::copyFrom(const std::string& copyCommand, const std::function<bool(std::string&)>& next) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    PGresult* res = PQexec(conn, copyCommand.c_str());
+    if (PQresultStatus(res) != PGRES_COPY_IN) {
+        LOG_ERROR("COPY failed to start: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    PQclear(res);
+
+    std::string chunk;
+    bool sent = true;
+    while (next(chunk)) {
+        if (!chunk.empty() && PQputCopyData(conn, chunk.data(), static_cast<int>(chunk.size())) != 1) {
+            LOG_ERROR("COPY data failed: " << PQerrorMessage(conn));
+            sent = false;
+            break;
+        }
+        chunk.clear();
+    }
+
+    if (PQputCopyEnd(conn, sent ? nullptr : "client aborted") != 1) {
+        LOG_ERROR("COPY end failed: " << PQerrorMessage(conn));
+        return false;
+    }
+    bool ok = sent;
+    while ((res = PQgetResult(conn)) != nullptr) {
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+            LOG_ERROR("COPY failed: " << PQerrorMessage(conn));
+            ok = false;
+        }
+        PQclear(res);
+    }
+    return ok;
+}
+
+bool DatabaseHandler::hasEnvelopeColumns() {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+
+    // Read-only: the columns and their indexes belong to ParcelLoader
+    PGresult* res = PQexec(conn,
+        "SELECT count(*) FROM information_schema.columns"
+        " WHERE table_name = 'parcels_data' AND column_name IN ('minx', 'miny', 'maxx', 'maxy')");
+    const bool hasColumns = PQresultStatus(res) == PGRES_TUPLES_OK && std::atoi(PQgetvalue(res, 0, 0)) == 4;
+    PQclear(res);
+    if (!hasColumns) {
+        LOG_WARN("parcels_data has no envelope columns; load it with ParcelLoader to enable the parcel pushdown");
+        return false;
+    }
+
+    // A row without an envelope would never match the extents. Answered by
+    // the partial index on rows with minx IS NULL.
+    res = PQexec(conn, "SELECT EXISTS (SELECT 1 FROM parcels_data WHERE minx IS NULL)");
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    const bool complete = PQgetvalue(res, 0, 0)[0] == 'f';
+    PQclear(res);
+    if (!complete) {
+        LOG_WARN("Some parcels_data rows have no envelope; reload them with ParcelLoader to enable the parcel pushdown");
+    }
+    return complete;
+}
+
+bool DatabaseHandler::streamLandProperties(size_t batchSize,
+                                           const std::function<bool(std::vector<LandProperty>&&)>& consumer,
+                                           StreamResume* resume) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    return streamQuery("SELECT id, owner, polygon FROM parcels_data" + parcelOrder(), batchSize, consumer, resume);
+}
+
+bool DatabaseHandler::streamLandProperties(size_t batchSize, const std::vector<OGREnvelope>& extents,
+                                           const std::function<bool(std::vector<LandProperty>&&)>& consumer,
+                                           StreamResume* resume) {
+    if (extents.empty()) {
+        LOG_INFO("No extents given, no parcels to stream");
+        return true;
+    }
+
+    // One && per extent; the planner ORs bitmap scans of the GiST index.
+    // The expression must match the index definition exactly.
+    std::ostringstream query;
+    query.precision(17);
+    query << "SELECT id, owner, polygon FROM parcels_data WHERE ";
+    for (size_t i = 0; i < extents.size(); i++) {
+        const OGREnvelope& e = extents[i];
+        query << (i > 0 ? " OR " : "")
+              << "box(point(minx, miny), point(maxx, maxy)) && box '(("
+              << e.MinX << "," << e.MinY << "),(" << e.MaxX << "," << e.MaxY << "))'";
+    }
+    query << parcelOrder();
+    return streamQuery(query.str(), batchSize, consumer, resume);
+}
+
+bool DatabaseHandler::skipRows(StreamResume& resume) {
+    // Skipped rows are never sent; only the last one is fetched, to check
+    // that the query still orders the same rows first
+    if (resume.rows > 1) {
+        std::string move = "MOVE FORWARD " + std::to_string(resume.rows - 1) + " FROM parcel_cursor";
+        PGresult* res = PQexec(conn, move.c_str());
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+            LOG_ERROR("MOVE failed: " << PQerrorMessage(conn));
+            PQclear(res);
+            return false;
+        }
+        PQclear(res);
+    }
+    PGresult* res = PQexec(conn, "FETCH FORWARD 1 FROM parcel_cursor");
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("FETCH failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    resume.matched = PQntuples(res) == 1 && std::atoi(PQgetvalue(res, 0, 0)) == resume.lastId;
+    PQclear(res);
+    if (!resume.matched) {
+        LOG_ERROR("Parcel " << resume.rows << " of the stream is not parcel " << resume.lastId
+                  << ", cannot resume");
+        return false;
+    }
+    LOG_INFO("Skipped " << resume.rows << " parcels up to parcel " << resume.lastId);
+    return true;
+}
+
+bool DatabaseHandler::streamQuery(const std::string& query, size_t batchSize,
+                                  const std::function<bool(std::vector<LandProperty>&&)>& consumer,
+                                  StreamResume* resume) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    
+    // Cursors only live inside a transaction
+    PGresult* res = PQexec(conn, "BEGIN");
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("BEGIN failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    PQclear(res);
+    
+    std::string declare = "DECLARE parcel_cursor NO SCROLL CURSOR FOR " + query;
+    res = PQexec(conn, declare.c_str());
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("DECLARE CURSOR failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        PQclear(PQexec(conn, "ROLLBACK"));
+        return false;
+    }
+    PQclear(res);
+
+    if (resume != nullptr && resume->rows > 0 && !skipRows(*resume)) {
+        PQclear(PQexec(conn, "ROLLBACK"));
+        return false;
+    }
+    
+    std::string fetchQuery = "FETCH FORWARD " + std::to_string(batchSize) + " FROM parcel_cursor";
+    bool ok = true;
+    size_t total = 0;
+    while (true) {
+        res = PQexec(conn, fetchQuery.c_str());
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            LOG_ERROR("FETCH failed: " << PQerrorMessage(conn));
+            PQclear(res);
+            ok = false;
+            break;
+        }
+        
+        int rows = PQntuples(res);
+        if (rows == 0) {
+            PQclear(res);
+            break;
+        }
+        
+        std::vector<LandProperty> batch;
+        batch.reserve(rows);
+        try {
+            for (int i = 0; i < rows; i++) {
+                batch.push_back(parseLandProperty(res, i));
+            }
+        } catch (const std::invalid_argument& error) {
+            // Fails the stream like a database error; skipping the row would
+            // shift the row counts that checkpoints resume from
+            LOG_ERROR(error.what() << " of parcel " << PQgetvalue(res, static_cast<int>(batch.size()), 0));
+            PQclear(res);
+            ok = false;
+            break;
+        }
+        PQclear(res);
+        total += rows;
+        
+        if (!consumer(std::move(batch))) {
+            break;
+        }
+    }
+    
+    PQclear(PQexec(conn, ok ? "COMMIT" : "ROLLBACK"));
+    LOG_INFO("Streamed " << total << " land properties from database");
+    return ok;
 }
\ No newline at end of file
@@ -5,7 +5,10 @@
 #include <vector>
 #include <memory>
 #include <utility>
+#include <functional>
+#include <unordered_map>
 #include <libpq-fe.h>
+#include "GeometryBudget.h"
 #include "LandProperty.h"
 #include <ogrsf_frmts.h>
 
@@ -15,6 +18,15 @@ struct Polygon {
     int id;
 };
 
+// Resume point of a parcel stream: the first rows rows of the ordered query
+// are skipped, and the last of them must have id lastId. matched is false
+// after a stream whose skipped rows did not end at lastId.
+struct StreamResume {
+    size_t rows = 0;
+    int lastId = -1;
+    bool matched = true;
+};
+
 class DatabaseHandler {
 private:
     PGconn* conn;
@@ -23,9 +35,16 @@ private:
     std::string dbname;
     std::string user;
     std::string password;
+    int hilbertOrder;       // parcels_data has a hilbert column: -1 not checked yet, 0 no, 1 yes
     
     void connect();
     void disconnect();
+    // ORDER BY of parcel reads: Hilbert key order when the loader stored one
+    std::string parcelOrder();
+    bool streamQuery(const std::string& query, size_t batchSize,
+                     const std::function<bool(std::vector<LandProperty>&&)>& consumer, StreamResume* resume);
+    bool skipRows(StreamResume& resume);
+    bool fingerprintQuery(const std::string& query, uint64_t& hash);
 
 public:
     DatabaseHandler(const std::string& host = "polygons_db", 
@@ -36,7 +55,57 @@ public:
     
     ~DatabaseHandler();
 
+    // Parcel from one row of an (id, owner, polygon) result; reads the row
+    // in place. Throws std::invalid_argument on a malformed coordinate.
+    static LandProperty parseLandProperty(PGresult* res, int row);
+
     std::vector<LandProperty> getLandProperties();
+
+    // Stream parcels through a server-side cursor, batchSize rows at a time,
+    // in Hilbert order of their envelope centres when parcels_data has the
+    // hilbert column (written by ParcelLoader), else in id order.
+    // The consumer may block (backpressure) or return false to stop early.
+    // A row with a malformed polygon fails the stream (false).
+    // With a resume point the stream continues after its rows.
+    bool streamLandProperties(size_t batchSize,
+                              const std::function<bool(std::vector<LandProperty>&&)>& consumer,
+                              StreamResume* resume = nullptr);
+
+    // Same, but only parcels whose envelope overlaps one of the extents.
+    // Needs the envelope columns (see hasEnvelopeColumns).
+    bool streamLandProperties(size_t batchSize, const std::vector<OGREnvelope>& extents,
+                              const std::function<bool(std::vector<LandProperty>&&)>& consumer,
+                              StreamResume* resume = nullptr);
+
+    // Order-independent hash of the id, owner and polygon of every parcel,
+    // to tell whether parcels_data changed between two runs (full scan)
+    bool fingerprintParcels(uint64_t& hash);
+
+    // Same over whole rows of any table; a missing table hashes as empty
+    bool fingerprintTable(const std::string& table, uint64_t& hash);
+
+    // True if parcels_data has the minx/miny/maxx/maxy columns written by
+    // ParcelLoader and every row has them filled. Only reads the catalog and
+    // the table; nothing is created or backfilled.
+    bool hasEnvelopeColumns();
+
+    // Parcels whose join exceeded a GeometryBudget (table quarantine_parcels):
+    // create the table if needed and read the source hash of each
+    bool getQuarantinedParcels(std::unordered_map<int, uint64_t>& hashes);
+
+    // In one transaction: insert or replace the records and drop the
+    // released parcels
+    bool updateQuarantinedParcels(const std::vector<QuarantineRecord>& records, const std::vector<int>& released);
+
+    // Run one or more SQL statements that return no rows
+    bool execCommand(const char* sql);
+
+    // Run a COPY ... FROM STDIN statement and feed it the chunks produced by
+    // next(chunk) until it returns false. Chunks are sent as-is, so the
+    // caller encodes the COPY format (text or binary). Returns false if the
+    // server rejected the data; the COPY is then rolled back.
+    bool copyFrom(const std::string& copyCommand, const std::function<bool(std::string&)>& next);
+
     bool isConnected() const;
 };
 
@@ -0,0 +1,29 @@
+#ifndef GEOMETRY_BUDGET_H
+#define GEOMETRY_BUDGET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Limits one geometry operation may use on the main pass before the
+// geometry is quarantined and handed to the slow lane; 0 = unlimited
+struct GeometryBudget {
+    double timeMs = 30000.0;
+    size_t maxVertices = 1000000;
+
+    bool overVertices(size_t vertices) const { return maxVertices > 0 && vertices > maxVertices; }
+    bool overTime(double elapsedMs) const { return timeMs > 0.0 && elapsedMs > timeMs; }
+};
+
+// Cost of a geometry that exceeded its budget. Later runs route quarantined
+// geometries to the slow lane; sourceHash (hashPolygon / hashRing) lets a
+// changed geometry leave quarantine.
+struct QuarantineRecord {
+    int id;
+    uint64_t sourceHash;
+    std::string operation;      // what exceeded the budget, e.g. "validate", "repair", "join"
+    size_t vertexCount;
+    double elapsedMs;           // time spent before the interrupt or until done
+};
+
+#endif // GEOMETRY_BUDGET_H
@@ -0,0 +1,51 @@
+#ifndef GEOMETRY_HASH_H
+#define GEOMETRY_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <ogrsf_frmts.h>
+
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ULL;
+
+// 64-bit FNV-1a of size bytes, continuing from hash (kFnvOffsetBasis to
+// start). Shared by the geometry hashes and the run input fingerprints.
+inline uint64_t fnv1a(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// FNV-1a over the ring sizes and coordinate bit patterns of a polygon.
+// Identifies a source geometry across runs, so derived data (repairs) can
+// be reused until the shapefile changes.
+inline uint64_t hashPolygon(const OGRPolygon& poly) {
+    uint64_t hash = kFnvOffsetBasis;
+    auto mixRing = [&hash](const OGRLinearRing* ring) {
+        int numPoints = ring != nullptr ? ring->getNumPoints() : 0;
+        hash = fnv1a(hash, &numPoints, sizeof(numPoints));
+        for (int i = 0; i < numPoints; i++) {
+            double xy[2] = {ring->getX(i), ring->getY(i)};
+            hash = fnv1a(hash, xy, sizeof(xy));
+        }
+    };
+
+    mixRing(poly.getExteriorRing());
+    for (int i = 0; i < poly.getNumInteriorRings(); i++) {
+        mixRing(poly.getInteriorRing(i));
+    }
+    return hash;
+}
+
+// hashPolygon() of a polygon with this exterior ring (interleaved x,y) and
+// no holes, so parcel hashes match whichever form they were computed from
+inline uint64_t hashRing(std::span<const double> xy) {
+    const int numPoints = static_cast<int>(xy.size() / 2);
+    const uint64_t hash = fnv1a(kFnvOffsetBasis, &numPoints, sizeof(numPoints));
+    return fnv1a(hash, xy.data(), 2 * static_cast<size_t>(numPoints) * sizeof(double));
+}
+
+#endif // GEOMETRY_HASH_H
@@ -0,0 +1,64 @@
+#ifndef HAZARD_PROTOCOL_H
+#define HAZARD_PROTOCOL_H
+
+#include <cstdint>
+
+// Binary protocol between the IntersectCalculation daemon and its clients.
+//
+// Both ends run on the same host over a Unix socket, so all fields are in
+// native byte order and structs are sent as-is. One connection carries any
+// number of request/response pairs.
+//
+//   request  = RequestHeader, payload (payloadSize bytes)
+//   response = ResponseHeader, count x HazardHit
+namespace HazardProtocol {
+
+constexpr uint32_t kRequestMagic = 0x31515A48;   // "HZQ1"
+constexpr uint32_t kResponseMagic = 0x31525A48;  // "HZR1"
+constexpr uint32_t kMaxPayload = 16u << 20;
+
+enum class RequestType : uint8_t {
+    Point = 1,      // payload: double x, double y
+    Parcel = 2,     // payload: int32 parcel id
+    Polygon = 3,    // payload: uint32 n, then n x (double x, double y), closed or not
+    Reload = 4,     // payload: none; rebuilds the snapshot in the background
+};
+
+enum class Status : uint8_t {
+    Ok = 0,
+    NotFound = 1,       // unknown parcel id
+    BadRequest = 2,
+    Unavailable = 3,    // no snapshot loaded yet
+    Busy = 4,           // connection limit reached; sent on accept, then the daemon hangs up
+};
+
+struct RequestHeader {
+    uint32_t magic;
+    RequestType type;
+    uint8_t reserved[3];
+    uint32_t payloadSize;
+};
+
+struct ResponseHeader {
+    uint32_t magic;
+    Status status;
+    uint8_t reserved[3];
+    uint32_t count;         // number of HazardHit records that follow
+    uint32_t reserved2;
+    double value;           // burned fraction for Parcel/Polygon queries
+};
+
+// One hazard polygon touched by the query
+struct HazardHit {
+    int32_t polygonId;      // stable shapefile id (FID * 1000 + part)
+    uint32_t reserved;
+    double area;            // intersection area (0 for point queries)
+};
+
+static_assert(sizeof(RequestHeader) == 12, "RequestHeader layout");
+static_assert(sizeof(ResponseHeader) == 24, "ResponseHeader layout");
+static_assert(sizeof(HazardHit) == 16, "HazardHit layout");
+
+} // namespace HazardProtocol
+
+#endif // HAZARD_PROTOCOL_H
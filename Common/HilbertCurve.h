@@ -0,0 +1,53 @@
+#ifndef HILBERT_CURVE_H
+#define HILBERT_CURVE_H
+
+#include <cstdint>
+#include <utility>
+#include <ogrsf_frmts.h>
+
+// Position along a Hilbert curve, used as a sort key so that records close
+// in key order are close on the map. The frame is fixed (the Web Mercator
+// square our data lives in), so keys computed by different binaries and
+// runs are comparable and can be stored.
+namespace HilbertCurve {
+
+constexpr int kOrder = 31;                          // 2^31 cells per axis (~19 mm), key < 2^62
+constexpr double kHalfWorld = 20037508.342789244;   // Web Mercator x/y range is +-kHalfWorld
+
+// Distance of cell (x, y) along the curve of side 2^order
+inline uint64_t index(uint32_t x, uint32_t y, int order = kOrder) {
+    uint64_t d = 0;
+    for (uint32_t s = 1u << (order - 1); s > 0; s >>= 1) {
+        const uint32_t rx = (x & s) ? 1 : 0;
+        const uint32_t ry = (y & s) ? 1 : 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant; only the bits below s are read afterwards
+        if (ry == 0) {
+            if (rx == 1) {
+                x = ~x;
+                y = ~y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Cell of a coordinate; outside the frame (or NaN) clamps to the border
+inline uint32_t cell(double v) {
+    const double t = (v + kHalfWorld) / (2.0 * kHalfWorld) * static_cast<double>(1u << kOrder);
+    if (!(t > 0.0)) {
+        return 0;
+    }
+    return t >= static_cast<double>((1u << kOrder) - 1) ? (1u << kOrder) - 1 : static_cast<uint32_t>(t);
+}
+
+// Sort key of an envelope: the curve position of its centre. Fits a
+// signed 64-bit column.
+inline int64_t key(const OGREnvelope& env) {
+    return static_cast<int64_t>(index(cell(0.5 * (env.MinX + env.MaxX)), cell(0.5 * (env.MinY + env.MaxY))));
+}
+
+} // namespace HilbertCurve
+
+#endif // HILBERT_CURVE_H
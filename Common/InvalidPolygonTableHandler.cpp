@@ -1,19 +1,31 @@
 #include "InvalidPolygonTableHandler.h"
-#include <iostream>
+#include "Logger.h"
 #include <sstream>
+#include <cctype>
+#include <cstdlib>
 #include <cstring>
+#include <arpa/inet.h>
 
 InvalidPolygonTableHandler::InvalidPolygonTableHandler(const std::string& host, 
                                                        const std::string& port,
                                                        const std::string& dbname,
                                                        const std::string& user,
-                                                       const std::string& password)
-    : conn(nullptr), host(host), port(port), dbname(dbname), user(user), password(password) {
+                                                       const std::string& password,
+                                                       const std::string& hazard)
+    : conn(nullptr), host(host), port(port), dbname(dbname), user(user), password(password),
+      invalidTable("invalid_" + hazard), repairedTable("repaired_" + hazard),
+      quarantineTable("quarantine_" + hazard) {
+    if (!isValidHazardName(hazard)) {
+        LOG_ERROR("Invalid hazard name '" << hazard << "'");
+        return;
+    }
     connect();
     
     // Automatically create table if it doesn't exist
     if (isConnected()) {
         createInvalidWildfireTable();
+        createRepairedWildfireTable();
+        createQuarantineTable();
     }
 }
 
@@ -32,11 +44,11 @@ void InvalidPolygonTableHandler::connect() {
     conn = PQconnectdb(conninfo.str().c_str());
     
     if (PQstatus(conn) != CONNECTION_OK) {
-        std::cerr << "Connection to database failed: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Connection to database failed: " << PQerrorMessage(conn));
         PQfinish(conn);
         conn = nullptr;
     } else {
-        std::cout << "Successfully connected to database: " << dbname << std::endl;
+        LOG_INFO("Successfully connected to database: " << dbname);
     }
 }
 
@@ -44,8 +56,21 @@ void InvalidPolygonTableHandler::disconnect() {
     if (conn) {
         PQfinish(conn);
         conn = nullptr;
-        std::cout << "Disconnected from database" << std::endl;
+        LOG_INFO("Disconnected from database");
+    }
+}
+
+bool InvalidPolygonTableHandler::isValidHazardName(const std::string& hazard) {
+    // Becomes part of the table names, so only lower-case identifier characters
+    if (hazard.empty() || hazard.size() > 48 || !std::islower(static_cast<unsigned char>(hazard[0]))) {
+        return false;
     }
+    for (char c : hazard) {
+        if (!std::islower(static_cast<unsigned char>(c)) && !std::isdigit(static_cast<unsigned char>(c)) && c != '_') {
+            return false;
+        }
+    }
+    return true;
 }
 
 bool InvalidPolygonTableHandler::isConnected() const {
@@ -54,44 +79,44 @@ bool InvalidPolygonTableHandler::isConnected() const {
 
 bool InvalidPolygonTableHandler::createInvalidWildfireTable() {
     if (!isConnected()) {
-        std::cerr << "Not connected to database" << std::endl;
+        LOG_ERROR("Not connected to database");
         return false;
     }
     
-    const char* createTableQuery = 
-        "CREATE TABLE IF NOT EXISTS invalid_wildfire ("
+    std::string createTableQuery = 
+        "CREATE TABLE IF NOT EXISTS " + invalidTable + " ("
         "    polygon_id INTEGER PRIMARY KEY,"
         "    is_invalid SMALLINT NOT NULL CHECK (is_invalid IN (0, 1))"
         ")";
     
-    PGresult* res = PQexec(conn, createTableQuery);
+    PGresult* res = PQexec(conn, createTableQuery.c_str());
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::cerr << "CREATE TABLE failed: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("CREATE TABLE failed: " << PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
     
     PQclear(res);
-    std::cout << "Table invalid_wildfire created successfully" << std::endl;
+    LOG_INFO("Table " << invalidTable << " created successfully");
     return true;
 }
 
 bool InvalidPolygonTableHandler::setWildfireValidity(int polygonId, bool isInvalid) {
     if (!isConnected()) {
-        std::cerr << "Not connected to database" << std::endl;
+        LOG_ERROR("Not connected to database");
         return false;
     }
     
     std::ostringstream queryStream;
-    queryStream << "INSERT INTO invalid_wildfire (polygon_id, is_invalid) "
+    queryStream << "INSERT INTO " << invalidTable << " (polygon_id, is_invalid) "
                 << "VALUES (" << polygonId << ", " << (isInvalid ? 1 : 0) << ") "
                 << "ON CONFLICT (polygon_id) DO UPDATE SET is_invalid = " << (isInvalid ? 1 : 0);
     
     PGresult* res = PQexec(conn, queryStream.str().c_str());
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::cerr << "INSERT/UPDATE failed: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("INSERT/UPDATE failed: " << PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -102,17 +127,17 @@ bool InvalidPolygonTableHandler::setWildfireValidity(int polygonId, bool isInval
 
 bool InvalidPolygonTableHandler::isWildfireInvalid(int polygonId, bool& isInvalid) {
     if (!isConnected()) {
-        std::cerr << "Not connected to database" << std::endl;
+        LOG_ERROR("Not connected to database");
         return false;
     }
     
     std::ostringstream queryStream;
-    queryStream << "SELECT is_invalid FROM invalid_wildfire WHERE polygon_id = " << polygonId;
+    queryStream << "SELECT is_invalid FROM " << invalidTable << " WHERE polygon_id = " << polygonId;
     
     PGresult* res = PQexec(conn, queryStream.str().c_str());
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "SELECT query failed: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -132,17 +157,17 @@ bool InvalidPolygonTableHandler::isWildfireInvalid(int polygonId, bool& isInvali
 
 bool InvalidPolygonTableHandler::getWildfireValidity(int polygonId, bool& isInvalid) {
     if (!isConnected()) {
-        std::cerr << "Not connected to database" << std::endl;
+        LOG_ERROR("Not connected to database");
         return false;
     }
     
     std::ostringstream queryStream;
-    queryStream << "SELECT is_invalid FROM invalid_wildfire WHERE polygon_id = " << polygonId;
+    queryStream << "SELECT is_invalid FROM " << invalidTable << " WHERE polygon_id = " << polygonId;
     
     PGresult* res = PQexec(conn, queryStream.str().c_str());
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "SELECT query failed: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -159,3 +184,268 @@ bool InvalidPolygonTableHandler::getWildfireValidity(int polygonId, bool& isInva
     PQclear(res);
     return true;
 }
+
+bool InvalidPolygonTableHandler::getInvalidWildfireIds(std::vector<int>& polygonIds) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    
+    std::string query = "SELECT polygon_id FROM " + invalidTable + " WHERE is_invalid = 1";
+    PGresult* res = PQexec(conn, query.c_str());
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    int rows = PQntuples(res);
+    polygonIds.clear();
+    polygonIds.reserve(rows);
+    for (int i = 0; i < rows; i++) {
+        polygonIds.push_back(std::atoi(PQgetvalue(res, i, 0)));
+    }
+    
+    PQclear(res);
+    return true;
+}
+
+bool InvalidPolygonTableHandler::createRepairedWildfireTable() {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    
+    std::string createTableQuery = 
+        "CREATE TABLE IF NOT EXISTS " + repairedTable + " ("
+        "    polygon_id INTEGER PRIMARY KEY,"
+        "    source_hash BIGINT NOT NULL,"
+        "    wkb BYTEA NOT NULL"
+        ")";
+    
+    PGresult* res = PQexec(conn, createTableQuery.c_str());
+    
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("CREATE TABLE failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    PQclear(res);
+    return true;
+}
+
+bool InvalidPolygonTableHandler::storeRepairedWildfire(const RepairedGeometry& repair) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    
+    // Binary parameters: int4 and int8 in network byte order, raw bytea
+    uint32_t id = htonl(static_cast<uint32_t>(repair.polygonId));
+    uint32_t hashHigh = htonl(static_cast<uint32_t>(repair.sourceHash >> 32));
+    uint32_t hashLow = htonl(static_cast<uint32_t>(repair.sourceHash));
+    char hash[8];
+    std::memcpy(hash, &hashHigh, 4);
+    std::memcpy(hash + 4, &hashLow, 4);
+    
+    const char* values[3] = {reinterpret_cast<const char*>(&id), hash,
+                             reinterpret_cast<const char*>(repair.wkb.data())};
+    const int lengths[3] = {4, 8, static_cast<int>(repair.wkb.size())};
+    const int formats[3] = {1, 1, 1};
+    
+    std::string query =
+        "INSERT INTO " + repairedTable + " (polygon_id, source_hash, wkb) VALUES ($1::int4, $2::int8, $3::bytea) "
+        "ON CONFLICT (polygon_id) DO UPDATE SET source_hash = EXCLUDED.source_hash, wkb = EXCLUDED.wkb";
+    PGresult* res = PQexecParams(conn, query.c_str(), 3, nullptr, values, lengths, formats, 0);
+    
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("INSERT/UPDATE failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    PQclear(res);
+    return true;
+}
+
+static int32_t readInt32(const char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, 4);
+    return static_cast<int32_t>(ntohl(value));
+}
+
+static uint64_t readUint64(const char* p) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(readInt32(p))) << 32) |
+           static_cast<uint32_t>(readInt32(p + 4));
+}
+
+bool InvalidPolygonTableHandler::getRepairedWildfireHashes(std::unordered_map<int, uint64_t>& hashes) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    
+    std::string query = "SELECT polygon_id, source_hash FROM " + repairedTable;
+    PGresult* res = PQexecParams(conn, query.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    int rows = PQntuples(res);
+    hashes.clear();
+    hashes.reserve(rows);
+    for (int i = 0; i < rows; i++) {
+        hashes[readInt32(PQgetvalue(res, i, 0))] = readUint64(PQgetvalue(res, i, 1));
+    }
+    
+    PQclear(res);
+    return true;
+}
+
+bool InvalidPolygonTableHandler::getRepairedWildfires(std::vector<RepairedGeometry>& repairs) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    
+    // Binary results skip the hex bytea encoding of the WKB
+    std::string query = "SELECT polygon_id, source_hash, wkb FROM " + repairedTable;
+    PGresult* res = PQexecParams(conn, query.c_str(), 0, nullptr, nullptr, nullptr, nullptr, 1);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    int rows = PQntuples(res);
+    repairs.clear();
+    repairs.reserve(rows);
+    for (int i = 0; i < rows; i++) {
+        const unsigned char* wkb = reinterpret_cast<const unsigned char*>(PQgetvalue(res, i, 2));
+        repairs.push_back(RepairedGeometry{readInt32(PQgetvalue(res, i, 0)),
+                                           readUint64(PQgetvalue(res, i, 1)),
+                                           std::vector<unsigned char>(wkb, wkb + PQgetlength(res, i, 2))});
+    }
+    
+    PQclear(res);
+    return true;
+}
+
+bool InvalidPolygonTableHandler::createQuarantineTable() {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    
+    std::string createTableQuery = 
+        "CREATE TABLE IF NOT EXISTS " + quarantineTable + " ("
+        "    polygon_id INTEGER PRIMARY KEY,"
+        "    source_hash BIGINT NOT NULL,"
+        "    operation TEXT NOT NULL,"
+        "    vertex_count BIGINT NOT NULL,"
+        "    elapsed_ms DOUBLE PRECISION NOT NULL,"
+        "    quarantined_at TIMESTAMPTZ NOT NULL DEFAULT now()"
+        ")";
+    
+    PGresult* res = PQexec(conn, createTableQuery.c_str());
+    
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("CREATE TABLE failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    PQclear(res);
+    return true;
+}
+
+bool InvalidPolygonTableHandler::storeQuarantined(const QuarantineRecord& record) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    
+    // Text parameters; the hash travels as the signed BIGINT it is stored as
+    const std::string id = std::to_string(record.id);
+    const std::string hash = std::to_string(static_cast<int64_t>(record.sourceHash));
+    const std::string vertices = std::to_string(record.vertexCount);
+    std::ostringstream elapsed;
+    elapsed << record.elapsedMs;
+    const std::string elapsedText = elapsed.str();
+    const char* values[5] = {id.c_str(), hash.c_str(), record.operation.c_str(), vertices.c_str(), elapsedText.c_str()};
+    
+    std::string query =
+        "INSERT INTO " + quarantineTable + " (polygon_id, source_hash, operation, vertex_count, elapsed_ms) "
+        "VALUES ($1::int4, $2::int8, $3, $4::int8, $5::float8) "
+        "ON CONFLICT (polygon_id) DO UPDATE SET source_hash = EXCLUDED.source_hash, "
+        "operation = EXCLUDED.operation, vertex_count = EXCLUDED.vertex_count, "
+        "elapsed_ms = EXCLUDED.elapsed_ms, quarantined_at = now()";
+    PGresult* res = PQexecParams(conn, query.c_str(), 5, nullptr, values, nullptr, nullptr, 0);
+    
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("INSERT/UPDATE failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    PQclear(res);
+    return true;
+}
+
+bool InvalidPolygonTableHandler::releaseQuarantined(int polygonId) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    
+    std::ostringstream queryStream;
+    queryStream << "DELETE FROM " << quarantineTable << " WHERE polygon_id = " << polygonId;
+    
+    PGresult* res = PQexec(conn, queryStream.str().c_str());
+    
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("DELETE failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    PQclear(res);
+    return true;
+}
+
+bool InvalidPolygonTableHandler::getQuarantined(std::unordered_map<int, QuarantineRecord>& records) {
+    if (!isConnected()) {
+        LOG_ERROR("Not connected to database");
+        return false;
+    }
+    
+    std::string query = "SELECT polygon_id, source_hash, operation, vertex_count, elapsed_ms FROM " + quarantineTable;
+    PGresult* res = PQexec(conn, query.c_str());
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("SELECT query failed: " << PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    int rows = PQntuples(res);
+    records.clear();
+    records.reserve(rows);
+    for (int i = 0; i < rows; i++) {
+        QuarantineRecord record{std::atoi(PQgetvalue(res, i, 0)),
+                                static_cast<uint64_t>(std::strtoll(PQgetvalue(res, i, 1), nullptr, 10)),
+                                PQgetvalue(res, i, 2),
+                                static_cast<size_t>(std::strtoull(PQgetvalue(res, i, 3), nullptr, 10)),
+                                std::strtod(PQgetvalue(res, i, 4), nullptr)};
+        records[record.id] = record;
+    }
+    
+    PQclear(res);
+    return true;
+}
@@ -1,8 +1,19 @@
 #ifndef INVALID_POLYGON_TABLE_HANDLER_H
 #define INVALID_POLYGON_TABLE_HANDLER_H
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <libpq-fe.h>
+#include "GeometryBudget.h"
+
+// Repaired version of an invalid wildfire, stored as WKB
+struct RepairedGeometry {
+    int polygonId;
+    uint64_t sourceHash;                // hashPolygon() of the geometry it repairs
+    std::vector<unsigned char> wkb;
+};
 
 class InvalidPolygonTableHandler {
 private:
@@ -12,6 +23,9 @@ private:
     std::string dbname;
     std::string user;
     std::string password;
+    std::string invalidTable;       // invalid_<hazard>
+    std::string repairedTable;      // repaired_<hazard>
+    std::string quarantineTable;    // quarantine_<hazard>
     
     void connect();
     void disconnect();
@@ -21,15 +35,37 @@ public:
                                const std::string& port = "5432",
                                const std::string& dbname = "polygons_db",
                                const std::string& user = "polygons_user",
-                               const std::string& password = "polygons_pass");
+                               const std::string& password = "polygons_pass",
+                               const std::string& hazard = "wildfire");
     
     ~InvalidPolygonTableHandler();
 
+    // Hazard names select the tables (invalid_<hazard>, repaired_<hazard>,
+    // quarantine_<hazard>):
+    // lower-case letters, digits and '_', starting with a letter
+    static bool isValidHazardName(const std::string& hazard);
+
     bool isConnected() const;
     bool createInvalidWildfireTable();
     bool setWildfireValidity(int polygonId, bool isInvalid);
     bool isWildfireInvalid(int polygonId, bool& isInvalid);
     bool getWildfireValidity(int polygonId, bool& isInvalid);
+
+    // Load every polygon id flagged invalid in one query (for hot loops)
+    bool getInvalidWildfireIds(std::vector<int>& polygonIds);
+
+    // Repaired geometries (table repaired_wildfire)
+    bool createRepairedWildfireTable();
+    bool storeRepairedWildfire(const RepairedGeometry& repair);
+    bool getRepairedWildfireHashes(std::unordered_map<int, uint64_t>& hashes);
+    bool getRepairedWildfires(std::vector<RepairedGeometry>& repairs);
+
+    // Polygons that exceeded a GeometryBudget (table quarantine_wildfire),
+    // validated in the slow lane by later runs
+    bool createQuarantineTable();
+    bool storeQuarantined(const QuarantineRecord& record);
+    bool releaseQuarantined(int polygonId);
+    bool getQuarantined(std::unordered_map<int, QuarantineRecord>& records);
 };
 
 #endif // INVALID_POLYGON_TABLE_HANDLER_H
@@ -1,40 +1,49 @@
 #include "LandProperty.h"
+#include "OwnerDictionary.h"
 #include <iostream>
 
-LandProperty::LandProperty() : id(0), owner("") {
+LandProperty::LandProperty(int propId, std::string_view propOwner, std::vector<double>&& ring)
+    : id(propId), ownerId(OwnerDictionary::instance().intern(propOwner)), ring(std::move(ring)) {
 }
 
 int LandProperty::getId() const {
     return id;
 }
 
-std::string LandProperty::getOwner() const {
-    return owner;
+uint32_t LandProperty::getOwnerId() const {
+    return ownerId;
 }
 
-const OGRPolygon& LandProperty::getPolygon() const {
+std::string_view LandProperty::getOwner() const {
+    return OwnerDictionary::instance().name(ownerId);
+}
+
+std::span<const double> LandProperty::getRing() const {
+    return ring;
+}
+
+int LandProperty::getNumPoints() const {
+    return static_cast<int>(ring.size() / 2);
+}
+
+std::unique_ptr<OGRPolygon> LandProperty::toPolygon() const {
+    auto polygon = std::make_unique<OGRPolygon>();
+    auto exterior = std::make_unique<OGRLinearRing>();
+    exterior->setNumPoints(getNumPoints(), FALSE);
+    for (int i = 0; i < getNumPoints(); i++) {
+        exterior->setPoint(i, ring[2 * i], ring[2 * i + 1]);
+    }
+    polygon->addRingDirectly(exterior.release());
     return polygon;
 }
 
 void LandProperty::printPolygonInfo() const {
     std::cout << "  ID: " << id << std::endl;
-    std::cout << "  Owner: " << owner << std::endl;
-    
-    const OGRLinearRing* ring = polygon.getExteriorRing();
-    if (ring != nullptr) {
-        std::cout << "  Polygon points: " << ring->getNumPoints() << std::endl;
-        if (ring->getNumPoints() > 0) {
-            std::cout << "  First coordinate: (" 
-                      << ring->getX(0) << ", " 
-                      << ring->getY(0) << ")" << std::endl;
-        }
+    std::cout << "  Owner: " << getOwner() << std::endl;
+    std::cout << "  Polygon points: " << getNumPoints() << std::endl;
+    if (getNumPoints() > 0) {
+        std::cout << "  First coordinate: ("
+                  << ring[0] << ", "
+                  << ring[1] << ")" << std::endl;
     }
 }
-
-void LandProperty::addProperty(int propId, 
-                                const std::string& propOwner, 
-                                const OGRPolygon& coords) {
-    this->id = propId;
-    this->owner = propOwner;
-    this->polygon = coords;
-}
@@ -1,29 +1,43 @@
 #ifndef LAND_PROPERTY_H
 #define LAND_PROPERTY_H
 
+#include <cstdint>
+#include <memory>
+#include <span>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <ogrsf_frmts.h>
+
+// One parcel. It owns its exterior ring as interleaved x,y coordinates and
+// is move-only, so a parcel's geometry is built once by the parser and
+// moved through batches and queues, never copied; readers get views.
 class LandProperty {
 private:
     int id;
-    std::string owner;
-    OGRPolygon polygon;
+    uint32_t ownerId;           // interned in OwnerDictionary
+    std::vector<double> ring;   // x0,y0,x1,y1,... as stored (closed rings repeat the first point)
 
 public:
-    LandProperty();
-    
-    // Get polygon data by index
+    LandProperty(int propId, std::string_view propOwner, std::vector<double>&& ring);
+
+    LandProperty(const LandProperty&) = delete;
+    LandProperty& operator=(const LandProperty&) = delete;
+    LandProperty(LandProperty&&) noexcept = default;
+    LandProperty& operator=(LandProperty&&) noexcept = default;
+
     int getId() const;
-    std::string getOwner() const;
-    const OGRPolygon& getPolygon() const;
+    uint32_t getOwnerId() const;
+    std::string_view getOwner() const;
+
+    // Exterior ring coordinates, valid while the parcel lives
+    std::span<const double> getRing() const;
+    int getNumPoints() const;
+
+    // OGR copy of the geometry, for GEOS or WKT export; allocates
+    std::unique_ptr<OGRPolygon> toPolygon() const;
     void printPolygonInfo() const;
-    
-    // Add a single land property
-    void addProperty(int propId, 
-                    const std::string& propOwner, 
-                    const OGRPolygon& coords);
 };
 
 #endif // LAND_PROPERTY_H
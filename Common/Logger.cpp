@@ -0,0 +1,207 @@
+#include "Logger.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+static const char* levelTag(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "[DEBUG] ";
+        case LogLevel::Info:  return "[INFO] ";
+        case LogLevel::Warn:  return "[WARN] ";
+        case LogLevel::Error: return "[ERROR] ";
+    }
+    return "";
+}
+
+bool parseLogLevel(std::string_view name, LogLevel& level) {
+    if (name == "debug") level = LogLevel::Debug;
+    else if (name == "info") level = LogLevel::Info;
+    else if (name == "warn") level = LogLevel::Warn;
+    else if (name == "error") level = LogLevel::Error;
+    else return false;
+    return true;
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+    : slots(new Slot[kSlotCount]), enqueuePos(0), dequeuePos(0), dropped(0),
+      minLevel(LOG_COMPILE_LEVEL), running(true) {
+    static_assert((kSlotCount & (kSlotCount - 1)) == 0, "slot count must be a power of two");
+    for (size_t i = 0; i < kSlotCount; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    drainer = std::thread(&Logger::drainLoop, this);
+}
+
+Logger::~Logger() {
+    running = false;
+    wake.notify_one();
+    if (drainer.joinable()) {
+        drainer.join();
+    }
+}
+
+void Logger::setLevel(LogLevel level) {
+    // Statements below the compile level are not in the binary at all
+    static const char* const kLevelNames[] = {"debug", "info", "warn", "error"};
+    static const char* const kLevelMacros[] = {"LOG_LEVEL_DEBUG", "LOG_LEVEL_INFO", "LOG_LEVEL_WARN", "LOG_LEVEL_ERROR"};
+    const int requested = static_cast<int>(level);
+    if (requested < LOG_COMPILE_LEVEL) {
+        write(LogLevel::Warn, std::string("Log level ") + kLevelNames[requested] +
+                                  " requested, but this build compiles out messages below " +
+                                  kLevelNames[LOG_COMPILE_LEVEL] + " (rebuild with -DLOG_COMPILE_LEVEL=" +
+                                  kLevelMacros[requested] + ")");
+    }
+    minLevel = std::max(requested, LOG_COMPILE_LEVEL);
+}
+
+bool Logger::isEnabled(LogLevel level) const {
+    return static_cast<int>(level) >= minLevel.load(std::memory_order_relaxed);
+}
+
+size_t Logger::getDroppedCount() const {
+    return dropped.load();
+}
+
+void Logger::write(LogLevel level, std::string_view message) {
+    if (tryPush(level, message)) {
+        return;
+    }
+    if (level != LogLevel::Error) {
+        dropped++;
+        return;
+    }
+    // Errors are rare and must not be lost: wait for the drainer to make room
+    do {
+        wake.notify_one();
+        std::this_thread::yield();
+    } while (!tryPush(level, message));
+}
+
+bool Logger::tryPush(LogLevel level, std::string_view message) {
+    // Bounded MPMC ring (Vyukov): a slot is free for position pos when its
+    // sequence equals pos, and holds a message when it equals pos + 1.
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots[pos & (kSlotCount - 1)];
+        size_t seq = slot->sequence.load(std::memory_order_acquire);
+        long long diff = static_cast<long long>(seq) - static_cast<long long>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->level = level;
+    if (message.size() <= kMaxMessage) {
+        slot->length = message.size();
+        std::memcpy(slot->text, message.data(), slot->length);
+    } else {
+        // Cut on a UTF-8 character boundary and mark the cut with "…"
+        static constexpr std::string_view kEllipsis = "\xE2\x80\xA6";
+        size_t kept = kMaxMessage - kEllipsis.size();
+        while (kept > 0 && (static_cast<unsigned char>(message[kept]) & 0xC0) == 0x80) {
+            kept--;
+        }
+        std::memcpy(slot->text, message.data(), kept);
+        std::memcpy(slot->text + kept, kEllipsis.data(), kEllipsis.size());
+        slot->length = kept + kEllipsis.size();
+    }
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+size_t Logger::drainOnce() {
+    size_t count = 0;
+    while (true) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Slot& slot = slots[pos & (kSlotCount - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            break;
+        }
+
+        FILE* out = (slot.level >= LogLevel::Warn) ? stderr : stdout;
+        std::fputs(levelTag(slot.level), out);
+        std::fwrite(slot.text, 1, slot.length, out);
+        std::fputc('\n', out);
+
+        slot.sequence.store(pos + kSlotCount, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_release);
+        count++;
+    }
+    if (count > 0) {
+        std::fflush(stdout);
+        std::fflush(stderr);
+    }
+    return count;
+}
+
+void Logger::drainLoop() {
+    size_t reportedDrops = 0;
+    while (true) {
+        size_t written = drainOnce();
+
+        size_t drops = dropped.load();
+        if (drops != reportedDrops) {
+            std::fprintf(stderr, "[WARN] %zu log messages dropped (buffer full)\n", drops - reportedDrops);
+            std::fflush(stderr);
+            reportedDrops = drops;
+        }
+
+        if (written == 0) {
+            if (!running) {
+                break;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(5));
+        }
+    }
+}
+
+void Logger::flush() {
+    size_t target = enqueuePos.load();
+    while (dequeuePos.load() < target) {
+        wake.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+ProgressSummary::ProgressSummary(std::string what, std::chrono::steady_clock::duration interval)
+    : what(std::move(what)), start(std::chrono::steady_clock::now()), interval(interval), total(0),
+      nextReport((start + interval).time_since_epoch().count()) {
+}
+
+void ProgressSummary::add(size_t count) {
+    size_t current = total.fetch_add(count) + count;
+
+    long long now = std::chrono::steady_clock::now().time_since_epoch().count();
+    long long due = nextReport.load(std::memory_order_relaxed);
+    if (now < due) {
+        return;
+    }
+    // Only the thread that moves the deadline forward logs the summary
+    if (nextReport.compare_exchange_strong(due, now + interval.count())) {
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO(what << ": " << current << " (" << static_cast<long long>(current / seconds) << "/s)");
+    }
+}
+
+void ProgressSummary::finish() {
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t current = total.load();
+    LOG_INFO(what << ": " << current << " total in " << seconds << " s");
+}
+
+size_t ProgressSummary::getTotal() const {
+    return total.load();
+}
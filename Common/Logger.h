@@ -0,0 +1,138 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Numeric levels so they can be compared in #if. Statements below
+// LOG_COMPILE_LEVEL are compiled out: their arguments are still type-checked
+// but never evaluated, so they cost nothing at run time.
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+
+enum class LogLevel { Debug = LOG_LEVEL_DEBUG, Info = LOG_LEVEL_INFO, Warn = LOG_LEVEL_WARN, Error = LOG_LEVEL_ERROR };
+
+// Parses "debug", "info", "warn" or "error" (e.g. from a --log-level flag)
+bool parseLogLevel(std::string_view name, LogLevel& level);
+
+// Process-wide asynchronous logger.
+//
+// Callers format into a fixed-size slot of a lock-free ring buffer and return
+// immediately; a background thread drains the ring and writes whole bursts
+// with a single flush. When the ring is full, Debug/Info/Warn messages are
+// dropped (and counted) rather than stalling the caller, Error waits.
+class Logger {
+public:
+    static constexpr size_t kSlotCount = 4096;     // power of two
+    static constexpr size_t kMaxMessage = 496;     // longer messages are cut and end in "…"
+
+    static Logger& instance();
+
+    // Levels below LOG_COMPILE_LEVEL are raised to it, with a warning
+    void setLevel(LogLevel level);
+    bool isEnabled(LogLevel level) const;
+    void write(LogLevel level, std::string_view message);
+
+    // Block until everything logged so far has been written out.
+    void flush();
+    size_t getDroppedCount() const;
+
+    ~Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        size_t length;
+        char text[kMaxMessage];
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> enqueuePos;
+    alignas(64) std::atomic<size_t> dequeuePos;
+    std::atomic<size_t> dropped;
+    std::atomic<int> minLevel;
+    std::atomic<bool> running;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::thread drainer;
+
+    Logger();
+    bool tryPush(LogLevel level, std::string_view message);
+    size_t drainOnce();
+    void drainLoop();
+};
+
+// Counts items from any thread and logs "<what>: N (rate/s)" at most once per
+// interval, replacing one log line per item in hot loops.
+class ProgressSummary {
+private:
+    std::string what;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::duration interval;
+    std::atomic<size_t> total;
+    std::atomic<long long> nextReport;
+
+public:
+    explicit ProgressSummary(std::string what,
+                             std::chrono::steady_clock::duration interval = std::chrono::seconds(10));
+
+    void add(size_t count = 1);
+    void finish();
+    size_t getTotal() const;
+};
+
+#define LOG_AT(level, expr)                                         \
+    do {                                                            \
+        if (Logger::instance().isEnabled(level)) {                  \
+            std::ostringstream logStream_;                          \
+            logStream_ << expr;                                     \
+            Logger::instance().write(level, logStream_.str());      \
+        }                                                           \
+    } while (0)
+
+#define LOG_DISABLED(expr)                                          \
+    do {                                                            \
+        if constexpr (false) {                                      \
+            std::ostringstream logStream_;                          \
+            logStream_ << expr;                                     \
+        }                                                           \
+    } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(expr) LOG_AT(LogLevel::Debug, expr)
+#else
+#define LOG_DEBUG(expr) LOG_DISABLED(expr)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(expr) LOG_AT(LogLevel::Info, expr)
+#else
+#define LOG_INFO(expr) LOG_DISABLED(expr)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(expr) LOG_AT(LogLevel::Warn, expr)
+#else
+#define LOG_WARN(expr) LOG_DISABLED(expr)
+#endif
+
+#define LOG_ERROR(expr) LOG_AT(LogLevel::Error, expr)
+
+#endif // LOGGER_H
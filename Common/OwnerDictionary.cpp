@@ -0,0 +1,53 @@
+#include "OwnerDictionary.h"
+#include <mutex>
+
+OwnerDictionary::OwnerDictionary() : nameBytes(0) {
+}
+
+OwnerDictionary& OwnerDictionary::instance() {
+    static OwnerDictionary dictionary;
+    return dictionary;
+}
+
+uint32_t OwnerDictionary::intern(std::string_view owner) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = ids.find(owner);
+        if (it != ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(owner);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    const uint32_t id = static_cast<uint32_t>(names.size());
+    names.emplace_back(owner);
+    ids.emplace(names.back(), id);
+    if (names.back().capacity() > std::string().capacity()) {
+        nameBytes += names.back().capacity() + 1;      // beyond the small-string buffer
+    }
+    return id;
+}
+
+const std::string& OwnerDictionary::name(uint32_t id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names[id];
+}
+
+size_t OwnerDictionary::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return names.size();
+}
+
+size_t OwnerDictionary::getMemoryUsage() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    // Names (string objects plus heap buffers beyond the small-string buffer)
+    // and the table's nodes and buckets
+    size_t bytes = names.size() * sizeof(std::string) + nameBytes;
+    bytes += ids.size() * (sizeof(std::pair<const std::string_view, uint32_t>) + 2 * sizeof(void*));
+    bytes += ids.bucket_count() * sizeof(void*);
+    return bytes;
+}
@@ -0,0 +1,40 @@
+#ifndef OWNER_DICTIONARY_H
+#define OWNER_DICTIONARY_H
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Process-wide interning of parcel owner names to dense 32-bit ids, so each
+// distinct owner string is stored once however many parcels it owns. Ids
+// start at 0 in first-seen order and never change. Safe from any thread;
+// references returned by name() stay valid for the life of the process.
+class OwnerDictionary {
+public:
+    static OwnerDictionary& instance();
+
+    // Id of the owner, adding it on first sight
+    uint32_t intern(std::string_view owner);
+
+    const std::string& name(uint32_t id) const;
+
+    size_t size() const;
+
+    // Approximate heap bytes held by the names and the lookup table
+    size_t getMemoryUsage() const;
+
+private:
+    OwnerDictionary();
+    OwnerDictionary(const OwnerDictionary&) = delete;
+    OwnerDictionary& operator=(const OwnerDictionary&) = delete;
+
+    mutable std::shared_mutex mutex;
+    std::deque<std::string> names;      // deque keeps references stable on growth
+    std::unordered_map<std::string_view, uint32_t> ids;     // views into names
+    size_t nameBytes;                   // heap buffers of long names
+};
+
+#endif // OWNER_DICTIONARY_H
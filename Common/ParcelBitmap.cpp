@@ -0,0 +1,249 @@
+#include "ParcelBitmap.h"
+#include <algorithm>
+#include <iterator>
+
+// Roaring portable format, the variant without run containers
+static constexpr uint32_t kSerialCookie = 12346;
+
+bool ParcelBitmap::Container::contains(uint16_t value) const {
+    if (isBitmap()) {
+        return (bits[value >> 6] >> (value & 63)) & 1;
+    }
+    return std::binary_search(values.begin(), values.end(), value);
+}
+
+void ParcelBitmap::Container::add(uint16_t value) {
+    if (isBitmap()) {
+        uint64_t& word = bits[value >> 6];
+        const uint64_t mask = uint64_t(1) << (value & 63);
+        cardinality += (word & mask) == 0;
+        word |= mask;
+        return;
+    }
+    if (values.empty() || values.back() < value) {
+        values.push_back(value);
+    } else {
+        auto it = std::lower_bound(values.begin(), values.end(), value);
+        if (*it == value) {
+            return;
+        }
+        values.insert(it, value);
+    }
+    cardinality++;
+    if (cardinality > kMaxArraySize) {
+        toBitmap();
+    }
+}
+
+void ParcelBitmap::Container::toBitmap() {
+    bits.assign(kBitmapWords, 0);
+    for (uint16_t value : values) {
+        bits[value >> 6] |= uint64_t(1) << (value & 63);
+    }
+    std::vector<uint16_t>().swap(values);
+}
+
+void ParcelBitmap::Container::toArray() {
+    values.clear();
+    values.reserve(cardinality);
+    for (size_t w = 0; w < kBitmapWords; w++) {
+        for (uint64_t word = bits[w]; word != 0; word &= word - 1) {
+            values.push_back(static_cast<uint16_t>(w * 64 + std::countr_zero(word)));
+        }
+    }
+    std::vector<uint64_t>().swap(bits);
+}
+
+void ParcelBitmap::add(uint32_t id) {
+    const uint16_t key = static_cast<uint16_t>(id >> 16);
+    auto it = containers.end();
+    if (containers.empty() || containers.back().key < key) {
+        containers.push_back(Container{key});
+        it = containers.end() - 1;
+    } else if (containers.back().key == key) {
+        it = containers.end() - 1;
+    } else {
+        it = std::lower_bound(containers.begin(), containers.end(), key,
+                              [](const Container& c, uint16_t k) { return c.key < k; });
+        if (it->key != key) {
+            it = containers.insert(it, Container{key});
+        }
+    }
+    it->add(static_cast<uint16_t>(id));
+}
+
+bool ParcelBitmap::contains(uint32_t id) const {
+    const uint16_t key = static_cast<uint16_t>(id >> 16);
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [](const Container& c, uint16_t k) { return c.key < k; });
+    return it != containers.end() && it->key == key && it->contains(static_cast<uint16_t>(id));
+}
+
+size_t ParcelBitmap::cardinality() const {
+    size_t total = 0;
+    for (const Container& container : containers) {
+        total += container.cardinality;
+    }
+    return total;
+}
+
+bool ParcelBitmap::empty() const {
+    return containers.empty();
+}
+
+ParcelBitmap::Container ParcelBitmap::difference(const Container& a, const Container& b) {
+    Container result{a.key};
+    if (a.isBitmap()) {
+        result.bits = a.bits;
+        if (b.isBitmap()) {
+            for (size_t w = 0; w < kBitmapWords; w++) {
+                result.bits[w] &= ~b.bits[w];
+                result.cardinality += std::popcount(result.bits[w]);
+            }
+        } else {
+            for (uint16_t value : b.values) {
+                result.bits[value >> 6] &= ~(uint64_t(1) << (value & 63));
+            }
+            for (uint64_t word : result.bits) {
+                result.cardinality += std::popcount(word);
+            }
+        }
+        if (result.cardinality <= kMaxArraySize) {
+            result.toArray();
+        }
+        return result;
+    }
+
+    // Array minus array is a merge walk, array minus bitmap a bit test per value
+    if (b.isBitmap()) {
+        for (uint16_t value : a.values) {
+            if (!b.contains(value)) {
+                result.values.push_back(value);
+            }
+        }
+    } else {
+        std::set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                            std::back_inserter(result.values));
+    }
+    result.cardinality = static_cast<uint32_t>(result.values.size());
+    return result;
+}
+
+ParcelBitmap ParcelBitmap::difference(const ParcelBitmap& other) const {
+    ParcelBitmap result;
+    auto theirs = other.containers.begin();
+    for (const Container& mine : containers) {
+        while (theirs != other.containers.end() && theirs->key < mine.key) {
+            ++theirs;
+        }
+        if (theirs == other.containers.end() || theirs->key != mine.key) {
+            result.containers.push_back(mine);
+            continue;
+        }
+        Container remaining = difference(mine, *theirs);
+        if (remaining.cardinality > 0) {
+            result.containers.push_back(std::move(remaining));
+        }
+    }
+    return result;
+}
+
+static void writeUint16(std::vector<unsigned char>& out, uint16_t value) {
+    out.push_back(static_cast<unsigned char>(value));
+    out.push_back(static_cast<unsigned char>(value >> 8));
+}
+
+static void writeUint32(std::vector<unsigned char>& out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<unsigned char>(value >> shift));
+    }
+}
+
+static uint16_t readUint16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t readUint32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+void ParcelBitmap::serialize(std::vector<unsigned char>& out) const {
+    // Little-endian: cookie, container count, (key, cardinality - 1) per
+    // container, the byte offset of each container, then the containers
+    const size_t headerSize = 8 + 8 * containers.size();
+    out.clear();
+    out.reserve(headerSize + getMemoryUsage());
+    writeUint32(out, kSerialCookie);
+    writeUint32(out, static_cast<uint32_t>(containers.size()));
+    for (const Container& container : containers) {
+        writeUint16(out, container.key);
+        writeUint16(out, static_cast<uint16_t>(container.cardinality - 1));
+    }
+    uint32_t offset = static_cast<uint32_t>(headerSize);
+    for (const Container& container : containers) {
+        writeUint32(out, offset);
+        offset += container.isBitmap() ? kBitmapWords * 8 : container.cardinality * 2;
+    }
+    for (const Container& container : containers) {
+        if (!container.isBitmap()) {
+            for (uint16_t value : container.values) {
+                writeUint16(out, value);
+            }
+            continue;
+        }
+        for (uint64_t word : container.bits) {
+            writeUint32(out, static_cast<uint32_t>(word));
+            writeUint32(out, static_cast<uint32_t>(word >> 32));
+        }
+    }
+}
+
+bool ParcelBitmap::deserialize(const unsigned char* data, size_t size) {
+    containers.clear();
+    if (size < 8 || readUint32(data) != kSerialCookie) {
+        return false;
+    }
+    const size_t count = readUint32(data + 4);
+    if (count > 65536 || size < 8 + 8 * count) {
+        return false;
+    }
+    containers.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        Container& container = containers[i];
+        container.key = readUint16(data + 8 + 4 * i);
+        container.cardinality = readUint16(data + 10 + 4 * i) + 1u;
+        const size_t offset = readUint32(data + 8 + 4 * count + 4 * i);
+        const bool bitmap = container.cardinality > kMaxArraySize;
+        const size_t bytes = bitmap ? kBitmapWords * 8 : container.cardinality * 2;
+        if ((i > 0 && container.key <= containers[i - 1].key) || offset > size || size - offset < bytes) {
+            containers.clear();
+            return false;
+        }
+        const unsigned char* p = data + offset;
+        if (bitmap) {
+            container.bits.resize(kBitmapWords);
+            for (size_t w = 0; w < kBitmapWords; w++) {
+                container.bits[w] = readUint32(p + 8 * w) | (static_cast<uint64_t>(readUint32(p + 8 * w + 4)) << 32);
+            }
+        } else {
+            container.values.resize(container.cardinality);
+            for (size_t v = 0; v < container.cardinality; v++) {
+                container.values[v] = readUint16(p + 2 * v);
+                if (v > 0 && container.values[v] <= container.values[v - 1]) {
+                    containers.clear();
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+size_t ParcelBitmap::getMemoryUsage() const {
+    size_t bytes = containers.capacity() * sizeof(Container);
+    for (const Container& container : containers) {
+        bytes += container.values.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
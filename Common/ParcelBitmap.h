@@ -0,0 +1,83 @@
+#ifndef PARCEL_BITMAP_H
+#define PARCEL_BITMAP_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compressed set of parcel ids in the Roaring layout: ids are split into a
+// 16-bit key (high half) and a 16-bit value, and each key holds either a
+// sorted array of values (up to 4096) or a 65536-bit bitmap. Sparse runs
+// cost 2 bytes per id, dense ones at most 8 KiB per 65536 ids, and set
+// operations work a container at a time.
+//
+// serialize() writes the Roaring portable format (no run containers), so
+// the stored sets can also be read by the Roaring libraries.
+class ParcelBitmap {
+public:
+    static constexpr size_t kMaxArraySize = 4096;
+
+    ParcelBitmap() = default;
+
+    // Ids in any order; appending in ascending order is cheapest
+    void add(uint32_t id);
+    bool contains(uint32_t id) const;
+
+    size_t cardinality() const;
+    bool empty() const;
+
+    // Ids in this set but not in other, e.g. newly affected parcels
+    ParcelBitmap difference(const ParcelBitmap& other) const;
+
+    // Call visit(id) in ascending order
+    template <typename Visitor>
+    void forEach(Visitor&& visit) const;
+
+    void serialize(std::vector<unsigned char>& out) const;
+    // False (and an empty set) if data is not a valid serialized bitmap
+    bool deserialize(const unsigned char* data, size_t size);
+
+    size_t getMemoryUsage() const;
+
+private:
+    static constexpr size_t kBitmapWords = 1024;
+
+    struct Container {
+        uint16_t key;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> values;   // sorted, while the container is an array
+        std::vector<uint64_t> bits;     // kBitmapWords words once it is a bitmap
+
+        explicit Container(uint16_t key = 0) : key(key) {}
+        bool isBitmap() const { return !bits.empty(); }
+        bool contains(uint16_t value) const;
+        void add(uint16_t value);
+        void toBitmap();
+        void toArray();
+    };
+
+    std::vector<Container> containers;  // sorted by key
+
+    static Container difference(const Container& a, const Container& b);
+};
+
+template <typename Visitor>
+void ParcelBitmap::forEach(Visitor&& visit) const {
+    for (const Container& container : containers) {
+        const uint32_t high = static_cast<uint32_t>(container.key) << 16;
+        if (!container.isBitmap()) {
+            for (uint16_t value : container.values) {
+                visit(high | value);
+            }
+            continue;
+        }
+        for (size_t w = 0; w < kBitmapWords; w++) {
+            for (uint64_t word = container.bits[w]; word != 0; word &= word - 1) {
+                visit(high | static_cast<uint32_t>(w * 64 + std::countr_zero(word)));
+            }
+        }
+    }
+}
+
+#endif // PARCEL_BITMAP_H
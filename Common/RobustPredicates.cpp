@@ -0,0 +1,99 @@
+#include "RobustPredicates.h"
+#include <cmath>
+
+namespace RobustPredicates {
+
+namespace {
+
+// Half an ulp of 1.0, and Shewchuk's bound for the plain determinant
+constexpr double kEpsilon = 0x1p-53;
+constexpr double kOrientErrorBound = (3.0 + 16.0 * kEpsilon) * kEpsilon;
+
+// a * b == product + error exactly
+inline void twoProduct(double a, double b, double& product, double& error) {
+    product = a * b;
+    error = std::fma(a, b, -product);
+}
+
+// a + b == sum + error exactly
+inline void twoSum(double a, double b, double& sum, double& error) {
+    sum = a + b;
+    double bVirtual = sum - a;
+    double aVirtual = sum - bVirtual;
+    error = (a - aVirtual) + (b - bVirtual);
+}
+
+// Add b to a nonoverlapping expansion sorted by increasing magnitude
+// (Shewchuk's GROW-EXPANSION with zero elimination). Returns the new length.
+int growExpansion(double* e, int length, double b) {
+    double q = b;
+    int out = 0;
+    for (int i = 0; i < length; i++) {
+        double sum, error;
+        twoSum(q, e[i], sum, error);
+        q = sum;
+        if (error != 0.0) {
+            e[out++] = error;
+        }
+    }
+    if (q != 0.0 || out == 0) {
+        e[out++] = q;
+    }
+    return out;
+}
+
+double orient2dExact(double ax, double ay, double bx, double by, double cx, double cy) {
+    // (ax-cx)(by-cy) - (ay-cy)(bx-cx) expanded; the cx*cy terms cancel
+    const double terms[6][2] = {
+        {ax, by}, {-ax, cy}, {-cx, by}, {-ay, bx}, {ay, cx}, {cy, bx},
+    };
+    double expansion[12];
+    int length = 0;
+    for (const auto& term : terms) {
+        double product, error;
+        twoProduct(term[0], term[1], product, error);
+        length = growExpansion(expansion, length, error);
+        length = growExpansion(expansion, length, product);
+    }
+    // The most significant component carries the sign of the whole sum
+    return expansion[length - 1];
+}
+
+} // namespace
+
+double orient2d(double ax, double ay, double bx, double by, double cx, double cy) {
+    const double detLeft = (ax - cx) * (by - cy);
+    const double detRight = (ay - cy) * (bx - cx);
+    const double det = detLeft - detRight;
+    const double detSum = std::fabs(detLeft) + std::fabs(detRight);
+    if (std::fabs(det) >= kOrientErrorBound * detSum) {
+        return det;
+    }
+    return orient2dExact(ax, ay, bx, by, cx, cy);
+}
+
+// c is known to be collinear with a-b
+static bool withinBox(double ax, double ay, double bx, double by, double cx, double cy) {
+    return std::fmin(ax, bx) <= cx && cx <= std::fmax(ax, bx) &&
+           std::fmin(ay, by) <= cy && cy <= std::fmax(ay, by);
+}
+
+SegmentContact segmentContact(double ax, double ay, double bx, double by,
+                              double cx, double cy, double dx, double dy) {
+    const int o1 = orientation(ax, ay, bx, by, cx, cy);
+    const int o2 = orientation(ax, ay, bx, by, dx, dy);
+    const int o3 = orientation(cx, cy, dx, dy, ax, ay);
+    const int o4 = orientation(cx, cy, dx, dy, bx, by);
+    if (o1 * o2 < 0 && o3 * o4 < 0) {
+        return SegmentContact::Cross;
+    }
+    if ((o1 == 0 && withinBox(ax, ay, bx, by, cx, cy)) ||
+        (o2 == 0 && withinBox(ax, ay, bx, by, dx, dy)) ||
+        (o3 == 0 && withinBox(cx, cy, dx, dy, ax, ay)) ||
+        (o4 == 0 && withinBox(cx, cy, dx, dy, bx, by))) {
+        return SegmentContact::Touch;
+    }
+    return SegmentContact::None;
+}
+
+} // namespace RobustPredicates
@@ -0,0 +1,32 @@
+#ifndef ROBUST_PREDICATES_H
+#define ROBUST_PREDICATES_H
+
+// Orientation test with an exact sign, after Shewchuk's adaptive predicates:
+// a floating-point estimate is returned when its error bound proves the sign,
+// otherwise the determinant is evaluated exactly as a floating-point expansion.
+namespace RobustPredicates {
+
+// Twice the signed area of triangle abc: > 0 if c lies left of a->b
+// (counter-clockwise), < 0 if right, exactly 0 if the points are collinear.
+// Only the sign is exact; the magnitude is an approximation.
+double orient2d(double ax, double ay, double bx, double by, double cx, double cy);
+
+// Sign of orient2d as -1, 0 or 1
+inline int orientation(double ax, double ay, double bx, double by, double cx, double cy) {
+    double det = orient2d(ax, ay, bx, by, cx, cy);
+    return (det > 0.0) - (det < 0.0);
+}
+
+enum class SegmentContact {
+    None,
+    Touch,      // share at least one point, but neither crosses the other
+    Cross,      // proper crossing at a single interior point of both
+};
+
+// Exact relation of closed segments a-b and c-d
+SegmentContact segmentContact(double ax, double ay, double bx, double by,
+                              double cx, double cy, double dx, double dy);
+
+} // namespace RobustPredicates
+
+#endif // ROBUST_PREDICATES_H
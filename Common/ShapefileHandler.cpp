@@ -1,9 +1,11 @@
 #include "ShapefileHandler.h"
+#include "Logger.h"
 #include <iostream>
+#include <limits>
 #include <ogrsf_frmts.h>
 
-ShapefileHandler::ShapefileHandler(const std::string& path)
-    : shapefilePath(path) {
+ShapefileHandler::ShapefileHandler(const std::string& path, const ShapefileFilter& filter)
+    : shapefilePath(path), filter(filter) {
     loadPolygons();
 }
 
@@ -18,46 +20,143 @@ bool ShapefileHandler::loadPolygons() {
     // Open the shapefile
     GDALDataset* poDS = (GDALDataset*) GDALOpenEx(shapefilePath.c_str(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr);
     if (poDS == nullptr) {
-        std::cerr << "Failed to open shapefile: " << shapefilePath << std::endl;
+        LOG_ERROR("Failed to open shapefile: " << shapefilePath);
         return false;
     }
     // Assume the first layer contains the polygons
     OGRLayer* poLayer = poDS->GetLayer(0);
     if (poLayer == nullptr) {
-        std::cerr << "Failed to get layer from shapefile: " << shapefilePath << std::endl;
+        LOG_ERROR("Failed to get layer from shapefile: " << shapefilePath);
         GDALClose(poDS);
         return false;
     }
+
+    if (!filter.where.empty()) {
+        // Evaluate the predicate on the .dbf alone, then fetch only the matches.
+        // The shapefile driver answers "FID IN (...)" from the .shx offsets.
+        std::vector<GIntBig> fids;
+        if (!collectMatchingFids(poLayer, fids)) {
+            GDALClose(poDS);
+            return false;
+        }
+        if (fids.empty()) {
+            GDALClose(poDS);
+            LOG_INFO("No features of " << shapefilePath << " match: " << filter.where);
+            return true;
+        }
+        std::string fidFilter = "FID IN (";
+        for (size_t i = 0; i < fids.size(); i++) {
+            fidFilter += (i > 0 ? "," : "") + std::to_string(fids[i]);
+        }
+        fidFilter += ")";
+        poLayer->SetAttributeFilter(fidFilter.c_str());
+    }
+
+    if (filter.hasExtent) {
+        // Candidates come from the .sbn/.qix index when one is present
+        if (!poLayer->TestCapability(OLCFastSpatialFilter)) {
+            LOG_WARN("No spatial index next to " << shapefilePath << ", extent filter reads every shape");
+        }
+        poLayer->SetSpatialFilterRect(filter.extent.MinX, filter.extent.MinY,
+                                      filter.extent.MaxX, filter.extent.MaxY);
+    }
     
     // Iterate through all features in the layer
     OGRFeature* poFeature;
     poLayer->ResetReading();
     while ((poFeature = poLayer->GetNextFeature()) != nullptr) {
-        OGRGeometry* poGeometry = poFeature->GetGeometryRef();
-        if (poGeometry != nullptr) {
-            OGRwkbGeometryType geoType = wkbFlatten(poGeometry->getGeometryType());
-            
-            if (geoType == wkbPolygon) {
-                OGRPolygon* poPolygon = poGeometry->toPolygon();
-                polygons.push_back(*poPolygon);
-            }
-            else if (geoType == wkbMultiPolygon) {
-                OGRMultiPolygon* poMultiPolygon = poGeometry->toMultiPolygon();
-                for (int j = 0; j < poMultiPolygon->getNumGeometries(); j++) {
-                    OGRPolygon* poPolygon = (OGRPolygon*)poMultiPolygon->getGeometryRef(j);
-                    polygons.push_back(*poPolygon);
-                }
-            }
-        }
+        addFeatureGeometry(poFeature);
         OGRFeature::DestroyFeature(poFeature);
     }
     
     GDALClose(poDS);
+    if (filter.isEmpty()) {
+        LOG_INFO("Loaded " << polygons.size() << " polygons from " << shapefilePath);
+    } else {
+        LOG_INFO("Loaded " << polygons.size() << " polygons from " << shapefilePath << " after filtering"
+                 << (filter.where.empty() ? "" : " where " + filter.where)
+                 << (filter.hasExtent ? " within extent" : ""));
+    }
     return true;
 }
 
-const std::vector<OGRPolygon>& ShapefileHandler::getPolygons() const {
-    return polygons;
+bool ShapefileHandler::collectMatchingFids(OGRLayer* poLayer, std::vector<GIntBig>& fids) const {
+    // Skip the .shp entirely while the attribute predicate runs
+    const char* ignored[] = {"OGR_GEOMETRY", nullptr};
+    poLayer->SetIgnoredFields(ignored);
+    if (poLayer->SetAttributeFilter(filter.where.c_str()) != OGRERR_NONE) {
+        LOG_ERROR("Invalid attribute filter for " << shapefilePath << ": " << filter.where);
+        poLayer->SetIgnoredFields(nullptr);
+        return false;
+    }
+
+    OGRFeature* poFeature;
+    poLayer->ResetReading();
+    while ((poFeature = poLayer->GetNextFeature()) != nullptr) {
+        fids.push_back(poFeature->GetFID());
+        OGRFeature::DestroyFeature(poFeature);
+    }
+
+    poLayer->SetAttributeFilter(nullptr);
+    poLayer->SetIgnoredFields(nullptr);
+    return true;
+}
+
+void ShapefileHandler::addFeatureGeometry(OGRFeature* poFeature) {
+    if (poFeature->GetGeometryRef() == nullptr) {
+        return;
+    }
+
+    const GIntBig fid = poFeature->GetFID();
+    if (fid < 0 || fid >= std::numeric_limits<int>::max() / kMaxPartsPerFeature) {
+        LOG_WARN("Feature " << fid << " of " << shapefilePath << " has no usable polygon id, skipped");
+        return;
+    }
+    const int baseId = static_cast<int>(fid) * kMaxPartsPerFeature;
+
+    // The feature gives up its geometry; other types are freed with it here
+    std::unique_ptr<OGRGeometry> poGeometry(poFeature->StealGeometry());
+    OGRwkbGeometryType geoType = wkbFlatten(poGeometry->getGeometryType());
+    if (geoType == wkbPolygon) {
+        polygons.emplace_back(poGeometry.release()->toPolygon());
+        polygonIds.push_back(baseId);
+    }
+    else if (geoType == wkbMultiPolygon) {
+        OGRMultiPolygon* poMultiPolygon = poGeometry->toMultiPolygon();
+        int numParts = poMultiPolygon->getNumGeometries();
+        if (numParts > kMaxPartsPerFeature) {
+            LOG_WARN("Feature " << fid << " has " << numParts << " parts, only the first "
+                     << kMaxPartsPerFeature << " are loaded");
+            numParts = kMaxPartsPerFeature;
+        }
+        // Parts are detached last first, without being deleted; the ones
+        // over the limit are freed with the collection
+        const size_t first = polygons.size();
+        polygons.resize(first + numParts);
+        for (int j = numParts - 1; j >= 0; j--) {
+            polygons[first + j].reset((OGRPolygon*)poMultiPolygon->getGeometryRef(j));
+            poMultiPolygon->removeGeometry(j, FALSE);
+        }
+        for (int j = 0; j < numParts; j++) {
+            polygonIds.push_back(baseId + j);
+        }
+    }
+}
+
+const OGRPolygon& ShapefileHandler::getPolygon(size_t index) const {
+    return *polygons[index];
+}
+
+std::vector<std::unique_ptr<OGRPolygon>> ShapefileHandler::takePolygons() {
+    return std::move(polygons);
+}
+
+std::vector<int> ShapefileHandler::takePolygonIds() {
+    return std::move(polygonIds);
+}
+
+const std::vector<int>& ShapefileHandler::getPolygonIds() const {
+    return polygonIds;
 }
 
 size_t ShapefileHandler::getPolygonCount() const {
@@ -71,7 +170,7 @@ void ShapefileHandler::printPolygonInfo(size_t index) const {
         return;
     }
     
-    const OGRPolygon& polygon = polygons[index];
+    const OGRPolygon& polygon = *polygons[index];
     const OGRLinearRing* poRing = polygon.getExteriorRing();
     
     if (poRing == nullptr) {
@@ -93,4 +192,60 @@ void ShapefileHandler::printPolygonInfo(size_t index) const {
 
 void ShapefileHandler::clear() {
     polygons.clear();
+    polygonIds.clear();
+}
+
+long long ShapefileHandler::countFeatures(const std::string& path) {
+    GDALAllRegister();
+    GDALDataset* poDS = (GDALDataset*) GDALOpenEx(path.c_str(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr);
+    if (poDS == nullptr) {
+        LOG_ERROR("Failed to open shapefile: " << path);
+        return -1;
+    }
+    OGRLayer* poLayer = poDS->GetLayer(0);
+    long long count = poLayer == nullptr ? -1 : static_cast<long long>(poLayer->GetFeatureCount());
+    GDALClose(poDS);
+    return count;
+}
+
+bool ShapefileHandler::readFeatureRange(const std::string& path, long long firstFid, long long endFid,
+                                        const std::string& attributeField,
+                                        const std::function<bool(long long, const char*, const OGRGeometry&)>& visit) {
+    GDALAllRegister();
+    GDALDataset* poDS = (GDALDataset*) GDALOpenEx(path.c_str(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr);
+    if (poDS == nullptr) {
+        LOG_ERROR("Failed to open shapefile: " << path);
+        return false;
+    }
+    OGRLayer* poLayer = poDS->GetLayer(0);
+    if (poLayer == nullptr) {
+        LOG_ERROR("Failed to get layer from shapefile: " << path);
+        GDALClose(poDS);
+        return false;
+    }
+    int fieldIndex = -1;
+    if (!attributeField.empty()) {
+        fieldIndex = poLayer->GetLayerDefn()->GetFieldIndex(attributeField.c_str());
+        if (fieldIndex < 0) {
+            LOG_WARN("Field " << attributeField << " not found in " << path);
+        }
+    }
+
+    for (long long fid = firstFid; fid < endFid; fid++) {
+        OGRFeature* poFeature = poLayer->GetFeature(fid);
+        if (poFeature == nullptr) {
+            continue;
+        }
+        const OGRGeometry* poGeometry = poFeature->GetGeometryRef();
+        const char* attribute = (fieldIndex >= 0 && poFeature->IsFieldSetAndNotNull(fieldIndex))
+                                    ? poFeature->GetFieldAsString(fieldIndex) : nullptr;
+        bool keepGoing = poGeometry == nullptr || visit(fid, attribute, *poGeometry);
+        OGRFeature::DestroyFeature(poFeature);
+        if (!keepGoing) {
+            break;
+        }
+    }
+
+    GDALClose(poDS);
+    return true;
 }
@@ -1,24 +1,55 @@
 #ifndef SHAPEFILE_HANDLER_H
 #define SHAPEFILE_HANDLER_H
 
+#include <functional>
+#include <memory>
 #include <vector>
 #include <string>
 #include <utility>
 #include <ogrsf_frmts.h>
+
+// Feature selection pushed down to OGR. Features rejected by the filter are
+// never turned into geometries.
+struct ShapefileFilter {
+    std::string where;          // OGR SQL attribute predicate, e.g. "YEAR_ >= '2020'"
+    bool hasExtent = false;     // only features whose envelope meets extent
+    OGREnvelope extent;
+
+    bool isEmpty() const { return where.empty() && !hasExtent; }
+};
+
+// Loaded polygons are taken over from the OGR features (never copied) and
+// owned through unique_ptr; callers read them in place or take them.
 class ShapefileHandler {
 private:
-    std::vector<OGRPolygon> polygons;
+    std::vector<std::unique_ptr<OGRPolygon>> polygons;
+    std::vector<int> polygonIds;
     std::string shapefilePath;
+    ShapefileFilter filter;
+
+    bool collectMatchingFids(OGRLayer* layer, std::vector<GIntBig>& fids) const;
+    void addFeatureGeometry(OGRFeature* feature);
 
 public:
-    ShapefileHandler(const std::string& path);
+    // Parts of a multipolygon feature get consecutive ids below this stride
+    static constexpr int kMaxPartsPerFeature = 1000;
+
+    ShapefileHandler(const std::string& path, const ShapefileFilter& filter = ShapefileFilter());
     ~ShapefileHandler();
     
     // Load all polygons from shapefile
     bool loadPolygons();
     
-    // Get all loaded polygons
-    const std::vector<OGRPolygon>& getPolygons() const;
+    // Loaded polygon by index, valid until clear() or takePolygons()
+    const OGRPolygon& getPolygon(size_t index) const;
+
+    // Move the loaded polygons / their ids out of the handler
+    std::vector<std::unique_ptr<OGRPolygon>> takePolygons();
+    std::vector<int> takePolygonIds();
+
+    // Stable id of each loaded polygon (FID * kMaxPartsPerFeature + part),
+    // independent of the filter, used as the key of the validity tables
+    const std::vector<int>& getPolygonIds() const;
     
     // Get polygon count
     size_t getPolygonCount() const;
@@ -28,6 +59,18 @@ public:
     
     // Clear all loaded polygons
     void clear();
+
+    // Number of features in the first layer, -1 if the file cannot be opened
+    static long long countFeatures(const std::string& path);
+
+    // Stream features [firstFid, endFid) of the first layer without keeping
+    // them. Each feature is fetched by FID through the .shx offsets, so
+    // several threads can read disjoint ranges, each with its own dataset.
+    // visit(fid, attribute, geometry) gets the value of attributeField
+    // (nullptr if unset or no field given) and may return false to stop.
+    static bool readFeatureRange(const std::string& path, long long firstFid, long long endFid,
+                                 const std::string& attributeField,
+                                 const std::function<bool(long long, const char*, const OGRGeometry&)>& visit);
 };
 
 #endif // SHAPEFILE_HANDLER_H
@@ -0,0 +1,118 @@
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <cmath>
+
+SpatialIndex::SpatialIndex() : numLeaves(0) {
+}
+
+size_t SpatialIndex::size() const {
+    return entries.size();
+}
+
+size_t SpatialIndex::getMemoryUsage() const {
+    return entries.capacity() * sizeof(Entry) + nodes.capacity() * sizeof(Node);
+}
+
+void SpatialIndex::query(const OGREnvelope& box, std::vector<uint32_t>& ids) const {
+    query(box, [&ids](uint32_t id) { ids.push_back(id); });
+}
+
+std::vector<OGREnvelope> SpatialIndex::coverEnvelopes(std::vector<OGREnvelope> envelopes, size_t maxBoxes) {
+    if (maxBoxes == 0 || envelopes.size() <= maxBoxes) {
+        return envelopes;
+    }
+
+    // STR again: slabCount slices by centre x, at most perSlab groups per slice
+    auto centreX = [](const OGREnvelope& e) { return e.MinX + e.MaxX; };
+    auto centreY = [](const OGREnvelope& e) { return e.MinY + e.MaxY; };
+    std::sort(envelopes.begin(), envelopes.end(),
+              [&](const OGREnvelope& a, const OGREnvelope& b) { return centreX(a) < centreX(b); });
+
+    const size_t slabCount = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(maxBoxes))));
+    const size_t perSlab = std::max<size_t>(1, maxBoxes / slabCount);
+    const size_t slabSize = (envelopes.size() + slabCount - 1) / slabCount;
+    const size_t groupSize = (slabSize + perSlab - 1) / perSlab;
+
+    std::vector<OGREnvelope> boxes;
+    for (size_t slab = 0; slab < envelopes.size(); slab += slabSize) {
+        const size_t slabEnd = std::min(envelopes.size(), slab + slabSize);
+        std::sort(envelopes.begin() + slab, envelopes.begin() + slabEnd,
+                  [&](const OGREnvelope& a, const OGREnvelope& b) { return centreY(a) < centreY(b); });
+        for (size_t start = slab; start < slabEnd; start += groupSize) {
+            OGREnvelope box = envelopes[start];
+            for (size_t i = start; i < std::min(slabEnd, start + groupSize); i++) {
+                box.MinX = std::min(box.MinX, envelopes[i].MinX);
+                box.MinY = std::min(box.MinY, envelopes[i].MinY);
+                box.MaxX = std::max(box.MaxX, envelopes[i].MaxX);
+                box.MaxY = std::max(box.MaxY, envelopes[i].MaxY);
+            }
+            boxes.push_back(box);
+        }
+    }
+    return boxes;
+}
+
+void SpatialIndex::build(const std::vector<OGREnvelope>& envelopes) {
+    entries.clear();
+    nodes.clear();
+    numLeaves = 0;
+
+    entries.reserve(envelopes.size());
+    for (size_t i = 0; i < envelopes.size(); i++) {
+        const OGREnvelope& env = envelopes[i];
+        entries.push_back(Entry{env.MinX, env.MinY, env.MaxX, env.MaxY, static_cast<uint32_t>(i)});
+    }
+    if (entries.empty()) {
+        return;
+    }
+
+    // Sort-Tile-Recursive: vertical slices by centre x, each slice by centre y
+    auto centreX = [](const Entry& e) { return e.minX + e.maxX; };
+    auto centreY = [](const Entry& e) { return e.minY + e.maxY; };
+    std::sort(entries.begin(), entries.end(),
+              [&](const Entry& a, const Entry& b) { return centreX(a) < centreX(b); });
+
+    const size_t leafCount = (entries.size() + kNodeCapacity - 1) / kNodeCapacity;
+    const size_t sliceCount = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(leafCount))));
+    const size_t sliceSize = sliceCount * kNodeCapacity;
+    for (size_t start = 0; start < entries.size(); start += sliceSize) {
+        auto end = entries.begin() + std::min(entries.size(), start + sliceSize);
+        std::sort(entries.begin() + start, end,
+                  [&](const Entry& a, const Entry& b) { return centreY(a) < centreY(b); });
+    }
+
+    // Leaves over consecutive entries
+    for (size_t start = 0; start < entries.size(); start += kNodeCapacity) {
+        Node node{entries[start].minX, entries[start].minY, entries[start].maxX, entries[start].maxY,
+                  static_cast<uint32_t>(start), 0};
+        for (size_t i = start; i < std::min(entries.size(), start + kNodeCapacity); i++) {
+            node.minX = std::min(node.minX, entries[i].minX);
+            node.minY = std::min(node.minY, entries[i].minY);
+            node.maxX = std::max(node.maxX, entries[i].maxX);
+            node.maxY = std::max(node.maxY, entries[i].maxY);
+            node.count++;
+        }
+        nodes.push_back(node);
+    }
+    numLeaves = static_cast<uint32_t>(nodes.size());
+
+    // Upper levels over consecutive nodes of the level below, until one root
+    size_t levelStart = 0;
+    size_t levelEnd = nodes.size();
+    while (levelEnd - levelStart > 1) {
+        for (size_t start = levelStart; start < levelEnd; start += kNodeCapacity) {
+            Node node{nodes[start].minX, nodes[start].minY, nodes[start].maxX, nodes[start].maxY,
+                      static_cast<uint32_t>(start), 0};
+            for (size_t i = start; i < std::min(levelEnd, start + kNodeCapacity); i++) {
+                node.minX = std::min(node.minX, nodes[i].minX);
+                node.minY = std::min(node.minY, nodes[i].minY);
+                node.maxX = std::max(node.maxX, nodes[i].maxX);
+                node.maxY = std::max(node.maxY, nodes[i].maxY);
+                node.count++;
+            }
+            nodes.push_back(node);
+        }
+        levelStart = levelEnd;
+        levelEnd = nodes.size();
+    }
+}
@@ -0,0 +1,157 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <utility>
+#include <vector>
+#include <ogrsf_frmts.h>
+
+// Static R-tree over envelopes, bulk loaded with Sort-Tile-Recursive packing.
+// Built once after loading; queries are read-only and safe from any thread.
+class SpatialIndex {
+public:
+    static constexpr uint32_t kNodeCapacity = 16;
+
+    SpatialIndex();
+
+    // Index envelopes[i] under id i. Replaces any previous contents.
+    void build(const std::vector<OGREnvelope>& envelopes);
+
+    // Call visit(id) for every entry whose envelope intersects box.
+    template <typename Visitor>
+    void query(const OGREnvelope& box, Visitor&& visit) const;
+
+    void query(const OGREnvelope& box, std::vector<uint32_t>& ids) const;
+
+    // k nearest entries to box, closest first, as (distance, id) in out.
+    // Best-first traversal: nodes and entries are expanded in order of their
+    // envelope distance, and distance(id) is only called for entries whose
+    // envelope is closer than the current k-th result. distance(id) must be
+    // at least the envelope distance; return infinity to skip an entry.
+    // Entries further than maxDistance are not reported.
+    template <typename Distance>
+    void nearest(const OGREnvelope& box, size_t k, double maxDistance, Distance&& distance,
+                 std::vector<std::pair<double, uint32_t>>& out) const;
+
+    // Euclidean gap between two boxes (0 when they overlap)
+    static double boxDistance(const OGREnvelope& box, double minX, double minY, double maxX, double maxY) {
+        const double dx = std::max(0.0, std::max(minX - box.MaxX, box.MinX - maxX));
+        const double dy = std::max(0.0, std::max(minY - box.MaxY, box.MinY - maxY));
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    size_t size() const;
+    size_t getMemoryUsage() const;
+
+    // Cover the envelopes with at most maxBoxes boxes, grouping neighbours
+    // the same way the tree packs its nodes. Every input lies in some output.
+    static std::vector<OGREnvelope> coverEnvelopes(std::vector<OGREnvelope> envelopes, size_t maxBoxes);
+
+private:
+    struct Node {
+        double minX, minY, maxX, maxY;
+        uint32_t first;     // first child node, or first entry for leaves
+        uint32_t count;
+    };
+
+    struct Entry {
+        double minX, minY, maxX, maxY;
+        uint32_t id;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Node> nodes;        // leaves first, root last
+    uint32_t numLeaves;
+
+    static bool overlaps(const OGREnvelope& box, double minX, double minY, double maxX, double maxY) {
+        return minX <= box.MaxX && maxX >= box.MinX && minY <= box.MaxY && maxY >= box.MinY;
+    }
+};
+
+template <typename Visitor>
+void SpatialIndex::query(const OGREnvelope& box, Visitor&& visit) const {
+    if (nodes.empty()) {
+        return;
+    }
+
+    // Depth is log16(n), so 16 slots per level is plenty
+    uint32_t stack[256];
+    int top = 0;
+    stack[top++] = static_cast<uint32_t>(nodes.size() - 1);
+    while (top > 0) {
+        const uint32_t index = stack[--top];
+        const Node& node = nodes[index];
+        if (!overlaps(box, node.minX, node.minY, node.maxX, node.maxY)) {
+            continue;
+        }
+        if (index < numLeaves) {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                const Entry& e = entries[i];
+                if (overlaps(box, e.minX, e.minY, e.maxX, e.maxY)) {
+                    visit(e.id);
+                }
+            }
+        } else {
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                stack[top++] = i;
+            }
+        }
+    }
+}
+
+template <typename Distance>
+void SpatialIndex::nearest(const OGREnvelope& box, size_t k, double maxDistance, Distance&& distance,
+                           std::vector<std::pair<double, uint32_t>>& out) const {
+    out.clear();
+    if (nodes.empty() || k == 0) {
+        return;
+    }
+
+    // Queue items: tree nodes, entries keyed by envelope distance, and
+    // entries keyed by exact distance. An exact item at the top is final,
+    // since everything still queued is at least as far away.
+    enum Kind : uint32_t { NodeItem, EntryItem, ExactItem };
+    struct Item {
+        double distance;
+        Kind kind;
+        uint32_t index;
+        bool operator>(const Item& other) const { return distance > other.distance; }
+    };
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+
+    const uint32_t root = static_cast<uint32_t>(nodes.size() - 1);
+    const Node& rootNode = nodes[root];
+    queue.push(Item{boxDistance(box, rootNode.minX, rootNode.minY, rootNode.maxX, rootNode.maxY), NodeItem, root});
+    while (!queue.empty() && out.size() < k) {
+        const Item item = queue.top();
+        queue.pop();
+        if (item.distance > maxDistance) {
+            break;
+        }
+        if (item.kind == ExactItem) {
+            out.emplace_back(item.distance, entries[item.index].id);
+        } else if (item.kind == EntryItem) {
+            const double exact = distance(entries[item.index].id);
+            if (exact <= maxDistance) {
+                queue.push(Item{exact, ExactItem, item.index});
+            }
+        } else {
+            const Node& node = nodes[item.index];
+            const bool leaf = item.index < numLeaves;
+            for (uint32_t i = node.first; i < node.first + node.count; i++) {
+                if (leaf) {
+                    const Entry& e = entries[i];
+                    queue.push(Item{boxDistance(box, e.minX, e.minY, e.maxX, e.maxY), EntryItem, i});
+                } else {
+                    const Node& child = nodes[i];
+                    queue.push(Item{boxDistance(box, child.minX, child.minY, child.maxX, child.maxY), NodeItem, i});
+                }
+            }
+        }
+    }
+}
+
+#endif // SPATIAL_INDEX_H
@@ -0,0 +1,129 @@
+#include "HazardClient.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace HazardProtocol;
+
+static bool readFully(int fd, void* buffer, size_t size) {
+    char* p = static_cast<char*>(buffer);
+    while (size > 0) {
+        ssize_t n = ::read(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const void* buffer, size_t size) {
+    const char* p = static_cast<const char*>(buffer);
+    while (size > 0) {
+        ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+HazardClient::HazardClient(const std::string& socketPath) : fd(-1), socketPath(socketPath) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << socketPath << std::endl;
+        return;
+    }
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "Cannot connect to " << socketPath << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        fd = -1;
+    }
+}
+
+HazardClient::~HazardClient() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool HazardClient::isConnected() const {
+    return fd >= 0;
+}
+
+bool HazardClient::roundTrip(RequestType type, const void* payload, uint32_t payloadSize,
+                             HazardResponse& response) {
+    if (fd < 0) {
+        return false;
+    }
+
+    std::vector<char> request(sizeof(RequestHeader) + payloadSize);
+    RequestHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = kRequestMagic;
+    header.type = type;
+    header.payloadSize = payloadSize;
+    std::memcpy(request.data(), &header, sizeof(header));
+    if (payloadSize > 0) {
+        std::memcpy(request.data() + sizeof(header), payload, payloadSize);
+    }
+    // A daemon at its connection limit answers Busy and hangs up, possibly
+    // before the request is written; its reply is still there to read
+    bool written = writeFully(fd, request.data(), request.size());
+
+    ResponseHeader reply;
+    if (!readFully(fd, &reply, sizeof(reply)) || reply.magic != kResponseMagic) {
+        return false;
+    }
+    if (!written && reply.status != Status::Busy) {
+        return false;
+    }
+    response.status = reply.status;
+    response.value = reply.value;
+    response.hits.resize(reply.count);
+    return reply.count == 0 || readFully(fd, response.hits.data(), reply.count * sizeof(HazardHit));
+}
+
+bool HazardClient::queryPoint(double x, double y, HazardResponse& response) {
+    double xy[2] = {x, y};
+    return roundTrip(RequestType::Point, xy, sizeof(xy), response);
+}
+
+bool HazardClient::queryParcel(int parcelId, HazardResponse& response) {
+    int32_t id = parcelId;
+    return roundTrip(RequestType::Parcel, &id, sizeof(id), response);
+}
+
+bool HazardClient::queryPolygon(const std::vector<std::pair<double, double>>& ring, HazardResponse& response) {
+    uint32_t numPoints = static_cast<uint32_t>(ring.size());
+    std::vector<char> payload(sizeof(numPoints) + 2 * sizeof(double) * ring.size());
+    std::memcpy(payload.data(), &numPoints, sizeof(numPoints));
+    char* p = payload.data() + sizeof(numPoints);
+    for (const auto& point : ring) {
+        std::memcpy(p, &point.first, sizeof(double));
+        std::memcpy(p + sizeof(double), &point.second, sizeof(double));
+        p += 2 * sizeof(double);
+    }
+    return roundTrip(RequestType::Polygon, payload.data(), static_cast<uint32_t>(payload.size()), response);
+}
+
+bool HazardClient::requestReload(HazardResponse& response) {
+    return roundTrip(RequestType::Reload, nullptr, 0, response);
+}
@@ -0,0 +1,40 @@
+#ifndef HAZARD_CLIENT_H
+#define HAZARD_CLIENT_H
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "HazardProtocol.h"
+
+struct HazardResponse {
+    HazardProtocol::Status status = HazardProtocol::Status::BadRequest;
+    double value = 0.0;
+    std::vector<HazardProtocol::HazardHit> hits;
+};
+
+// Blocking client for the IntersectCalculation daemon socket
+class HazardClient {
+private:
+    int fd;
+    std::string socketPath;
+
+    bool roundTrip(HazardProtocol::RequestType type, const void* payload, uint32_t payloadSize,
+                   HazardResponse& response);
+
+public:
+    explicit HazardClient(const std::string& socketPath);
+    ~HazardClient();
+
+    HazardClient(const HazardClient&) = delete;
+    HazardClient& operator=(const HazardClient&) = delete;
+
+    bool isConnected() const;
+
+    // Each returns false on a transport error; response.status carries query errors
+    bool queryPoint(double x, double y, HazardResponse& response);
+    bool queryParcel(int parcelId, HazardResponse& response);
+    bool queryPolygon(const std::vector<std::pair<double, double>>& ring, HazardResponse& response);
+    bool requestReload(HazardResponse& response);
+};
+
+#endif // HAZARD_CLIENT_H
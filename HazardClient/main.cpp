@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "HazardClient.h"
+
+static const char* statusName(HazardProtocol::Status status) {
+    switch (status) {
+        case HazardProtocol::Status::Ok: return "ok";
+        case HazardProtocol::Status::NotFound: return "not found";
+        case HazardProtocol::Status::BadRequest: return "bad request";
+        case HazardProtocol::Status::Unavailable: return "unavailable";
+        case HazardProtocol::Status::Busy: return "busy";
+    }
+    return "unknown";
+}
+
+static void printUsage(const char* prog) {
+    std::cout << "Usage: " << prog << " [--socket <path>] <command>\n"
+              << "Commands:\n"
+              << "  point <x> <y>                  Fires containing the point\n"
+              << "  parcel <id>                    Burned fraction of a stored parcel\n"
+              << "  polygon <x1> <y1> <x2> <y2> ...  Burned fraction of an ad-hoc ring\n"
+              << "  reload                         Ask the daemon to rebuild its snapshot\n"
+              << "  bench-parcels <first> <last> [requests] [connections]\n"
+              << "  bench-points <minx> <miny> <maxx> <maxy> [requests] [connections]\n"
+              << "Default socket: /tmp/intersect_calculation.sock" << std::endl;
+}
+
+static int printResponse(const HazardResponse& response, bool showFraction) {
+    if (response.status != HazardProtocol::Status::Ok) {
+        std::cerr << "Query failed: " << statusName(response.status) << std::endl;
+        return 1;
+    }
+    if (showFraction) {
+        std::cout << "Burned fraction: " << std::fixed << std::setprecision(4)
+                  << response.value * 100.0 << "%" << std::endl;
+    }
+    std::cout << "Hazard polygons hit: " << response.hits.size() << std::endl;
+    for (const auto& hit : response.hits) {
+        std::cout << "  polygon " << hit.polygonId;
+        if (showFraction) {
+            std::cout << "  area " << std::fixed << std::setprecision(2) << hit.area << " m^2";
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
+
+// Latency benchmark: `connections` clients issue `requests` queries in total
+// as fast as the daemon answers, each on its own persistent connection.
+struct BenchSpec {
+    bool parcels = true;
+    long long firstId = 0;
+    long long lastId = 0;
+    double minX = 0, minY = 0, maxX = 0, maxY = 0;
+    size_t requests = 10000;
+    unsigned connections = 4;
+};
+
+static int runBench(const std::string& socketPath, const BenchSpec& spec) {
+    std::vector<std::vector<double>> latencies(spec.connections);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failures{0};
+    std::atomic<size_t> hits{0};
+
+    auto worker = [&](unsigned index) {
+        HazardClient client(socketPath);
+        if (!client.isConnected()) {
+            failures++;
+            return;
+        }
+        std::mt19937_64 rng(12345 + index);
+        std::uniform_int_distribution<long long> idDist(spec.firstId, spec.lastId);
+        std::uniform_real_distribution<double> xDist(spec.minX, spec.maxX);
+        std::uniform_real_distribution<double> yDist(spec.minY, spec.maxY);
+        auto& samples = latencies[index];
+        HazardResponse response;
+
+        while (next.fetch_add(1) < spec.requests) {
+            auto start = std::chrono::steady_clock::now();
+            bool ok = spec.parcels ? client.queryParcel(static_cast<int>(idDist(rng)), response)
+                                   : client.queryPoint(xDist(rng), yDist(rng), response);
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            if (!ok) {
+                failures++;
+                return;
+            }
+            if (!response.hits.empty()) {
+                hits++;
+            }
+            samples.push_back(std::chrono::duration<double, std::micro>(elapsed).count());
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < spec.connections; i++) {
+        threads.emplace_back(worker, i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (const auto& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    if (all.empty()) {
+        std::cerr << "No successful requests" << std::endl;
+        return 1;
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double p) {
+        return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))];
+    };
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "Requests:    " << all.size() << " over " << spec.connections << " connections"
+              << " (" << failures.load() << " failed, " << hits.load() << " with hits)\n"
+              << "Throughput:  " << all.size() / wall << " req/s\n"
+              << "Latency us:  p50 " << percentile(0.50)
+              << "  p90 " << percentile(0.90)
+              << "  p99 " << percentile(0.99)
+              << "  max " << all.back() << std::endl;
+    return failures > 0 ? 1 : 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string socketPath = "/tmp/intersect_calculation.sock";
+    int argi = 1;
+    if (argi + 1 < argc && std::string(argv[argi]) == "--socket") {
+        socketPath = argv[argi + 1];
+        argi += 2;
+    }
+    if (argi >= argc || std::string(argv[argi]) == "-h" || std::string(argv[argi]) == "--help") {
+        printUsage(argv[0]);
+        return argi >= argc ? 1 : 0;
+    }
+
+    std::string command = argv[argi++];
+    std::vector<std::string> args(argv + argi, argv + argc);
+
+    try {
+        if (command == "bench-parcels" && args.size() >= 2) {
+            BenchSpec spec;
+            spec.parcels = true;
+            spec.firstId = std::stoll(args[0]);
+            spec.lastId = std::stoll(args[1]);
+            if (args.size() > 2) spec.requests = std::stoul(args[2]);
+            if (args.size() > 3) spec.connections = std::max(1ul, std::stoul(args[3]));
+            return runBench(socketPath, spec);
+        }
+        if (command == "bench-points" && args.size() >= 4) {
+            BenchSpec spec;
+            spec.parcels = false;
+            spec.minX = std::stod(args[0]);
+            spec.minY = std::stod(args[1]);
+            spec.maxX = std::stod(args[2]);
+            spec.maxY = std::stod(args[3]);
+            if (args.size() > 4) spec.requests = std::stoul(args[4]);
+            if (args.size() > 5) spec.connections = std::max(1ul, std::stoul(args[5]));
+            return runBench(socketPath, spec);
+        }
+
+        HazardClient client(socketPath);
+        if (!client.isConnected()) {
+            return 1;
+        }
+        HazardResponse response;
+        bool ok = false;
+        bool showFraction = true;
+
+        if (command == "point" && args.size() == 2) {
+            ok = client.queryPoint(std::stod(args[0]), std::stod(args[1]), response);
+            showFraction = false;
+        } else if (command == "parcel" && args.size() == 1) {
+            ok = client.queryParcel(std::stoi(args[0]), response);
+        } else if (command == "polygon" && args.size() >= 6 && args.size() % 2 == 0) {
+            std::vector<std::pair<double, double>> ring;
+            for (size_t i = 0; i < args.size(); i += 2) {
+                ring.emplace_back(std::stod(args[i]), std::stod(args[i + 1]));
+            }
+            ok = client.queryPolygon(ring, response);
+        } else if (command == "reload" && args.empty()) {
+            if (client.requestReload(response)) {
+                std::cout << "Reload requested" << std::endl;
+                return 0;
+            }
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        if (!ok) {
+            std::cerr << "Lost connection to " << socketPath << std::endl;
+            return 1;
+        }
+        return printResponse(response, showFraction);
+    } catch (const std::exception&) {
+        std::cerr << "Invalid number in arguments" << std::endl;
+        return 1;
+    }
+}
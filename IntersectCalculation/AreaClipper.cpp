@@ -0,0 +1,418 @@
+#include "AreaClipper.h"
+#include "EdgeGrid.h"
+#include "JoinDeadline.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static double cross(double ax, double ay, double bx, double by) {
+    return ax * by - ay * bx;
+}
+
+static double ringSignedArea(const double* c, int n) {
+    double sum = 0.0;
+    for (int i = 0; i + 1 < n; ++i) {
+        sum += cross(c[2 * i] - c[0], c[2 * i + 1] - c[1],
+                     c[2 * i + 2] - c[0], c[2 * i + 3] - c[1]);
+    }
+    return sum * 0.5;
+}
+
+FlatPolygon::FlatPolygon()
+    : minX(std::numeric_limits<double>::max()), minY(std::numeric_limits<double>::max()),
+      maxX(std::numeric_limits<double>::lowest()), maxY(std::numeric_limits<double>::lowest()),
+      area(0.0) {
+    ringStarts.push_back(0);
+}
+
+FlatPolygon::FlatPolygon(const OGRPolygon& poly) : FlatPolygon() {
+    const OGRLinearRing* outer = poly.getExteriorRing();
+    if (outer == nullptr || outer->getNumPoints() < 4) {
+        return;
+    }
+
+    std::vector<double> ringCoords;
+    for (int r = -1; r < poly.getNumInteriorRings(); ++r) {
+        const OGRLinearRing* ring = (r < 0) ? outer : poly.getInteriorRing(r);
+        const int n = ring->getNumPoints();
+        ringCoords.resize(2 * static_cast<size_t>(n));
+        for (int i = 0; i < n; ++i) {
+            ringCoords[2 * i] = ring->getX(i);
+            ringCoords[2 * i + 1] = ring->getY(i);
+        }
+        addRing(ringCoords.data(), n);
+    }
+}
+
+FlatPolygon::FlatPolygon(std::span<const double> ring) : FlatPolygon() {
+    addRing(ring.data(), static_cast<int>(ring.size() / 2));
+}
+
+void FlatPolygon::addRing(const double* xy, int numPoints) {
+    if (numPoints < 4) {
+        return;
+    }
+    const int start = ringStarts.back();
+    coords.insert(coords.end(), xy, xy + 2 * static_cast<size_t>(numPoints));
+    for (int i = 0; i < numPoints; ++i) {
+        minX = std::min(minX, xy[2 * i]);
+        maxX = std::max(maxX, xy[2 * i]);
+        minY = std::min(minY, xy[2 * i + 1]);
+        maxY = std::max(maxY, xy[2 * i + 1]);
+    }
+    ringStarts.push_back(start + numPoints);
+
+    // Exterior is traversed counterclockwise and holes clockwise, so the
+    // interior always lies to the left of a directed edge.
+    const double signedArea = ringSignedArea(xy, numPoints);
+    const bool isOuter = (start == 0);
+    const bool ccw = signedArea >= 0.0;
+    ringDirs.push_back((ccw == isOuter) ? 1 : -1);
+    area += isOuter ? std::fabs(signedArea) : -std::fabs(signedArea);
+}
+
+void FlatPolygon::clear() {
+    coords.clear();
+    ringStarts.assign(1, 0);
+    ringDirs.clear();
+    minX = minY = std::numeric_limits<double>::max();
+    maxX = maxY = std::numeric_limits<double>::lowest();
+    area = 0.0;
+}
+
+int FlatPolygon::getNumRings() const {
+    return static_cast<int>(ringStarts.size()) - 1;
+}
+
+FlatRing FlatPolygon::getRing(int index) const {
+    const int start = ringStarts[index];
+    return FlatRing{coords.data() + 2 * static_cast<size_t>(start), ringStarts[index + 1] - start};
+}
+
+int FlatPolygon::getRingDirection(int index) const {
+    return ringDirs[index];
+}
+
+int FlatPolygon::getNumPoints() const {
+    return ringStarts.back();
+}
+
+bool FlatPolygon::isEmpty() const {
+    return getNumRings() == 0;
+}
+
+double FlatPolygon::getArea() const {
+    return std::max(0.0, area);
+}
+
+OGREnvelope FlatPolygon::getEnvelope() const {
+    OGREnvelope env;
+    env.MinX = minX;
+    env.MinY = minY;
+    env.MaxX = maxX;
+    env.MaxY = maxY;
+    return env;
+}
+
+bool FlatPolygon::envelopeIntersects(const FlatPolygon& other) const {
+    if (isEmpty() || other.isEmpty()) {
+        return false;
+    }
+    return minX <= other.maxX && maxX >= other.minX &&
+           minY <= other.maxY && maxY >= other.minY;
+}
+
+size_t FlatPolygon::getMemoryUsage() const {
+    return sizeof(FlatPolygon) + coords.capacity() * sizeof(double) +
+           ringStarts.capacity() * sizeof(int) + ringDirs.capacity();
+}
+
+bool AreaClipper::containsPoint(const FlatPolygon& poly, double x, double y, const EdgeGrid* grid) {
+    if (poly.isEmpty() || x < poly.getMinX() || x > poly.getMaxX() ||
+        y < poly.getMinY() || y > poly.getMaxY()) {
+        return false;
+    }
+    const double ox = poly.getMinX();
+    const double oy = poly.getMinY();
+    const double tol = std::max(std::max(poly.getMaxX() - ox, poly.getMaxY() - oy) * 1e-10, 1e-12);
+    return locate(poly, grid, x - ox, y - oy, 1.0, 0.0, ox, oy, tol) != Location::Outside;
+}
+
+template <typename Keep>
+double AreaClipper::boundaryIntegral(const FlatPolygon& from, const EdgeGrid* fromGrid,
+                                     std::span<const Clip> splitters, const OGREnvelope& box,
+                                     double ox, double oy, double tol, std::vector<double>& splits, Keep&& keep) {
+    const double bMinX = box.MinX - ox - tol;
+    const double bMaxX = box.MaxX - ox + tol;
+    const double bMinY = box.MinY - oy - tol;
+    const double bMaxY = box.MaxY - oy + tol;
+
+    double sum = 0.0;
+    auto integrateEdge = [&](int r, int i) {
+        const FlatRing ring = from.getRing(r);
+        const bool forward = from.getRingDirection(r) > 0;
+        const int a = forward ? i : i + 1;
+        const int b = forward ? i + 1 : i;
+        const double px = ring.coords[2 * a] - ox, py = ring.coords[2 * a + 1] - oy;
+        const double qx = ring.coords[2 * b] - ox, qy = ring.coords[2 * b + 1] - oy;
+
+        // Edges outside the box around the result contribute nothing.
+        if (std::max(px, qx) < bMinX || std::min(px, qx) > bMaxX ||
+            std::max(py, qy) < bMinY || std::min(py, qy) > bMaxY) {
+            return;
+        }
+        if (JoinDeadline::passed()) {
+            return;
+        }
+
+        const double rx = qx - px, ry = qy - py;
+        const double rLen2 = rx * rx + ry * ry;
+        if (rLen2 == 0.0) {
+            return;
+        }
+        const double rLen = std::sqrt(rLen2);
+        const double eMinX = std::min(px, qx) - tol, eMaxX = std::max(px, qx) + tol;
+        const double eMinY = std::min(py, qy) - tol, eMaxY = std::max(py, qy) + tol;
+
+        // Split parameters along this edge where another boundary meets it
+        splits.clear();
+        splits.push_back(0.0);
+        auto splitAt = [&](const double* other) {
+            const double cx = other[0] - ox, cy = other[1] - oy;
+            const double dx = other[2] - ox, dy = other[3] - oy;
+            if (std::max(cx, dx) < eMinX || std::min(cx, dx) > eMaxX ||
+                std::max(cy, dy) < eMinY || std::min(cy, dy) > eMaxY) {
+                return;
+            }
+
+            const double sx = dx - cx, sy = dy - cy;
+            const double sLen = std::sqrt(sx * sx + sy * sy);
+            if (sLen == 0.0) {
+                return;
+            }
+            const double wx = cx - px, wy = cy - py;
+            const double denom = cross(rx, ry, sx, sy);
+
+            if (std::fabs(denom) > 1e-12 * rLen * sLen) {
+                const double t = cross(wx, wy, sx, sy) / denom;
+                const double u = cross(wx, wy, rx, ry) / denom;
+                const double uSlack = tol / sLen;
+                if (t > 0.0 && t < 1.0 && u >= -uSlack && u <= 1.0 + uSlack) {
+                    splits.push_back(t);
+                }
+            } else if (std::fabs(cross(rx, ry, wx, wy)) <= tol * rLen) {
+                // Collinear overlap: split at the other segment's endpoints
+                const double tc = (wx * rx + wy * ry) / rLen2;
+                const double td = ((dx - px) * rx + (dy - py) * ry) / rLen2;
+                if (tc > 0.0 && tc < 1.0) splits.push_back(tc);
+                if (td > 0.0 && td < 1.0) splits.push_back(td);
+            }
+        };
+        for (const Clip& splitter : splitters) {
+            const FlatPolygon& against = *splitter.polygon;
+            if (against.getMaxX() - ox < eMinX || against.getMinX() - ox > eMaxX ||
+                against.getMaxY() - oy < eMinY || against.getMinY() - oy > eMaxY) {
+                continue;
+            }
+            if (splitter.grid != nullptr) {
+                splitter.grid->forEachEdge(against, eMinX + ox, eMinY + oy, eMaxX + ox, eMaxY + oy, [&](int s, int j) {
+                    splitAt(against.getRing(s).coords + 2 * j);
+                });
+            } else {
+                for (int s = 0; s < against.getNumRings(); ++s) {
+                    const FlatRing other = against.getRing(s);
+                    for (int j = 0; j + 1 < other.numPoints; ++j) {
+                        splitAt(other.coords + 2 * j);
+                    }
+                }
+            }
+        }
+        splits.push_back(1.0);
+        std::sort(splits.begin() + 1, splits.end() - 1);
+
+        const double minPiece = tol / rLen;
+        for (size_t k = 0; k + 1 < splits.size(); ++k) {
+            const double t0 = splits[k];
+            const double t1 = splits[k + 1];
+            if (t1 - t0 <= minPiece) {
+                continue;
+            }
+            const double tm = 0.5 * (t0 + t1);
+            if (keep(px + tm * rx, py + tm * ry, rx, ry)) {
+                sum += cross(px + t0 * rx, py + t0 * ry, px + t1 * rx, py + t1 * ry);
+            }
+        }
+    };
+
+    if (fromGrid != nullptr) {
+        fromGrid->forEachEdge(from, bMinX + ox, bMinY + oy, bMaxX + ox, bMaxY + oy, integrateEdge);
+    } else {
+        for (int r = 0; r < from.getNumRings(); ++r) {
+            const int numPoints = from.getRing(r).numPoints;
+            for (int i = 0; i + 1 < numPoints; ++i) {
+                integrateEdge(r, i);
+            }
+        }
+    }
+    return sum;
+}
+
+double AreaClipper::intersectionArea(const FlatPolygon& subject, const FlatPolygon& clip,
+                                     const EdgeGrid* clipGrid) {
+    const Clip clips[1] = {{&clip, clipGrid}};
+    return std::min(unionIntersectionArea(subject, clips), clip.getArea());
+}
+
+double AreaClipper::unionIntersectionArea(const FlatPolygon& subject, std::span<const Clip> clips) {
+    // Only clips meeting the subject's envelope matter; the result lies in
+    // the subject's envelope clipped to the envelope of those
+    std::vector<Clip> active;
+    active.reserve(clips.size());
+    OGREnvelope box;
+    box.MinX = box.MinY = std::numeric_limits<double>::max();
+    box.MaxX = box.MaxY = std::numeric_limits<double>::lowest();
+    double extent = std::max(subject.getMaxX() - subject.getMinX(), subject.getMaxY() - subject.getMinY());
+    for (const Clip& clip : clips) {
+        const FlatPolygon& polygon = *clip.polygon;
+        if (!subject.envelopeIntersects(polygon)) {
+            continue;
+        }
+        active.push_back(clip);
+        box.MinX = std::min(box.MinX, polygon.getMinX());
+        box.MinY = std::min(box.MinY, polygon.getMinY());
+        box.MaxX = std::max(box.MaxX, polygon.getMaxX());
+        box.MaxY = std::max(box.MaxY, polygon.getMaxY());
+        extent = std::max({extent, polygon.getMaxX() - polygon.getMinX(), polygon.getMaxY() - polygon.getMinY()});
+    }
+    if (active.empty()) {
+        return 0.0;
+    }
+    box.MinX = std::max(box.MinX, subject.getMinX());
+    box.MinY = std::max(box.MinY, subject.getMinY());
+    box.MaxX = std::min(box.MaxX, subject.getMaxX());
+    box.MaxY = std::min(box.MaxY, subject.getMaxY());
+
+    // Work relative to a local origin: parcel coordinates are ~1e7 in Web
+    // Mercator, and the cross products would otherwise cancel catastrophically.
+    const double ox = box.MinX;
+    const double oy = box.MinY;
+    const double tol = std::max(extent * 1e-10, 1e-12);
+
+    std::vector<double> splits;
+    splits.reserve(16);
+
+    // Subject edges bound the result where some clip covers their interior
+    // side: inside a clip, or on a clip edge running the same way
+    double twiceArea = boundaryIntegral(subject, nullptr, active, box, ox, oy, tol, splits,
+        [&](double px, double py, double dx, double dy) {
+            for (const Clip& clip : active) {
+                const Location loc = locate(*clip.polygon, clip.grid, px, py, dx, dy, ox, oy, tol);
+                if (loc == Location::Inside || loc == Location::BoundarySameDirection) {
+                    return true;
+                }
+            }
+            return false;
+        });
+
+    // Clip edges bound the result strictly inside the subject (shared
+    // subject edges were counted above) where no other clip lies on their
+    // outer side. An edge shared by clips running the same way counts once,
+    // for the first of them.
+    const Clip subjectSplitter{&subject, nullptr};
+    std::vector<Clip> splitters;
+    splitters.reserve(active.size());
+    for (size_t i = 0; i < active.size(); ++i) {
+        splitters.assign(1, subjectSplitter);
+        for (size_t j = 0; j < active.size(); ++j) {
+            if (j != i) {
+                splitters.push_back(active[j]);
+            }
+        }
+        twiceArea += boundaryIntegral(*active[i].polygon, active[i].grid, splitters, box, ox, oy, tol, splits,
+            [&](double px, double py, double dx, double dy) {
+                if (locate(subject, nullptr, px, py, dx, dy, ox, oy, tol) != Location::Inside) {
+                    return false;
+                }
+                for (size_t j = 0; j < active.size(); ++j) {
+                    if (j == i) {
+                        continue;
+                    }
+                    const Location loc = locate(*active[j].polygon, active[j].grid, px, py, dx, dy, ox, oy, tol);
+                    if (loc == Location::Inside || loc == Location::BoundaryOppositeDirection ||
+                        (loc == Location::BoundarySameDirection && j < i)) {
+                        return false;
+                    }
+                }
+                return true;
+            });
+    }
+
+    return std::clamp(0.5 * twiceArea, 0.0, subject.getArea());
+}
+
+AreaClipper::Location AreaClipper::locate(const FlatPolygon& poly, const EdgeGrid* grid, double px, double py,
+                                          double dx, double dy, double ox, double oy, double tol) {
+    bool inside = false;
+    int hitRing = -1, hitIndex = -1;
+    double hitAlong = 0.0;
+
+    // Boundary test and crossing count for one edge; true if the point is on it
+    auto testEdge = [&](int r, int i) {
+        const FlatRing ring = poly.getRing(r);
+        const double x1 = ring.coords[2 * i] - ox, y1 = ring.coords[2 * i + 1] - oy;
+        const double x2 = ring.coords[2 * i + 2] - ox, y2 = ring.coords[2 * i + 3] - oy;
+
+        // Boundary test, only for edges whose envelope reaches the point
+        if (px >= std::min(x1, x2) - tol && px <= std::max(x1, x2) + tol &&
+            py >= std::min(y1, y2) - tol && py <= std::max(y1, y2) + tol) {
+            const double ex = x2 - x1, ey = y2 - y1;
+            const double len2 = ex * ex + ey * ey;
+            double t = (len2 > 0.0) ? ((px - x1) * ex + (py - y1) * ey) / len2 : 0.0;
+            t = std::clamp(t, 0.0, 1.0);
+            const double cx = x1 + t * ex - px, cy = y1 + t * ey - py;
+            if (cx * cx + cy * cy <= tol * tol) {
+                hitAlong = (ex * dx + ey * dy) * poly.getRingDirection(r);
+                return true;
+            }
+        }
+
+        // Even-odd crossing number; holes toggle back to outside
+        if ((y1 > py) != (y2 > py)) {
+            const double xCross = x1 + (py - y1) * (x2 - x1) / (y2 - y1);
+            if (px < xCross) {
+                inside = !inside;
+            }
+        }
+        return false;
+    };
+
+    if (grid == nullptr) {
+        for (int r = 0; r < poly.getNumRings() && hitRing < 0; ++r) {
+            const int numPoints = poly.getRing(r).numPoints;
+            for (int i = 0; i + 1 < numPoints; ++i) {
+                if (testEdge(r, i)) {
+                    hitRing = r;
+                    break;
+                }
+            }
+        }
+    } else {
+        // Edges reaching the point and edges crossing the ray towards +x.
+        // The first boundary edge in ring order decides, as in the full scan.
+        grid->forEachEdge(poly, px + ox - tol, py + oy - tol, std::max(poly.getMaxX(), px + ox + tol), py + oy + tol,
+            [&](int r, int i) {
+                if (hitRing >= 0 && (r > hitRing || (r == hitRing && i > hitIndex))) {
+                    return;
+                }
+                if (testEdge(r, i)) {
+                    hitRing = r;
+                    hitIndex = i;
+                }
+            });
+    }
+
+    if (hitRing >= 0) {
+        return hitAlong > 0.0 ? Location::BoundarySameDirection : Location::BoundaryOppositeDirection;
+    }
+    return inside ? Location::Inside : Location::Outside;
+}
@@ -0,0 +1,103 @@
+#ifndef AREA_CLIPPER_H
+#define AREA_CLIPPER_H
+
+#include <span>
+#include <vector>
+#include <ogrsf_frmts.h>
+
+// Read-only view of one closed ring stored as interleaved x,y pairs.
+// As with OGRLinearRing the last point repeats the first one.
+struct FlatRing {
+    const double* coords;
+    int numPoints;
+};
+
+// Polygon flattened into one coordinate array: ring 0 is the exterior,
+// the remaining rings are holes. Built once per geometry so the clipping
+// kernel never touches OGR/GEOS objects in the inner loop.
+class FlatPolygon {
+private:
+    std::vector<double> coords;
+    std::vector<int> ringStarts;        // first point of each ring, plus end sentinel
+    std::vector<signed char> ringDirs;  // +1 if stored order keeps the interior on the left
+    double minX, minY, maxX, maxY;
+    double area;
+
+public:
+    FlatPolygon();
+    explicit FlatPolygon(const OGRPolygon& poly);
+    // Polygon without holes from an interleaved x,y exterior ring
+    explicit FlatPolygon(std::span<const double> ring);
+
+    // Append a closed ring of interleaved x,y pairs; the first ring added is
+    // the exterior. Rings with fewer than 4 points are ignored.
+    void addRing(const double* xy, int numPoints);
+
+    // Remove all rings, keeping the allocated capacity for reuse
+    void clear();
+
+    int getNumRings() const;
+    FlatRing getRing(int index) const;
+    int getRingDirection(int index) const;
+    int getNumPoints() const;
+    bool isEmpty() const;
+
+    // Exterior area minus hole areas, independent of winding order.
+    double getArea() const;
+
+    double getMinX() const { return minX; }
+    double getMinY() const { return minY; }
+    double getMaxX() const { return maxX; }
+    double getMaxY() const { return maxY; }
+    OGREnvelope getEnvelope() const;
+    bool envelopeIntersects(const FlatPolygon& other) const;
+
+    size_t getMemoryUsage() const;
+};
+
+class EdgeGrid;
+
+// Area-only polygon intersection on flat coordinates.
+//
+// The area of A∩B is the boundary integral over the parts of A's edges that
+// lie inside B plus the parts of B's edges that lie inside A. Each edge is
+// split at its crossings with the other polygon and every piece is classified
+// by its midpoint, so no output polygon is ever assembled. Shared boundary
+// pieces are counted once, and only when both interiors lie on the same side.
+// With several clips the same integral runs over the boundary of
+// subject ∩ (clip 1 ∪ clip 2 ∪ ...), so overlapping clips count once.
+class AreaClipper {
+public:
+    // A clip polygon and, optionally, its edge grid
+    struct Clip {
+        const FlatPolygon* polygon;
+        const EdgeGrid* grid;
+    };
+
+    // Area of the intersection of subject and clip (0 when disjoint).
+    // With clipGrid (built from clip) only clip edges near the subject are
+    // visited; the result is the same.
+    static double intersectionArea(const FlatPolygon& subject, const FlatPolygon& clip,
+                                   const EdgeGrid* clipGrid = nullptr);
+
+    // Area of the part of subject covered by at least one of the clips
+    static double unionIntersectionArea(const FlatPolygon& subject, std::span<const Clip> clips);
+
+    // True if (x, y) lies inside the polygon or on its boundary.
+    static bool containsPoint(const FlatPolygon& poly, double x, double y, const EdgeGrid* grid = nullptr);
+
+private:
+    enum class Location { Outside, Inside, BoundarySameDirection, BoundaryOppositeDirection };
+
+    // Sum of the cross products of the pieces of from's edges inside the
+    // box, split where the splitters' edges meet them, that keep(midpoint,
+    // direction) accepts; coordinates relative to ox, oy
+    template <typename Keep>
+    static double boundaryIntegral(const FlatPolygon& from, const EdgeGrid* fromGrid,
+                                   std::span<const Clip> splitters, const OGREnvelope& box,
+                                   double ox, double oy, double tol, std::vector<double>& splits, Keep&& keep);
+    static Location locate(const FlatPolygon& poly, const EdgeGrid* grid, double px, double py,
+                           double dx, double dy, double ox, double oy, double tol);
+};
+
+#endif // AREA_CLIPPER_H
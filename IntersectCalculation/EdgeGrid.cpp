@@ -0,0 +1,88 @@
+#include "EdgeGrid.h"
+#include <cmath>
+#include <utility>
+#include <limits>
+
+EdgeGrid::EdgeGrid(const FlatPolygon& poly)
+    : minX(poly.getMinX()), minY(poly.getMinY()), maxX(poly.getMaxX()), maxY(poly.getMaxY()),
+      cellWidth(1.0), cellHeight(1.0), margin(0.0), slack(0.0), cols(1), rows(1) {
+    const int numEdges = poly.getNumPoints() - poly.getNumRings();
+    if (poly.isEmpty() || numEdges <= 0) {
+        cellStarts.assign(2, 0);
+        return;
+    }
+
+    // About two edges per cell, cells roughly square, at most 4096 per axis
+    const double width = std::max(maxX - minX, std::numeric_limits<double>::min());
+    const double height = std::max(maxY - minY, std::numeric_limits<double>::min());
+    const double cells = std::max(1.0, numEdges / 2.0);
+    cols = static_cast<int>(std::clamp(std::ceil(std::sqrt(cells * width / height)), 1.0, 4096.0));
+    rows = static_cast<int>(std::clamp(std::ceil(cells / cols), 1.0, 4096.0));
+    cellWidth = width / cols;
+    cellHeight = height / rows;
+    const double magnitude = std::max({std::fabs(minX), std::fabs(minY), std::fabs(maxX), std::fabs(maxY)});
+    margin = 8.0 * std::numeric_limits<double>::epsilon() * magnitude;
+    slack = 4.0 * margin;
+
+    const double* coords = poly.getRing(0).coords;
+    for (int r = 0; r < poly.getNumRings(); r++) {
+        ringStarts.push_back(static_cast<uint32_t>((poly.getRing(r).coords - coords) / 2));
+    }
+
+    // Count, then fill: each edge goes into the cells it passes through
+    auto forEachCell = [&](auto&& action) {
+        for (int r = 0; r < poly.getNumRings(); r++) {
+            const FlatRing ring = poly.getRing(r);
+            for (int i = 0; i + 1 < ring.numPoints; i++) {
+                const double* e = ring.coords + 2 * i;
+                const uint32_t point = ringStarts[r] + static_cast<uint32_t>(i);
+                int first, last, c0, c1;
+                edgeRows(e, first, last);
+                for (int y = first; y <= last; y++) {
+                    edgeColumns(e, y, first, last, c0, c1);
+                    for (int x = c0; x <= c1; x++) {
+                        action(static_cast<size_t>(y) * cols + x, point);
+                    }
+                }
+            }
+        }
+    };
+    cellStarts.assign(static_cast<size_t>(cols) * rows + 1, 0);
+    forEachCell([&](size_t cell, uint32_t) { cellStarts[cell + 1]++; });
+    for (size_t i = 1; i < cellStarts.size(); i++) {
+        cellStarts[i] += cellStarts[i - 1];
+    }
+    cellEdges.resize(cellStarts.back());
+    std::vector<uint32_t> fill(cellStarts.begin(), cellStarts.end() - 1);
+    forEachCell([&](size_t cell, uint32_t point) { cellEdges[fill[cell]++] = point; });
+}
+
+void EdgeGrid::edgeColumns(const double* e, int r, int first, int last, int& c0, int& c1) const {
+    const double loX = std::min(e[0], e[2]), hiX = std::max(e[0], e[2]);
+    if (first == last || e[1] == e[3]) {
+        c0 = col(loX - slack);
+        c1 = col(hiX + slack);
+        return;
+    }
+    // The part of the edge inside the row's band (first and last rows open-ended)
+    const double bandLo = r == first ? -std::numeric_limits<double>::infinity() : minY + r * cellHeight;
+    const double bandHi = r == last ? std::numeric_limits<double>::infinity() : minY + (r + 1) * cellHeight;
+    const double inv = 1.0 / (e[3] - e[1]);
+    double ta = (std::max(std::min(e[1], e[3]), bandLo) - e[1]) * inv;
+    double tb = (std::min(std::max(e[1], e[3]), bandHi) - e[1]) * inv;
+    double xa = e[0] + std::clamp(ta, 0.0, 1.0) * (e[2] - e[0]);
+    double xb = e[0] + std::clamp(tb, 0.0, 1.0) * (e[2] - e[0]);
+    if (xa > xb) {
+        std::swap(xa, xb);
+    }
+    c0 = col(std::max(xa, loX) - slack);
+    c1 = col(std::min(xb, hiX) + slack);
+}
+
+size_t EdgeGrid::getCellCount() const {
+    return static_cast<size_t>(cols) * rows;
+}
+
+size_t EdgeGrid::getMemoryUsage() const {
+    return sizeof(EdgeGrid) + (cellStarts.capacity() + cellEdges.capacity() + ringStarts.capacity()) * sizeof(uint32_t);
+}
@@ -0,0 +1,102 @@
+#ifndef EDGE_GRID_H
+#define EDGE_GRID_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "AreaClipper.h"
+
+// Uniform grid over one polygon's envelope listing the edges that pass
+// through each cell, about two edges per cell. Lets AreaClipper look at the
+// edges near a parcel instead of all edges of a 50k-vertex fire perimeter.
+//
+// The grid keeps no pointer to the polygon: queries take it again, so it
+// also serves a polygon rebuilt with the same coordinates (quantized storage).
+class EdgeGrid {
+public:
+    static constexpr size_t kDefaultMinPoints = 4096;
+
+    explicit EdgeGrid(const FlatPolygon& poly);
+
+    // Call visit(ring, i) once for every edge (point i to i + 1 of ring) of
+    // poly, the polygon the grid was built from, that passes through a cell
+    // the box reaches. A superset of the edges meeting the query box;
+    // callers keep their own box tests.
+    template <typename Visitor>
+    void forEachEdge(const FlatPolygon& poly, double qMinX, double qMinY, double qMaxX, double qMaxY,
+                     Visitor&& visit) const;
+
+    size_t getCellCount() const;
+    size_t getMemoryUsage() const;
+
+private:
+    double minX, minY, maxX, maxY;
+    double cellWidth, cellHeight;
+    double margin;                      // absorbs rounding of callers' relative coordinates
+    double slack;                       // widens each row's x range of an edge
+    int cols, rows;
+    std::vector<uint32_t> cellStarts;   // CSR offsets into cellEdges, cols * rows + 1
+    std::vector<uint32_t> cellEdges;    // first point of each edge, counted over all rings
+    std::vector<uint32_t> ringStarts;   // first point of each ring
+
+    int col(double x) const {
+        const double c = (x - minX) / cellWidth;
+        return c <= 0.0 ? 0 : (c >= cols - 1 ? cols - 1 : static_cast<int>(c));
+    }
+    int row(double y) const {
+        const double r = (y - minY) / cellHeight;
+        return r <= 0.0 ? 0 : (r >= rows - 1 ? rows - 1 : static_cast<int>(r));
+    }
+
+    // Rows an edge passes through, and its columns within one of them.
+    // Registration and queries use the same arithmetic, so both agree.
+    void edgeRows(const double* e, int& first, int& last) const {
+        first = row(std::min(e[1], e[3]) - margin);
+        last = row(std::max(e[1], e[3]) + margin);
+    }
+    void edgeColumns(const double* e, int r, int first, int last, int& c0, int& c1) const;
+};
+
+template <typename Visitor>
+void EdgeGrid::forEachEdge(const FlatPolygon& poly, double qMinX, double qMinY, double qMaxX, double qMaxY,
+                           Visitor&& visit) const {
+    qMinX -= margin;
+    qMinY -= margin;
+    qMaxX += margin;
+    qMaxY += margin;
+    if (qMaxX < minX || qMinX > maxX || qMaxY < minY || qMinY > maxY) {
+        return;
+    }
+    const double* coords = poly.getRing(0).coords;
+    const int c0 = col(qMinX), c1 = col(qMaxX);
+    const int r0 = row(qMinY), r1 = row(qMaxY);
+    for (int r = r0; r <= r1; r++) {
+        for (int c = c0; c <= c1; c++) {
+            const size_t cell = static_cast<size_t>(r) * cols + c;
+            for (uint32_t k = cellStarts[cell]; k < cellStarts[cell + 1]; k++) {
+                const uint32_t point = cellEdges[k];
+                const double* e = coords + 2 * static_cast<size_t>(point);
+                // An edge in several query cells is reported from the first
+                // one in row-major order only
+                int first, last, e0, e1;
+                edgeRows(e, first, last);
+                bool report = false;
+                for (int er = std::max(first, r0); er <= r; er++) {
+                    edgeColumns(e, er, first, last, e0, e1);
+                    if (e0 <= c1 && e1 >= c0) {
+                        report = er == r && std::max(e0, c0) == c;
+                        break;
+                    }
+                }
+                if (!report) {
+                    continue;
+                }
+                const int ring = static_cast<int>(std::upper_bound(ringStarts.begin(), ringStarts.end(), point)
+                                                  - ringStarts.begin()) - 1;
+                visit(ring, static_cast<int>(point - ringStarts[ring]));
+            }
+        }
+    }
+}
+
+#endif // EDGE_GRID_H
@@ -0,0 +1,391 @@
+#include "HazardDaemon.h"
+#include "Logger.h"
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace HazardProtocol;
+
+static volatile std::sig_atomic_t stopSignal = 0;
+static volatile std::sig_atomic_t reloadSignal = 0;
+
+static void onSignal(int sig) {
+    if (sig == SIGHUP) {
+        reloadSignal = 1;
+    } else {
+        stopSignal = 1;
+    }
+}
+
+// A client that stops sending in the middle of a request, or stops reading
+// its response, is dropped after this long
+static constexpr int kIoTimeoutMs = 10000;
+static constexpr int kPollSliceMs = 500;
+
+// Read exactly size bytes. Waits in poll() slices so the stop flag is seen,
+// and gives up when the peer sends nothing for kIoTimeoutMs: a stalled
+// client must not keep its thread, and with it shutdown, waiting forever.
+static bool readFully(int fd, void* buffer, size_t size) {
+    char* p = static_cast<char*>(buffer);
+    int idleMs = 0;
+    while (size > 0) {
+        if (stopSignal) {
+            return false;
+        }
+        pollfd pfd{fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, kPollSliceMs);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready < 0) {
+            return false;
+        }
+        if (ready == 0) {
+            idleMs += kPollSliceMs;
+            if (idleMs >= kIoTimeoutMs) {
+                return false;
+            }
+            continue;
+        }
+        ssize_t n = ::read(fd, p, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+        idleMs = 0;
+    }
+    return true;
+}
+
+static bool writeFully(int fd, const void* buffer, size_t size) {
+    const char* p = static_cast<const char*>(buffer);
+    while (size > 0) {
+        ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+HazardDaemon::HazardDaemon(const DaemonConfig& config)
+    : config(config), reloadRequested(false), activeConnections(0), rejectedConnections(0), listenFd(-1) {
+}
+
+HazardDaemon::~HazardDaemon() {
+    closeSocket();
+}
+
+int HazardDaemon::run() {
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal;        // no SA_RESTART: poll() must wake up
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGHUP, &action, nullptr);
+
+    if (!reloadSnapshot()) {
+        LOG_ERROR("Initial snapshot load failed. Exiting.");
+        return 1;
+    }
+    if (!openSocket()) {
+        return 1;
+    }
+    LOG_INFO("Hazard daemon listening on " << config.socketPath);
+
+    std::thread reloader(&HazardDaemon::reloadLoop, this);
+
+    while (!stopSignal) {
+        pollfd pfd{listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 500) <= 0) {
+            continue;
+        }
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        // send() fails instead of blocking on a client that does not read
+        timeval sendTimeout{kIoTimeoutMs / 1000, 0};
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+
+        // Over the limit the client gets Busy in place of its first response
+        if (activeConnections >= config.maxConnections) {
+            sendResponse(fd, Status::Busy, 0.0, {});
+            close(fd);
+            rejectedConnections++;
+            continue;
+        }
+        activeConnections++;
+        std::thread([this, fd] {
+            serveConnection(fd);
+            close(fd);
+            activeConnections--;
+        }).detach();
+    }
+
+    LOG_INFO("Hazard daemon shutting down (" << rejectedConnections << " connections rejected at the limit of "
+             << config.maxConnections << ")");
+    closeSocket();
+    reloader.join();
+    // Connection threads only block in poll() slices or in bounded sends,
+    // and notice the stop flag
+    while (activeConnections > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return 0;
+}
+
+bool HazardDaemon::openSocket() {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (config.socketPath.size() >= sizeof(addr.sun_path)) {
+        LOG_ERROR("Socket path too long: " << config.socketPath);
+        return false;
+    }
+    std::strncpy(addr.sun_path, config.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    // A socket file left by a crashed run would make bind() fail. It is only
+    // stale if connecting is refused; a live daemon keeps its socket.
+    int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+        LOG_ERROR("socket() failed: " << std::strerror(errno));
+        return false;
+    }
+    int connectError = connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 ? 0 : errno;
+    close(probe);
+    if (connectError == 0) {
+        LOG_ERROR("Another daemon is listening on " << config.socketPath);
+        return false;
+    }
+    if (connectError == ECONNREFUSED) {
+        unlink(config.socketPath.c_str());
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        LOG_ERROR("socket() failed: " << std::strerror(errno));
+        return false;
+    }
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listenFd, 64) < 0) {
+        LOG_ERROR("Cannot listen on " << config.socketPath << ": " << std::strerror(errno));
+        // Not ours: closeSocket() would unlink the path
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    chmod(config.socketPath.c_str(), 0660);
+    return true;
+}
+
+void HazardDaemon::closeSocket() {
+    if (listenFd >= 0) {
+        close(listenFd);
+        listenFd = -1;
+        unlink(config.socketPath.c_str());
+    }
+}
+
+HazardDaemon::SourceStamp HazardDaemon::readSourceStamp() {
+    SourceStamp stamp;
+    // An update may rewrite the attributes or the index without the .shp
+    size_t k = 0;
+    for (const char* extension : {".shp", ".dbf", ".shx"}) {
+        const std::string file = std::filesystem::path(config.shapefilePath).replace_extension(extension).string();
+        struct stat st;
+        if (stat(file.c_str(), &st) == 0) {
+            stamp.files[k] = static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+            stamp.files[k + 1] = static_cast<long long>(st.st_size);
+        }
+        k += 2;
+    }
+
+    // New validity flags or repairs change the served polygons too. While
+    // the database is unreachable the tables count as unchanged.
+    stamp.invalidHash = sourceStamp.invalidHash;
+    stamp.repairedHash = sourceStamp.repairedHash;
+    try {
+        if (!stampDb || !stampDb->isConnected()) {
+            stampDb = std::make_unique<DatabaseHandler>("polygons_db", "5432", "polygons_db", "polygons_user",
+                                                        "polygons_pass");
+        }
+        uint64_t invalidHash, repairedHash;
+        if (stampDb->fingerprintTable("invalid_" + config.hazardName, invalidHash) &&
+            stampDb->fingerprintTable("repaired_" + config.hazardName, repairedHash)) {
+            stamp.invalidHash = invalidHash;
+            stamp.repairedHash = repairedHash;
+        }
+    } catch (const std::exception& e) {
+        stampDb.reset();
+        LOG_WARN("Cannot check the " << config.hazardName << " validity tables: " << e.what());
+    }
+    return stamp;
+}
+
+bool HazardDaemon::reloadSnapshot() {
+    SourceStamp stamp = readSourceStamp();
+    auto next = std::make_shared<HazardSnapshot>(config.shapefilePath, config.wildfireFilter,
+                                                   config.hazardName, config.storage, config.edgeGridMinPoints);
+    if (!next->load()) {
+        LOG_ERROR("Snapshot load failed, keeping the current snapshot");
+        return false;
+    }
+    snapshot.store(std::move(next));
+    sourceStamp = stamp;
+    return true;
+}
+
+void HazardDaemon::reloadLoop() {
+    auto lastCheck = std::chrono::steady_clock::now();
+    while (!stopSignal) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        bool due = reloadRequested.exchange(false);
+        if (reloadSignal) {
+            reloadSignal = 0;
+            due = true;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (!due && now - lastCheck >= std::chrono::seconds(config.reloadIntervalSeconds)) {
+            lastCheck = now;
+            if (!(readSourceStamp() == sourceStamp)) {
+                LOG_INFO("Shapefile or validity tables changed, reloading snapshot");
+                due = true;
+            }
+        }
+
+        if (due) {
+            reloadSnapshot();
+        }
+    }
+}
+
+void HazardDaemon::serveConnection(int fd) {
+    std::vector<char> payload;
+    while (!stopSignal) {
+        pollfd pfd{fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, 500);
+        if (ready == 0 || (ready < 0 && errno == EINTR)) {
+            continue;
+        }
+        if (ready < 0) {
+            break;
+        }
+
+        RequestHeader header;
+        if (!readFully(fd, &header, sizeof(header))) {
+            break;
+        }
+        if (header.magic != kRequestMagic || header.payloadSize > kMaxPayload) {
+            sendResponse(fd, Status::BadRequest, 0.0, {});
+            break;
+        }
+        payload.resize(header.payloadSize);
+        if (!readFully(fd, payload.data(), payload.size())) {
+            break;
+        }
+        if (!handleRequest(fd, header, payload)) {
+            break;
+        }
+    }
+}
+
+bool HazardDaemon::handleRequest(int fd, const RequestHeader& header, const std::vector<char>& payload) {
+    std::vector<HazardHit> hits;
+
+    if (header.type == RequestType::Reload) {
+        reloadRequested = true;
+        return sendResponse(fd, Status::Ok, 0.0, hits);
+    }
+
+    // Hold a reference for the whole query; a concurrent reload cannot free it
+    std::shared_ptr<const HazardSnapshot> current = snapshot.load();
+    if (!current) {
+        return sendResponse(fd, Status::Unavailable, 0.0, hits);
+    }
+
+    switch (header.type) {
+        case RequestType::Point: {
+            if (payload.size() != 2 * sizeof(double)) {
+                return sendResponse(fd, Status::BadRequest, 0.0, hits);
+            }
+            double xy[2];
+            std::memcpy(xy, payload.data(), sizeof(xy));
+            current->queryPoint(xy[0], xy[1], hits);
+            return sendResponse(fd, Status::Ok, 0.0, hits);
+        }
+        case RequestType::Parcel: {
+            if (payload.size() != sizeof(int32_t)) {
+                return sendResponse(fd, Status::BadRequest, 0.0, hits);
+            }
+            int32_t parcelId;
+            std::memcpy(&parcelId, payload.data(), sizeof(parcelId));
+            FlatPolygon scratch;
+            const FlatPolygon* parcel = current->findParcel(parcelId, scratch);
+            if (parcel == nullptr) {
+                return sendResponse(fd, Status::NotFound, 0.0, hits);
+            }
+            double fraction = current->queryArea(*parcel, hits);
+            return sendResponse(fd, Status::Ok, fraction, hits);
+        }
+        case RequestType::Polygon: {
+            uint32_t numPoints = 0;
+            if (payload.size() >= sizeof(numPoints)) {
+                std::memcpy(&numPoints, payload.data(), sizeof(numPoints));
+            }
+            if (numPoints < 3 || payload.size() != sizeof(numPoints) + 2 * sizeof(double) * numPoints) {
+                return sendResponse(fd, Status::BadRequest, 0.0, hits);
+            }
+            std::vector<double> coords(2 * static_cast<size_t>(numPoints));
+            std::memcpy(coords.data(), payload.data() + sizeof(numPoints), coords.size() * sizeof(double));
+            if (coords[0] != coords[coords.size() - 2] || coords[1] != coords[coords.size() - 1]) {
+                coords.push_back(coords[0]);
+                coords.push_back(coords[1]);
+            }
+            FlatPolygon area;
+            area.addRing(coords.data(), static_cast<int>(coords.size() / 2));
+            if (area.isEmpty()) {
+                return sendResponse(fd, Status::BadRequest, 0.0, hits);
+            }
+            double fraction = current->queryArea(area, hits);
+            return sendResponse(fd, Status::Ok, fraction, hits);
+        }
+        default:
+            return sendResponse(fd, Status::BadRequest, 0.0, hits);
+    }
+}
+
+bool HazardDaemon::sendResponse(int fd, Status status, double value, const std::vector<HazardHit>& hits) {
+    ResponseHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = kResponseMagic;
+    header.status = status;
+    header.count = static_cast<uint32_t>(hits.size());
+    header.value = value;
+
+    // One write per response keeps small replies in a single packet
+    std::vector<char> buffer(sizeof(header) + hits.size() * sizeof(HazardHit));
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    if (!hits.empty()) {
+        std::memcpy(buffer.data() + sizeof(header), hits.data(), hits.size() * sizeof(HazardHit));
+    }
+    return writeFully(fd, buffer.data(), buffer.size());
+}
@@ -0,0 +1,70 @@
+#ifndef HAZARD_DAEMON_H
+#define HAZARD_DAEMON_H
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DatabaseHandler.h"
+#include "HazardProtocol.h"
+#include "HazardSnapshot.h"
+
+struct DaemonConfig {
+    std::string socketPath = "/tmp/intersect_calculation.sock";
+    std::string shapefilePath = "/opt/airflow/Dataset_Cali_Wildfire/Wildfires.shp";
+    ShapefileFilter wildfireFilter;
+    std::string hazardName = "wildfire";    // validity tables of the served layer
+    CoordinateStorage storage = CoordinateStorage::Double;  // for resident parcels and wildfires
+    size_t edgeGridMinPoints = EdgeGrid::kDefaultMinPoints;
+    unsigned reloadIntervalSeconds = 30;    // how often the shapefile is checked for changes
+    unsigned maxConnections = 64;           // further clients get Status::Busy and are closed
+};
+
+// Long-running query server. Keeps a HazardSnapshot resident and answers
+// point, parcel-id and polygon queries over a local Unix socket using the
+// HazardProtocol binary format, one thread per client connection, up to
+// DaemonConfig::maxConnections at a time.
+//
+// A new snapshot is built in the background when the shapefile (.shp, .dbf
+// or .shx) changes on disk, when the layer's invalid_/repaired_ tables
+// change, on SIGHUP, or on a Reload request, and swapped in atomically.
+class HazardDaemon {
+private:
+    struct SourceStamp {
+        std::array<long long, 6> files{};   // mtime and size of the .shp, .dbf and .shx
+        uint64_t invalidHash = 0;           // content of invalid_<name>
+        uint64_t repairedHash = 0;          // content of repaired_<name>
+        bool operator==(const SourceStamp&) const = default;
+    };
+
+    DaemonConfig config;
+    std::atomic<std::shared_ptr<const HazardSnapshot>> snapshot;
+    std::atomic<bool> reloadRequested;
+    std::atomic<unsigned> activeConnections;
+    size_t rejectedConnections;
+    SourceStamp sourceStamp;
+    std::unique_ptr<DatabaseHandler> stampDb;   // fingerprints the validity tables
+    int listenFd;
+
+    bool openSocket();
+    void closeSocket();
+    SourceStamp readSourceStamp();
+    bool reloadSnapshot();
+    void reloadLoop();
+    void serveConnection(int fd);
+    bool handleRequest(int fd, const HazardProtocol::RequestHeader& header,
+                       const std::vector<char>& payload);
+    static bool sendResponse(int fd, HazardProtocol::Status status, double value,
+                             const std::vector<HazardProtocol::HazardHit>& hits);
+
+public:
+    explicit HazardDaemon(const DaemonConfig& config);
+    ~HazardDaemon();
+
+    // Load the first snapshot and serve until SIGINT/SIGTERM. Returns exit code.
+    int run();
+};
+
+#endif // HAZARD_DAEMON_H
@@ -0,0 +1,323 @@
+#include "HazardLayer.h"
+#include "GeometryHash.h"
+#include "HilbertCurve.h"
+#include "InvalidPolygonTableHandler.h"
+#include "JoinDeadline.h"
+#include "Logger.h"
+#include "PolygonDistance.h"
+#include "ShapefileHandler.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+HazardLayer::HazardLayer(const std::string& shapefilePath, const ShapefileFilter& filter,
+                         const std::string& name, CoordinateStorage storage, size_t edgeGridMinPoints)
+    : name(name), shapefilePath(shapefilePath), filter(filter), storage(storage),
+      invalidCount(0), repairedCount(0), edgeGridMinPoints(edgeGridMinPoints),
+      edgeGrids(std::make_unique<EdgeGridCache>(0)) {
+}
+
+FlatPolygon& HazardLayer::scratchPolygon() {
+    thread_local FlatPolygon scratch;
+    return scratch;
+}
+
+const std::string& HazardLayer::getName() const {
+    return name;
+}
+
+const std::string& HazardLayer::getShapefilePath() const {
+    return shapefilePath;
+}
+
+size_t HazardLayer::size() const {
+    return polygonIds.size();
+}
+
+size_t HazardLayer::getInvalidCount() const {
+    return invalidCount;
+}
+
+size_t HazardLayer::getRepairedCount() const {
+    return repairedCount;
+}
+
+int HazardLayer::getPolygonId(size_t index) const {
+    return polygonIds[index];
+}
+
+CoordinateStorage HazardLayer::getCoordinateStorage() const {
+    return storage;
+}
+
+size_t HazardLayer::getCoordinateMemoryUsage() const {
+    size_t bytes = quantized.getMemoryUsage();
+    for (const auto& polygon : polygons) {
+        bytes += polygon.getMemoryUsage();
+    }
+    return bytes;
+}
+
+bool HazardLayer::load() {
+    ShapefileHandler handler(shapefilePath, filter);
+    polygonIds = handler.takePolygonIds();
+
+    // Flatten every polygon once so the clipping kernel can run on raw coordinates
+    polygons.clear();
+    polygons.reserve(handler.getPolygonCount());
+    for (size_t i = 0; i < handler.getPolygonCount(); i++) {
+        polygons.emplace_back(handler.getPolygon(i));
+    }
+
+    // Fetch all invalid flags up front instead of one query per parcel/polygon pair
+    invalid.assign(polygons.size(), false);
+    invalidCount = 0;
+    repairedCount = 0;
+    InvalidPolygonTableHandler invalidHandler("polygons_db", "5432", "polygons_db", "polygons_user", "polygons_pass", name);
+    if (invalidHandler.isConnected()) {
+        applyValidity(invalidHandler, handler);
+    }
+    sortSlots();
+
+    if (storage == CoordinateStorage::Quantized) {
+        quantized = QuantizedPolygonStore();
+        for (const auto& polygon : polygons) {
+            quantized.add(polygon);
+        }
+        quantized.shrinkToFit();
+        std::vector<FlatPolygon>().swap(polygons);
+        if (quantized.getQuantizedCount() < quantized.size()) {
+            LOG_WARN((quantized.size() - quantized.getQuantizedCount()) << " " << name
+                     << " polygons do not fit the quantization grid and keep double coordinates");
+        }
+    }
+
+    std::vector<OGREnvelope> envelopes;
+    envelopes.reserve(size());
+    for (uint32_t slot = 0; slot < size(); slot++) {
+        envelopes.push_back(getEnvelope(slot));
+    }
+    index.build(envelopes);
+    edgeGrids = std::make_unique<EdgeGridCache>(size());
+
+    LOG_INFO("Loaded " << size() << " " << name << " polygons from " << shapefilePath
+             << " (" << repairedCount << " repaired, " << invalidCount << " invalid and skipped, coordinates "
+             << getCoordinateMemoryUsage() / 1024 << " KiB"
+             << (storage == CoordinateStorage::Quantized ? " quantized" : "") << ", index "
+             << index.getMemoryUsage() / 1024 << " KiB)");
+    return size() > 0;
+}
+
+const EdgeGrid* HazardLayer::getEdgeGrid(uint32_t slot, const FlatPolygon& polygon) const {
+    if (edgeGridMinPoints == 0 || static_cast<size_t>(polygon.getNumPoints()) < edgeGridMinPoints) {
+        return nullptr;
+    }
+    std::atomic<const EdgeGrid*>& entry = edgeGrids->grids[slot];
+    const EdgeGrid* grid = entry.load(std::memory_order_acquire);
+    if (grid != nullptr) {
+        return grid;
+    }
+
+    // Two workers may build the same grid; the loser drops its copy
+    auto built = std::make_unique<EdgeGrid>(polygon);
+    const EdgeGrid* expected = nullptr;
+    if (!entry.compare_exchange_strong(expected, built.get(), std::memory_order_acq_rel)) {
+        return expected;
+    }
+    edgeGrids->count++;
+    edgeGrids->bytes += built->getMemoryUsage();
+    LOG_DEBUG("Built edge grid for " << name << " polygon " << polygonIds[slot] << ": "
+              << polygon.getNumPoints() << " points, " << built->getCellCount() << " cells");
+    return built.release();
+}
+
+size_t HazardLayer::getEdgeGridCount() const {
+    return edgeGrids->count;
+}
+
+size_t HazardLayer::getEdgeGridMemoryUsage() const {
+    return edgeGrids->bytes;
+}
+
+OGREnvelope HazardLayer::getEnvelope(uint32_t slot) const {
+    return storage == CoordinateStorage::Quantized ? quantized.getEnvelope(slot) : polygons[slot].getEnvelope();
+}
+
+void HazardLayer::sortSlots() {
+    std::vector<std::pair<int64_t, uint32_t>> keys;
+    keys.reserve(polygons.size());
+    for (uint32_t slot = 0; slot < polygons.size(); slot++) {
+        keys.emplace_back(HilbertCurve::key(polygons[slot].getEnvelope()), slot);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<FlatPolygon> sortedPolygons;
+    std::vector<int> sortedIds;
+    std::vector<bool> sortedInvalid;
+    sortedPolygons.reserve(keys.size());
+    sortedIds.reserve(keys.size());
+    sortedInvalid.reserve(keys.size());
+    for (const auto& [key, slot] : keys) {
+        sortedPolygons.push_back(std::move(polygons[slot]));
+        sortedIds.push_back(polygonIds[slot]);
+        sortedInvalid.push_back(invalid[slot]);
+    }
+    polygons = std::move(sortedPolygons);
+    polygonIds = std::move(sortedIds);
+    invalid = std::move(sortedInvalid);
+}
+
+void HazardLayer::applyValidity(InvalidPolygonTableHandler& db, const ShapefileHandler& source) {
+    std::vector<int> invalidIds;
+    if (!db.getInvalidWildfireIds(invalidIds)) {
+        return;
+    }
+
+    // Ids are stable across filters; map them to the slots that were loaded
+    std::unordered_map<int, uint32_t> slots;
+    slots.reserve(polygonIds.size());
+    for (size_t i = 0; i < polygonIds.size(); i++) {
+        slots[polygonIds[i]] = static_cast<uint32_t>(i);
+    }
+    std::vector<uint32_t> invalidSlots;
+    for (int id : invalidIds) {
+        auto it = slots.find(id);
+        if (it != slots.end() && !invalid[it->second]) {
+            invalid[it->second] = true;
+            invalidSlots.push_back(it->second);
+        }
+    }
+    invalidCount = invalidSlots.size();
+
+    std::vector<RepairedGeometry> repairs;
+    if (invalidSlots.empty() || !db.getRepairedWildfires(repairs)) {
+        return;
+    }
+    std::unordered_map<int, const RepairedGeometry*> repairById;
+    for (const auto& repair : repairs) {
+        repairById[repair.polygonId] = &repair;
+    }
+
+    // A repair is only used while its source hash matches the shapefile
+    for (uint32_t slot : invalidSlots) {
+        const int id = polygonIds[slot];
+        auto it = repairById.find(id);
+        if (it == repairById.end() || it->second->sourceHash != hashPolygon(source.getPolygon(slot))) {
+            continue;
+        }
+
+        const std::vector<unsigned char>& wkb = it->second->wkb;
+        OGRGeometry* geom = nullptr;
+        if (OGRGeometryFactory::createFromWkb(wkb.data(), nullptr, &geom, wkb.size()) != OGRERR_NONE ||
+            geom == nullptr) {
+            LOG_WARN("Stored repair of polygon " << id << " is not valid WKB");
+            continue;
+        }
+
+        // The first part takes the slot, further parts get slots with the same id
+        OGRMultiPolygon* parts = OGRGeometryFactory::forceToMultiPolygon(geom)->toMultiPolygon();
+        for (int p = 0; p < parts->getNumGeometries(); p++) {
+            const OGRPolygon* part = parts->getGeometryRef(p)->toPolygon();
+            if (p == 0) {
+                polygons[slot] = FlatPolygon(*part);
+                invalid[slot] = false;
+            } else {
+                polygons.emplace_back(*part);
+                polygonIds.push_back(id);
+                invalid.push_back(false);
+            }
+        }
+        if (parts->getNumGeometries() > 0) {
+            repairedCount++;
+            invalidCount--;
+        }
+        delete parts;
+    }
+}
+
+std::vector<OGREnvelope> HazardLayer::getExtents(size_t maxBoxes) const {
+    std::vector<OGREnvelope> envelopes;
+    envelopes.reserve(size());
+    for (uint32_t slot = 0; slot < size(); slot++) {
+        if (!invalid[slot]) {
+            envelopes.push_back(getEnvelope(slot));
+        }
+    }
+    return SpatialIndex::coverEnvelopes(std::move(envelopes), maxBoxes);
+}
+
+double HazardLayer::intersectionArea(const FlatPolygon& area,
+                                     std::vector<std::pair<uint32_t, double>>* overlaps) const {
+    thread_local std::vector<std::pair<uint32_t, double>> hits;
+    hits.clear();
+    forEachCandidate(area.getEnvelope(), [&](uint32_t slot, const FlatPolygon& polygon) {
+        if (JoinDeadline::passed()) {
+            return;
+        }
+        double overlap = AreaClipper::intersectionArea(area, polygon, getEdgeGrid(slot, polygon));
+        if (overlap > 0.0) {
+            hits.emplace_back(slot, overlap);
+        }
+    });
+    if (overlaps != nullptr) {
+        overlaps->insert(overlaps->end(), hits.begin(), hits.end());
+    }
+    if (hits.size() <= 1) {
+        return hits.empty() ? 0.0 : hits[0].second;
+    }
+
+    // Several polygons cover the area: clip against their union. Quantized
+    // polygons are rebuilt side by side, as the candidate scratch is shared.
+    thread_local std::vector<FlatPolygon> rebuilt;
+    if (rebuilt.size() < hits.size()) {
+        rebuilt.resize(hits.size());
+    }
+    std::vector<AreaClipper::Clip> clips;
+    clips.reserve(hits.size());
+    for (size_t i = 0; i < hits.size(); i++) {
+        const FlatPolygon& polygon = getPolygon(hits[i].first, rebuilt[i]);
+        clips.push_back(AreaClipper::Clip{&polygon, getEdgeGrid(hits[i].first, polygon)});
+    }
+    return AreaClipper::unionIntersectionArea(area, clips);
+}
+
+bool HazardLayer::intersects(const FlatPolygon& area) const {
+    bool found = false;
+    forEachCandidate(area.getEnvelope(), [&](uint32_t slot, const FlatPolygon& polygon) {
+        if (!found && !JoinDeadline::passed() && PolygonDistance::intersects(area, polygon, getEdgeGrid(slot, polygon))) {
+            found = true;
+        }
+    });
+    return found;
+}
+
+bool HazardLayer::isWithin(const FlatPolygon& area, double distance) const {
+    OGREnvelope grown = area.getEnvelope();
+    grown.MinX -= distance;
+    grown.MinY -= distance;
+    grown.MaxX += distance;
+    grown.MaxY += distance;
+
+    // A result at the cutoff only means "not closer", so cut just above distance
+    const double cutoff = std::nextafter(distance, std::numeric_limits<double>::infinity());
+    bool found = false;
+    forEachCandidate(grown, [&](uint32_t, const FlatPolygon& polygon) {
+        if (!found && !JoinDeadline::passed() && PolygonDistance::distance(area, polygon, cutoff) <= distance) {
+            found = true;
+        }
+    });
+    return found;
+}
+
+void HazardLayer::nearest(const FlatPolygon& area, size_t k, double maxDistance,
+                          std::vector<std::pair<double, uint32_t>>& out) const {
+    const double cutoff = std::nextafter(maxDistance, std::numeric_limits<double>::infinity());
+    FlatPolygon& scratch = scratchPolygon();
+    index.nearest(area.getEnvelope(), k, maxDistance, [&](uint32_t slot) {
+        if (invalid[slot] || JoinDeadline::passed()) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return PolygonDistance::distance(area, getPolygon(slot, scratch), cutoff);
+    }, out);
+}
@@ -0,0 +1,155 @@
+#ifndef HAZARD_LAYER_H
+#define HAZARD_LAYER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AreaClipper.h"
+#include "EdgeGrid.h"
+#include "InvalidPolygonTableHandler.h"
+#include "QuantizedPolygonStore.h"
+#include "ShapefileHandler.h"
+#include "SpatialIndex.h"
+
+// One hazard polygon set (e.g. wildfire perimeters) held in memory for joins:
+// the flattened polygons, their validity flags from the database and an
+// R-tree over their envelopes. Invalid polygons are replaced by their stored
+// repair when one exists for the current geometry. With quantized storage
+// the polygons move into a QuantizedPolygonStore after loading and joins
+// see them as FlatPolygons rebuilt per candidate. Polygons with at least
+// edgeGridMinPoints points get an EdgeGrid the first time a join needs it.
+// Read-only once loaded, apart from those grids.
+class HazardLayer {
+private:
+    // Lazily built edge grids per slot, published with a compare-and-swap
+    struct EdgeGridCache {
+        std::vector<std::atomic<const EdgeGrid*>> grids;
+        std::atomic<size_t> count{0};
+        std::atomic<size_t> bytes{0};
+
+        explicit EdgeGridCache(size_t slots) : grids(slots) {}
+        ~EdgeGridCache() {
+            for (auto& grid : grids) {
+                delete grid.load();
+            }
+        }
+    };
+
+    std::string name;           // selects invalid_<name> / repaired_<name>
+    std::string shapefilePath;
+    ShapefileFilter filter;
+    CoordinateStorage storage;
+    std::vector<FlatPolygon> polygons;  // empty after load with quantized storage
+    QuantizedPolygonStore quantized;
+    std::vector<int> polygonIds;        // stable shapefile id of each slot
+    std::vector<bool> invalid;
+    size_t invalidCount;        // invalid and not repaired, skipped in joins
+    size_t repairedCount;
+    SpatialIndex index;
+    size_t edgeGridMinPoints;   // 0 = never build edge grids
+    std::unique_ptr<EdgeGridCache> edgeGrids;
+
+    void applyValidity(InvalidPolygonTableHandler& db, const ShapefileHandler& source);
+
+    // Renumber slots in Hilbert order of the envelope centres, so polygons
+    // near each other on the map are near each other in memory
+    void sortSlots();
+
+    // Per-thread buffer for dequantized candidates
+    static FlatPolygon& scratchPolygon();
+
+    OGREnvelope getEnvelope(uint32_t slot) const;
+
+public:
+    HazardLayer(const std::string& shapefilePath, const ShapefileFilter& filter = ShapefileFilter(),
+                const std::string& name = "wildfire", CoordinateStorage storage = CoordinateStorage::Double,
+                size_t edgeGridMinPoints = EdgeGrid::kDefaultMinPoints);
+
+    // Load the shapefile, the invalid flags and build the index
+    bool load();
+
+    const std::string& getName() const;
+    const std::string& getShapefilePath() const;
+    size_t size() const;
+    size_t getInvalidCount() const;
+    size_t getRepairedCount() const;
+    int getPolygonId(size_t index) const;
+    CoordinateStorage getCoordinateStorage() const;
+
+    // Bytes held by polygon coordinates, excluding the index
+    size_t getCoordinateMemoryUsage() const;
+
+    // The polygon in a slot; with quantized storage it is rebuilt in
+    // scratch, which is returned
+    const FlatPolygon& getPolygon(uint32_t slot, FlatPolygon& scratch) const {
+        return storage == CoordinateStorage::Quantized ? quantized.get(slot, scratch) : polygons[slot];
+    }
+
+    // Edge grid of a large polygon, built on first use from polygon (the
+    // slot's polygon as returned by getPolygon); nullptr below the threshold
+    const EdgeGrid* getEdgeGrid(uint32_t slot, const FlatPolygon& polygon) const;
+
+    // Edge grids built so far and their bytes
+    size_t getEdgeGridCount() const;
+    size_t getEdgeGridMemoryUsage() const;
+
+    // Call visit(slot, polygon) for each valid polygon whose envelope meets
+    // env. The polygon reference is only valid during the call.
+    template <typename Visitor>
+    void forEachCandidate(const OGREnvelope& env, Visitor&& visit) const {
+        FlatPolygon& scratch = scratchPolygon();
+        index.query(env, [&](uint32_t id) {
+            if (!invalid[id]) {
+                visit(id, getPolygon(id, scratch));
+            }
+        });
+    }
+
+    // Call visit(slot) for each valid polygon containing (x, y) or having
+    // it on the boundary; quantized polygons are tested on the grid
+    template <typename Visitor>
+    void forEachContaining(double x, double y, Visitor&& visit) const {
+        OGREnvelope env;
+        env.MinX = env.MaxX = x;
+        env.MinY = env.MaxY = y;
+        index.query(env, [&](uint32_t id) {
+            if (invalid[id]) {
+                return;
+            }
+            const bool inside = storage == CoordinateStorage::Quantized
+                                    ? quantized.containsPoint(id, x, y)
+                                    : AreaClipper::containsPoint(polygons[id], x, y, getEdgeGrid(id, polygons[id]));
+            if (inside) {
+                visit(id);
+            }
+        });
+    }
+
+    // At most maxBoxes boxes covering every valid polygon, for server-side
+    // parcel filtering. Empty when nothing valid is loaded.
+    std::vector<OGREnvelope> getExtents(size_t maxBoxes) const;
+
+    // Area of the part of area covered by the valid polygons of the layer.
+    // Overlapping polygons (the same ground burned in several years) count
+    // once. With overlaps, each polygon meeting the area with positive area
+    // is appended as (slot, its own intersection area).
+    double intersectionArea(const FlatPolygon& area,
+                            std::vector<std::pair<uint32_t, double>>* overlaps = nullptr) const;
+
+    // True if some valid polygon shares a point with the area, touching
+    // included; stops at the first one
+    bool intersects(const FlatPolygon& area) const;
+
+    // True if some valid polygon lies within distance of the area: R-tree
+    // search with the area's envelope grown by distance, then exact
+    // polygon distance until the first hit
+    bool isWithin(const FlatPolygon& area, double distance) const;
+
+    // Up to k valid polygons nearest to the area and within maxDistance,
+    // closest first, as (distance, slot); best-first R-tree traversal
+    void nearest(const FlatPolygon& area, size_t k, double maxDistance,
+                 std::vector<std::pair<double, uint32_t>>& out) const;
+};
+
+#endif // HAZARD_LAYER_H
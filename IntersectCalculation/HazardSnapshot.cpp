@@ -0,0 +1,88 @@
+#include "HazardSnapshot.h"
+#include "DatabaseHandler.h"
+#include "Logger.h"
+#include <algorithm>
+#include <exception>
+
+HazardSnapshot::HazardSnapshot(const std::string& shapefilePath, const ShapefileFilter& filter,
+                               const std::string& hazardName, CoordinateStorage storage,
+                               size_t edgeGridMinPoints)
+    : wildfires(shapefilePath, filter, hazardName, storage, edgeGridMinPoints), storage(storage), loadTime(0) {
+}
+
+bool HazardSnapshot::load() {
+    auto start = std::chrono::steady_clock::now();
+
+    try {
+        DatabaseHandler db("polygons_db", "5432", "polygons_db", "polygons_user", "polygons_pass");
+        bool ok = db.streamLandProperties(10000, [this](std::vector<LandProperty>&& batch) {
+            for (const auto& property : batch) {
+                if (storage == CoordinateStorage::Quantized) {
+                    parcelSlots[property.getId()] = quantizedParcels.add(FlatPolygon(property.getRing()));
+                } else {
+                    parcelSlots[property.getId()] = static_cast<uint32_t>(parcels.size());
+                    parcels.emplace_back(property.getRing());
+                }
+            }
+            return true;
+        });
+        if (!ok) {
+            return false;
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Snapshot parcel load failed: " << e.what());
+        return false;
+    }
+
+    quantizedParcels.shrinkToFit();
+
+    if (!wildfires.load()) {
+        LOG_WARN("Snapshot has no wildfire polygons");
+    }
+
+    loadTime = std::chrono::steady_clock::now() - start;
+    size_t parcelBytes = quantizedParcels.getMemoryUsage();
+    for (const auto& parcel : parcels) {
+        parcelBytes += parcel.getMemoryUsage();
+    }
+    LOG_INFO("Snapshot loaded: " << getParcelCount() << " parcels (" << parcelBytes / 1024 << " KiB of coordinates), "
+             << wildfires.size() << " wildfires in " << std::chrono::duration<double>(loadTime).count() << " s");
+    return true;
+}
+
+size_t HazardSnapshot::getParcelCount() const {
+    return storage == CoordinateStorage::Quantized ? quantizedParcels.size() : parcels.size();
+}
+
+const HazardLayer& HazardSnapshot::getWildfires() const {
+    return wildfires;
+}
+
+std::chrono::steady_clock::duration HazardSnapshot::getLoadTime() const {
+    return loadTime;
+}
+
+const FlatPolygon* HazardSnapshot::findParcel(int parcelId, FlatPolygon& scratch) const {
+    auto it = parcelSlots.find(parcelId);
+    if (it == parcelSlots.end()) {
+        return nullptr;
+    }
+    return storage == CoordinateStorage::Quantized ? &quantizedParcels.get(it->second, scratch)
+                                                   : &parcels[it->second];
+}
+
+void HazardSnapshot::queryPoint(double x, double y, std::vector<HazardProtocol::HazardHit>& hits) const {
+    wildfires.forEachContaining(x, y, [&](uint32_t slot) {
+        hits.push_back(HazardProtocol::HazardHit{wildfires.getPolygonId(slot), 0, 0.0});
+    });
+}
+
+double HazardSnapshot::queryArea(const FlatPolygon& area, std::vector<HazardProtocol::HazardHit>& hits) const {
+    std::vector<std::pair<uint32_t, double>> overlaps;
+    double covered = wildfires.intersectionArea(area, &overlaps);
+    for (const auto& [slot, overlap] : overlaps) {
+        hits.push_back(HazardProtocol::HazardHit{wildfires.getPolygonId(slot), 0, overlap});
+    }
+    double areaSize = area.getArea();
+    return areaSize > 0.0 ? std::min(1.0, covered / areaSize) : 0.0;
+}
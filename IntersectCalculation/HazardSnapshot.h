@@ -0,0 +1,52 @@
+#ifndef HAZARD_SNAPSHOT_H
+#define HAZARD_SNAPSHOT_H
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AreaClipper.h"
+#include "HazardLayer.h"
+#include "HazardProtocol.h"
+#include "QuantizedPolygonStore.h"
+
+// Everything the daemon answers queries from: parcels, wildfires, validity
+// flags and the wildfire R-tree. Loaded as a whole, never modified after
+// load(), and swapped atomically on reload so in-flight queries keep the
+// snapshot they started with.
+class HazardSnapshot {
+private:
+    HazardLayer wildfires;
+    CoordinateStorage storage;
+    std::vector<FlatPolygon> parcels;                   // Double storage
+    QuantizedPolygonStore quantizedParcels;             // Quantized storage
+    std::unordered_map<int, uint32_t> parcelSlots;     // parcel id -> index into parcels
+    std::chrono::steady_clock::duration loadTime;
+
+public:
+    HazardSnapshot(const std::string& shapefilePath, const ShapefileFilter& filter,
+                   const std::string& hazardName = "wildfire",
+                   CoordinateStorage storage = CoordinateStorage::Double,
+                   size_t edgeGridMinPoints = EdgeGrid::kDefaultMinPoints);
+
+    // Load parcels from the database and the wildfire layer
+    bool load();
+
+    size_t getParcelCount() const;
+    const HazardLayer& getWildfires() const;
+    std::chrono::steady_clock::duration getLoadTime() const;
+
+    // Parcel polygon, nullptr if unknown. Quantized parcels are rebuilt in
+    // scratch, which is returned.
+    const FlatPolygon* findParcel(int parcelId, FlatPolygon& scratch) const;
+
+    // Valid wildfires containing the point
+    void queryPoint(double x, double y, std::vector<HazardProtocol::HazardHit>& hits) const;
+
+    // Valid wildfires overlapping the area, with intersection areas.
+    // Returns the burned fraction of the area (0..1); wildfires overlapping
+    // each other count once.
+    double queryArea(const FlatPolygon& area, std::vector<HazardProtocol::HazardHit>& hits) const;
+};
+
+#endif // HAZARD_SNAPSHOT_H
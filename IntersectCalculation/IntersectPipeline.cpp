@@ -0,0 +1,697 @@
+#include "IntersectPipeline.h"
+#include "GeometryHash.h"
+#include "Logger.h"
+#include "OwnerDictionary.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <future>
+#include <iomanip>
+#include <map>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static double toSeconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+IntersectPipeline::IntersectPipeline(const PipelineConfig& config)
+    : config(config), affectedCount(0), routedCount(0), inputHash(0), committedRows(0), committedLastId(-1),
+      fingerprintSeconds(0.0) {
+    if (this->config.hazards.size() > PipelineConfig::kMaxHazardLayers) {
+        LOG_WARN("Only the first " << PipelineConfig::kMaxHazardLayers << " hazard layers are used");
+        this->config.hazards.resize(PipelineConfig::kMaxHazardLayers);
+    }
+    hazards.reserve(this->config.hazards.size());
+    for (const auto& layer : this->config.hazards) {
+        hazards.emplace_back(layer.shapefilePath, layer.filter, layer.name, config.storage,
+                             config.edgeGridMinPoints);
+    }
+    layerAffectedCounts.assign(hazards.size(), 0);
+    loadStats.threads = static_cast<unsigned>(std::max<size_t>(1, hazards.size()));
+    if (this->config.joinWorkers == 0) {
+        this->config.joinWorkers = 1;
+    }
+    if (this->config.batchSize == 0) {
+        this->config.batchSize = 1;
+    }
+    joinStats.threads = this->config.joinWorkers;
+    if (!this->config.checkpointPath.empty()) {
+        checkpoints = std::make_unique<CheckpointStore>(this->config.checkpointPath);
+    }
+}
+
+void IntersectPipeline::ResultBatch::merge(ResultBatch&& part) {
+    parts = std::max(parts, part.parts);
+    if (part.rows > 0) {
+        rows += part.rows;
+        lastId = part.lastId;
+    }
+    results.insert(results.end(), part.results.begin(), part.results.end());
+    for (const auto& [ownerId, aggregate] : part.owners) {
+        owners[ownerId].merge(aggregate);
+    }
+    costs.insert(costs.end(), part.costs.begin(), part.costs.end());
+    released.insert(released.end(), part.released.begin(), part.released.end());
+}
+
+size_t IntersectPipeline::getAffectedCount() const {
+    return affectedCount;
+}
+
+const std::vector<size_t>& IntersectPipeline::getLayerAffectedCounts() const {
+    return layerAffectedCounts;
+}
+
+const std::vector<HazardLayer>& IntersectPipeline::getHazards() const {
+    return hazards;
+}
+
+const ParcelBitmap& IntersectPipeline::getAffectedParcels() const {
+    return affectedParcels;
+}
+
+const OwnerAggregateMap& IntersectPipeline::getOwnerAggregates() const {
+    return ownerAggregates;
+}
+
+const std::vector<QuarantineRecord>& IntersectPipeline::getQuarantine() const {
+    return quarantine;
+}
+
+const std::vector<int>& IntersectPipeline::getReleased() const {
+    return released;
+}
+
+static double toMilliseconds(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+bool IntersectPipeline::routeToSlowLane(const LandProperty& property, const FlatPolygon& parcel) const {
+    if (config.budget.overVertices(parcel.getNumPoints())) {
+        return true;
+    }
+    // A changed geometry gets another chance on the main pass
+    auto known = config.quarantinedParcels.find(property.getId());
+    return known != config.quarantinedParcels.end() && known->second == hashRing(property.getRing());
+}
+
+void IntersectPipeline::joinBatch(std::vector<LandProperty>& parcels, ResultBatch& results,
+                                  std::vector<LandProperty>& slow) const {
+    for (auto& property : parcels) {
+        FlatPolygon parcel(property.getRing());
+        if (routeToSlowLane(property, parcel)) {
+            slow.push_back(std::move(property));
+            continue;
+        }
+        // The join gives up as soon as the deadline passes and the parcel
+        // starts over in the slow lane, which measures and quarantines it
+        JoinDeadline deadline(config.budget.timeMs);
+        if (!joinParcel(property, parcel, results, &deadline)) {
+            slow.push_back(std::move(property));
+            continue;
+        }
+        double elapsedMs = deadline.elapsedMs();
+        if (config.budget.overTime(elapsedMs)) {
+            results.costs.push_back(QuarantineRecord{property.getId(), hashRing(property.getRing()), "join",
+                                             static_cast<size_t>(parcel.getNumPoints()), elapsedMs});
+        }
+    }
+}
+
+bool IntersectPipeline::joinParcel(const LandProperty& property, const FlatPolygon& parcel,
+                                   ResultBatch& results, const JoinDeadline* deadline) const {
+    // Parcels without area are still matched and counted; a ring of fewer
+    // than 4 points has no geometry to match
+    double parcelArea = parcel.getArea();
+    ParcelResult result{property.getId(), property.getOwnerId(), 0, 0.0, -1.0, -1};
+    for (size_t layer = 0; layer < hazards.size() && !parcel.isEmpty(); layer++) {
+        if (matchLayer(layer, parcel, result)) {
+            result.hazardMask |= 1u << layer;
+        }
+    }
+    if (deadline != nullptr && deadline->cutShort()) {
+        return false;
+    }
+
+    // The batch's own partial; merged when the batch is committed
+    OwnerAggregate& owner = results.owners[result.ownerId];
+    owner.parcelCount++;
+    owner.totalArea += parcelArea;
+    if (result.hazardMask != 0) {
+        owner.affectedCount++;
+        owner.affectedArea += config.mode == JoinMode::Overlap ? result.burnedFraction * parcelArea : parcelArea;
+        results.results.push_back(std::move(result));
+    }
+    return true;
+}
+
+bool IntersectPipeline::matchLayer(size_t layer, const FlatPolygon& parcel, ParcelResult& result) const {
+    // Each layer's R-tree yields the polygons near the parcel, minus invalid
+    // ones. Layer 0 is evaluated in full for the result fields, the other
+    // layers stop at their first match.
+    const HazardLayer& hazard = hazards[layer];
+    switch (config.mode) {
+        case JoinMode::Overlap:
+            if (layer == 0) {
+                // Affected means sharing a point with a perimeter, as with a
+                // GEOS intersection; the burned fraction is reported apart and
+                // is 0 for parcels that only touch one or have no area
+                double parcelArea = parcel.getArea();
+                double burnedArea = parcelArea > 0.0 ? hazard.intersectionArea(parcel) : 0.0;
+                if (burnedArea > 0.0) {
+                    result.burnedFraction = std::min(1.0, burnedArea / parcelArea);
+                    return true;
+                }
+                return hazard.intersects(parcel);
+            }
+            return hazard.intersects(parcel);
+        case JoinMode::Within:
+            if (layer != 0) {
+                return hazard.isWithin(parcel, config.distance);
+            }
+            break;
+        case JoinMode::Nearest:
+            break;
+    }
+
+    std::vector<std::pair<double, uint32_t>> nearest;
+    hazard.nearest(parcel, 1, config.distance, nearest);
+    if (nearest.empty()) {
+        return false;
+    }
+    if (layer == 0) {
+        result.distance = nearest[0].first;
+        result.nearestId = hazard.getPolygonId(nearest[0].second);
+    }
+    return true;
+}
+
+// CSV field in quotes, embedded quotes doubled
+static void writeQuoted(std::ofstream& output, const std::string& text) {
+    output << '"';
+    for (char c : text) {
+        output << c;
+        if (c == '"') {
+            output << '"';
+        }
+    }
+    output << '"';
+}
+
+static void writeCsvRow(std::ofstream& output, const ParcelResult& result) {
+    output << result.id << ',';
+    writeQuoted(output, OwnerDictionary::instance().name(result.ownerId));
+    output << ',' << result.hazardMask << ',' << result.burnedFraction << ','
+           << result.distance << ',' << result.nearestId << '\n';
+}
+
+void IntersectPipeline::commitBatch(const ResultBatch& batch, std::ofstream& output) {
+    for (const auto& result : batch.results) {
+        LOG_DEBUG("Land Property ID " << result.id
+                  << " owned by " << OwnerDictionary::instance().name(result.ownerId)
+                  << " has hazard mask 0x" << std::hex << result.hazardMask << std::dec
+                  << " (" << hazards[0].getName() << " fraction " << result.burnedFraction
+                  << ", distance " << result.distance << ").");
+        if (output.is_open()) {
+            writeCsvRow(output, result);
+        }
+        if (result.id >= 0) {
+            affectedParcels.add(static_cast<uint32_t>(result.id));
+        }
+        for (size_t layer = 0; layer < hazards.size(); layer++) {
+            if (result.hazardMask & (1u << layer)) {
+                layerAffectedCounts[layer]++;
+            }
+        }
+    }
+    affectedCount += batch.results.size();
+    for (const auto& [ownerId, aggregate] : batch.owners) {
+        ownerAggregates[ownerId].merge(aggregate);
+    }
+    quarantine.insert(quarantine.end(), batch.costs.begin(), batch.costs.end());
+    released.insert(released.end(), batch.released.begin(), batch.released.end());
+    committedRows += batch.rows;
+    if (batch.rows > 0) {
+        committedLastId = batch.lastId;
+    }
+}
+
+bool IntersectPipeline::computeInputHash(DatabaseHandler& db) {
+    uint64_t hash = kFnvOffsetBasis;
+    auto mix = [&hash](const void* data, size_t size) {
+        hash = fnv1a(hash, data, size);
+    };
+    auto mixString = [&mix](const std::string& text) {
+        const uint64_t size = text.size();
+        mix(&size, sizeof(size));
+        mix(text.data(), text.size());
+    };
+
+    // Settings that change which parcels are fetched, in what order, or
+    // what is reported for them
+    mix(&config.mode, sizeof(config.mode));
+    mix(&config.distance, sizeof(config.distance));
+    mix(&config.storage, sizeof(config.storage));
+    const uint64_t parcelExtents = config.parcelExtents;
+    mix(&parcelExtents, sizeof(parcelExtents));
+    mixString(config.outputPath);
+
+    for (const auto& layer : config.hazards) {
+        mixString(layer.name);
+        mixString(layer.shapefilePath);
+        mixString(layer.filter.where);
+        mix(&layer.filter.hasExtent, sizeof(layer.filter.hasExtent));
+        if (layer.filter.hasExtent) {
+            const double extent[4] = {layer.filter.extent.MinX, layer.filter.extent.MinY,
+                                      layer.filter.extent.MaxX, layer.filter.extent.MaxY};
+            mix(extent, sizeof(extent));
+        }
+        // Source files by size and modification time, like the daemon's
+        // reload check; the validity and repair tables by content
+        std::filesystem::path shapefile(layer.shapefilePath);
+        for (const char* extension : {".shp", ".dbf"}) {
+            std::error_code error;
+            const std::filesystem::path file = std::filesystem::path(shapefile).replace_extension(extension);
+            const int64_t stamp[2] = {
+                static_cast<int64_t>(std::filesystem::file_size(file, error)),
+                static_cast<int64_t>(std::filesystem::last_write_time(file, error).time_since_epoch().count())};
+            mix(stamp, sizeof(stamp));
+        }
+        for (const std::string& table : {"invalid_" + layer.name, "repaired_" + layer.name}) {
+            uint64_t tableHash;
+            if (!db.fingerprintTable(table, tableHash)) {
+                return false;
+            }
+            mix(&tableHash, sizeof(tableHash));
+        }
+    }
+
+    uint64_t parcelsHash;
+    if (!db.fingerprintParcels(parcelsHash)) {
+        return false;
+    }
+    mix(&parcelsHash, sizeof(parcelsHash));
+    inputHash = hash;
+    return true;
+}
+
+bool IntersectPipeline::resumeCheckpoint(DatabaseHandler& db, StreamResume& resume) {
+    auto start = Clock::now();
+    const bool hashed = computeInputHash(db);
+    fingerprintSeconds = toSeconds(Clock::now() - start);
+    if (!hashed) {
+        LOG_WARN("Cannot fingerprint the run inputs, checkpoints disabled");
+        checkpoints.reset();
+        return false;
+    }
+    LOG_INFO("Run inputs hash to " << std::hex << inputHash << std::dec << " (" << std::fixed
+             << std::setprecision(3) << fingerprintSeconds << " s)");
+
+    RunCheckpoint checkpoint;
+    bool found = false;
+    if (!checkpoints->load(inputHash, checkpoint, found) || !found) {
+        return false;
+    }
+    if (checkpoint.layerAffectedCounts.size() != hazards.size()) {
+        LOG_WARN("Checkpoint in " << checkpoints->getLocation() << " has other hazard layers, starting over");
+        return false;
+    }
+    // Rows written after the checkpoint are cut, the rest is kept
+    if (!config.outputPath.empty()) {
+        std::error_code error;
+        const uintmax_t size = std::filesystem::file_size(config.outputPath, error);
+        if (!error && size >= checkpoint.outputBytes) {
+            std::filesystem::resize_file(config.outputPath, checkpoint.outputBytes, error);
+        }
+        if (error || size < checkpoint.outputBytes) {
+            LOG_WARN("Output " << config.outputPath << " does not match the checkpoint, starting over");
+            return false;
+        }
+    }
+
+    affectedCount = checkpoint.affectedCount;
+    layerAffectedCounts.assign(checkpoint.layerAffectedCounts.begin(), checkpoint.layerAffectedCounts.end());
+    affectedParcels = std::move(checkpoint.affectedParcels);
+    for (const auto& owner : checkpoint.owners) {
+        OwnerAggregate& aggregate = ownerAggregates[OwnerDictionary::instance().intern(owner.name)];
+        aggregate.parcelCount = owner.parcelCount;
+        aggregate.affectedCount = owner.affectedCount;
+        aggregate.totalArea = owner.totalArea;
+        aggregate.affectedArea = owner.affectedArea;
+    }
+    quarantine = std::move(checkpoint.quarantine);
+    released = std::move(checkpoint.released);
+    committedRows = checkpoint.parcelRows;
+    committedLastId = checkpoint.lastParcelId;
+    resume.rows = committedRows;
+    resume.lastId = committedLastId;
+    LOG_INFO("Resuming from the checkpoint in " << checkpoints->getLocation() << ": " << committedRows
+             << " parcels done up to parcel " << committedLastId << ", " << affectedCount << " affected");
+    return true;
+}
+
+void IntersectPipeline::saveCheckpoint(std::ofstream& output) {
+    RunCheckpoint checkpoint;
+    checkpoint.inputHash = inputHash;
+    checkpoint.parcelRows = committedRows;
+    checkpoint.lastParcelId = committedLastId;
+    if (output.is_open()) {
+        output.flush();
+        checkpoint.outputBytes = static_cast<uint64_t>(output.tellp());
+    }
+    checkpoint.affectedCount = affectedCount;
+    checkpoint.layerAffectedCounts.assign(layerAffectedCounts.begin(), layerAffectedCounts.end());
+    checkpoint.affectedParcels = affectedParcels;
+    checkpoint.owners.reserve(ownerAggregates.size());
+    for (const auto& [ownerId, aggregate] : ownerAggregates) {
+        checkpoint.owners.push_back(RunCheckpoint::Owner{OwnerDictionary::instance().name(ownerId),
+                                                         aggregate.parcelCount, aggregate.affectedCount,
+                                                         aggregate.totalArea, aggregate.affectedArea});
+    }
+    checkpoint.quarantine = quarantine;
+    checkpoint.released = released;
+    if (checkpoints->save(checkpoint)) {
+        LOG_DEBUG("Checkpoint at parcel " << committedRows << " (id " << committedLastId << "), "
+                  << checkpoints->getLastSize() / 1024 << " KiB");
+    }
+}
+
+bool IntersectPipeline::run(DatabaseHandler& db) {
+    auto runStart = Clock::now();
+    BoundedQueue<ParcelBatch> parcelQueue(config.queueCapacity);
+    BoundedQueue<ResultBatch> resultQueue(config.queueCapacity);
+
+    // A checkpoint of the same inputs restores the totals of the parcels
+    // it covers, and the fetch continues after them
+    StreamResume resume;
+    const bool resumed = checkpoints && resumeCheckpoint(db, resume);
+
+    // Stage 1a: one loader per hazard layer (shapefile, validity flags,
+    // repairs, index); the last one to finish releases the join
+    std::promise<void> hazardsLoaded;
+    std::shared_future<void> hazardsReady = hazardsLoaded.get_future().share();
+    std::atomic<size_t> pendingLoads{hazards.size()};
+    std::vector<std::thread> loaders;
+    for (auto& layer : hazards) {
+        loaders.emplace_back([&] {
+            auto start = Clock::now();
+            if (!layer.load()) {
+                LOG_WARN("No " << layer.getName() << " polygons loaded from " << layer.getShapefilePath());
+            }
+            loadStats.items += layer.size();
+            loadStats.addBusy(Clock::now() - start);
+            if (--pendingLoads == 0) {
+                hazardsLoaded.set_value();
+            }
+        });
+    }
+    if (hazards.empty()) {
+        hazardsLoaded.set_value();
+    }
+
+    // Stage 1b: parcel cursor, concurrently with the shapefile loads unless
+    // the query is narrowed to the hazard extents
+    bool fetchOk = true;
+    std::thread fetcher([&] {
+        auto start = Clock::now();
+        size_t sequence = 0;
+        auto consume = [&](std::vector<LandProperty>&& parcels) {
+            fetchStats.items += parcels.size();
+            return parcelQueue.push(ParcelBatch{sequence++, std::move(parcels)});
+        };
+        StreamResume* from = resumed ? &resume : nullptr;
+
+        // Distance modes widen the extents by the range; an unbounded
+        // nearest search needs every parcel
+        const bool bounded = config.mode == JoinMode::Overlap || std::isfinite(config.distance);
+        const double margin = config.mode == JoinMode::Overlap ? 0.0 : config.distance;
+        bool pushdown = config.parcelExtents > 0 && bounded;
+        if (pushdown && !db.hasEnvelopeColumns()) {
+            LOG_WARN("Parcel envelope columns unavailable, fetching all parcels");
+            pushdown = false;
+        }
+        Clock::duration loadWait{0};
+        if (pushdown) {
+            auto waitStart = Clock::now();
+            hazardsReady.wait();
+            loadWait = Clock::now() - waitStart;
+
+            // One parcel query for all layers: their boxes merged into one cover
+            std::vector<OGREnvelope> boxes;
+            size_t validCount = 0;
+            for (const auto& layer : hazards) {
+                std::vector<OGREnvelope> layerBoxes = layer.getExtents(config.parcelExtents);
+                boxes.insert(boxes.end(), layerBoxes.begin(), layerBoxes.end());
+                validCount += layer.size() - layer.getInvalidCount();
+            }
+            std::vector<OGREnvelope> extents = SpatialIndex::coverEnvelopes(std::move(boxes), config.parcelExtents);
+            for (auto& extent : extents) {
+                extent.MinX -= margin;
+                extent.MinY -= margin;
+                extent.MaxX += margin;
+                extent.MaxY += margin;
+            }
+            LOG_INFO("Fetching parcels inside " << extents.size() << " extents covering "
+                     << validCount << " valid hazard polygons in " << hazards.size() << " layers");
+            fetchOk = db.streamLandProperties(config.batchSize, extents, consume, from);
+        } else {
+            fetchOk = db.streamLandProperties(config.batchSize, consume, from);
+        }
+        parcelQueue.close();
+        fetchStats.addBusy(Clock::now() - start - loadWait - parcelQueue.getStats().pushWait);
+    });
+
+    // Stage 2: join workers start as soon as every layer is in memory.
+    // Parcels routed to the slow lane never hold up a worker's batch; the
+    // slow lane drains them in parallel, sends the rest of the batch under
+    // the same sequence number and closes the result queue last.
+    ProgressSummary joinProgress("Parcels joined");
+    BoundedQueue<ParcelBatch> slowQueue(std::numeric_limits<size_t>::max());
+    std::atomic<unsigned> activeWorkers{config.joinWorkers};
+    std::vector<std::thread> joiners;
+    for (unsigned w = 0; w < config.joinWorkers; w++) {
+        joiners.emplace_back([&] {
+            hazardsReady.wait();
+            while (auto batch = parcelQueue.pop()) {
+                auto start = Clock::now();
+                ResultBatch results;
+                results.sequence = batch->sequence;
+                results.rows = batch->parcels.size();
+                results.lastId = batch->parcels.empty() ? -1 : batch->parcels.back().getId();
+                ParcelBatch slow{batch->sequence, {}};
+                joinBatch(batch->parcels, results, slow.parcels);
+                joinStats.items += batch->parcels.size() - slow.parcels.size();
+                joinProgress.add(batch->parcels.size() - slow.parcels.size());
+                joinStats.addBusy(Clock::now() - start);
+                if (!slow.parcels.empty()) {
+                    results.parts = 2;
+                    slowQueue.push(std::move(slow));
+                }
+                // Sent even without results: the report stage counts the rows
+                resultQueue.push(std::move(results));
+            }
+            if (--activeWorkers == 0) {
+                slowQueue.close();
+            }
+        });
+    }
+
+    // Slow lane: no budget, costs re-measured; parcels back within budget
+    // leave the quarantine
+    std::thread slowLane([&] {
+        while (auto batch = slowQueue.pop()) {
+            auto start = Clock::now();
+            ResultBatch results;
+            results.sequence = batch->sequence;
+            results.parts = 2;
+            for (const auto& property : batch->parcels) {
+                FlatPolygon parcel(property.getRing());
+                auto parcelStart = Clock::now();
+                joinParcel(property, parcel, results);
+                double elapsedMs = toMilliseconds(Clock::now() - parcelStart);
+                const bool known = config.quarantinedParcels.count(property.getId()) > 0;
+                routedCount += known;
+                const size_t vertices = static_cast<size_t>(parcel.getNumPoints());
+                if (config.budget.overVertices(vertices) || config.budget.overTime(elapsedMs)) {
+                    results.costs.push_back(QuarantineRecord{property.getId(), hashRing(property.getRing()),
+                                                             "join", vertices, elapsedMs});
+                } else if (known) {
+                    results.released.push_back(property.getId());
+                }
+            }
+            slowStats.items += batch->parcels.size();
+            joinProgress.add(batch->parcels.size());
+            slowStats.addBusy(Clock::now() - start);
+            resultQueue.push(std::move(results));
+        }
+        resultQueue.close();
+    });
+
+    // Stage 3: report on the calling thread; per-parcel lines are debug only
+    // unless a CSV output is configured
+    std::ofstream output;
+    if (!config.outputPath.empty()) {
+        if (resumed) {
+            // Already cut back to the checkpoint; continue after it
+            output.open(config.outputPath, std::ios::in | std::ios::out);
+            output.seekp(0, std::ios::end);
+        } else {
+            output.open(config.outputPath);
+            output << "parcel_id,owner,hazard_mask,burned_fraction,distance,nearest_polygon_id\n";
+        }
+        if (!output) {
+            LOG_ERROR("Cannot open output file " << config.outputPath);
+        }
+        output << std::setprecision(10);
+    }
+
+    // A batch is committed once all its parts are in and every earlier
+    // batch is committed; later ones wait in pending
+    struct PendingBatch {
+        ResultBatch batch;
+        unsigned received = 0;
+    };
+    std::map<size_t, PendingBatch> pending;
+    size_t nextSequence = 0;
+    size_t checkpointRows = committedRows;
+    auto lastCheckpoint = Clock::now();
+    const auto checkpointInterval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(config.checkpointInterval));
+    ProgressSummary affectedProgress("Affected parcels");
+    while (auto part = resultQueue.pop()) {
+        auto start = Clock::now();
+        PendingBatch& entry = pending[part->sequence];
+        if (entry.received++ == 0) {
+            entry.batch = std::move(*part);
+        } else {
+            entry.batch.merge(std::move(*part));
+        }
+        while (!pending.empty() && pending.begin()->first == nextSequence &&
+               pending.begin()->second.received == pending.begin()->second.batch.parts) {
+            const ResultBatch& batch = pending.begin()->second.batch;
+            commitBatch(batch, output);
+            affectedProgress.add(batch.results.size());
+            reportStats.items += batch.results.size();
+            pending.erase(pending.begin());
+            nextSequence++;
+        }
+        if (checkpoints && committedRows != checkpointRows && start - lastCheckpoint >= checkpointInterval) {
+            saveCheckpoint(output);
+            checkpointRows = committedRows;
+            lastCheckpoint = Clock::now();
+        }
+        reportStats.addBusy(Clock::now() - start);
+    }
+
+    for (auto& loader : loaders) {
+        loader.join();
+    }
+    fetcher.join();
+    for (auto& joiner : joiners) {
+        joiner.join();
+    }
+    slowLane.join();
+
+    // A failed fetch leaves a checkpoint of everything reported for the
+    // next attempt; a complete run needs none
+    if (checkpoints) {
+        if (resumed && !resume.matched) {
+            LOG_ERROR("Checkpoint in " << checkpoints->getLocation()
+                      << " does not match the parcel stream; removed, the next run starts over");
+            checkpoints->remove(inputHash);
+        } else if (!fetchOk) {
+            if (committedRows != checkpointRows) {
+                saveCheckpoint(output);
+            }
+            LOG_INFO("Checkpoint kept at parcel " << committedRows << " (id " << committedLastId << ")");
+        } else {
+            checkpoints->remove(inputHash);
+        }
+    }
+
+    if (slowStats.items > 0 || !quarantine.empty()) {
+        LOG_INFO("Slow lane joined " << slowStats.items.load() << " parcels (" << routedCount
+                 << " quarantined earlier) in " << std::fixed << std::setprecision(3)
+                 << slowStats.busyNanos.load() / 1e9 << " s; " << quarantine.size()
+                 << " parcels over budget, " << released.size() << " released");
+    }
+
+    size_t affectedOwners = 0;
+    for (const auto& entry : ownerAggregates) {
+        affectedOwners += entry.second.affectedCount > 0;
+    }
+    LOG_INFO(affectedOwners << " of " << ownerAggregates.size() << " owners affected (owner dictionary "
+             << OwnerDictionary::instance().size() << " names, "
+             << OwnerDictionary::instance().getMemoryUsage() / 1024 << " KiB)");
+    if (!config.ownerOutputPath.empty()) {
+        writeOwnerCsv();
+    }
+    for (const auto& hazard : hazards) {
+        if (hazard.getEdgeGridCount() > 0) {
+            LOG_INFO(hazard.getName() << ": edge grids built for " << hazard.getEdgeGridCount()
+                     << " large polygons, " << hazard.getEdgeGridMemoryUsage() / 1024 << " KiB");
+        }
+    }
+
+    joinProgress.finish();
+    affectedProgress.finish();
+    printStats(Clock::now() - runStart, parcelQueue.getStats(), resultQueue.getStats());
+    return fetchOk;
+}
+
+void IntersectPipeline::writeOwnerCsv() const {
+    std::ofstream output(config.ownerOutputPath);
+    if (!output) {
+        LOG_ERROR("Cannot open owner output file " << config.ownerOutputPath);
+        return;
+    }
+    output << "owner,parcels,affected_parcels,total_area,affected_area\n" << std::setprecision(10);
+    for (const auto& [ownerId, aggregate] : ownerAggregates) {
+        writeQuoted(output, OwnerDictionary::instance().name(ownerId));
+        output << ',' << aggregate.parcelCount << ',' << aggregate.affectedCount << ','
+               << aggregate.totalArea << ',' << aggregate.affectedArea << '\n';
+    }
+}
+
+void IntersectPipeline::printStats(Clock::duration wall,
+                                   const QueueStats& parcelQueue, const QueueStats& resultQueue) const {
+    const double wallSeconds = toSeconds(wall);
+
+    auto printStage = [wallSeconds](const char* name, const StageStats& stats) {
+        double busy = stats.busyNanos.load() / 1e9;
+        double utilisation = wallSeconds > 0.0 ? 100.0 * busy / (wallSeconds * stats.threads) : 0.0;
+        LOG_INFO(std::fixed << std::setprecision(3)
+                 << "  " << std::left << std::setw(16) << name << std::right
+                 << std::setw(8) << stats.threads
+                 << std::setw(12) << stats.items.load()
+                 << std::setw(10) << busy
+                 << std::setw(9) << utilisation);
+    };
+    auto printQueue = [](const char* name, const QueueStats& stats) {
+        LOG_INFO(std::fixed << std::setprecision(3)
+                 << "  " << name << ": " << stats.pushed << " batches, peak depth " << stats.peakDepth
+                 << ", " << stats.blockedPushes << " blocked pushes, "
+                 << toSeconds(stats.pushWait) << " s backpressure, "
+                 << toSeconds(stats.popWait) << " s starved");
+    };
+
+    LOG_INFO(std::fixed << std::setprecision(3) << "Pipeline stats (wall " << wallSeconds << " s):");
+    LOG_INFO("  stage            threads       items    busy s   util %");
+    printStage("hazard load", loadStats);
+    printStage("parcel fetch", fetchStats);
+    printStage("join", joinStats);
+    printStage("slow lane", slowStats);
+    printStage("report", reportStats);
+    printQueue("parcel queue", parcelQueue);
+    printQueue("result queue", resultQueue);
+    if (checkpoints) {
+        const double saveSeconds = checkpoints->getSaveSeconds();
+        LOG_INFO(std::fixed << std::setprecision(3)
+                 << "  checkpoints: " << checkpoints->getSaveCount() << " saved to " << checkpoints->getLocation()
+                 << " in " << saveSeconds << " s (" << (wallSeconds > 0.0 ? 100.0 * saveSeconds / wallSeconds : 0.0)
+                 << " % of wall), last " << checkpoints->getLastSize() / 1024 << " KiB; input fingerprint "
+                 << fingerprintSeconds << " s");
+    }
+}
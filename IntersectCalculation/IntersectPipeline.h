@@ -0,0 +1,215 @@
+#ifndef INTERSECT_PIPELINE_H
+#define INTERSECT_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BoundedQueue.h"
+#include "DatabaseHandler.h"
+#include "GeometryBudget.h"
+#include "HazardLayer.h"
+#include "JoinDeadline.h"
+#include "LandProperty.h"
+#include "ParcelBitmap.h"
+#include "RunCheckpoint.h"
+
+// One hazard layer of a run; bit i of ParcelResult::hazardMask is layer i
+struct HazardLayerConfig {
+    std::string name = "wildfire";      // validity in invalid_<name>, repairs in repaired_<name>
+    std::string shapefilePath = "/opt/airflow/Dataset_Cali_Wildfire/Wildfires.shp";
+    ShapefileFilter filter;             // --where / --extent, pushed down to OGR
+};
+
+// What a parcel is tested for against each layer
+enum class JoinMode {
+    Overlap,        // positive intersection area
+    Within,         // some polygon within distance
+    Nearest,        // distance to the nearest polygon (within distance, if finite)
+};
+
+struct PipelineConfig {
+    static constexpr size_t kMaxHazardLayers = 32;
+
+    JoinMode mode = JoinMode::Overlap;
+    double distance = std::numeric_limits<double>::infinity();     // Within / Nearest range
+    std::string outputPath;         // per-parcel CSV, empty = none
+    std::string ownerOutputPath;    // per-owner CSV, empty = none
+
+    std::vector<HazardLayerConfig> hazards{HazardLayerConfig()};
+    size_t batchSize = 1000;        // parcels per DB fetch / join task
+    size_t queueCapacity = 8;       // batches buffered between stages
+    unsigned joinWorkers = 4;
+    size_t parcelExtents = 256;     // fire extents pushed into the parcel query, 0 = fetch all
+    CoordinateStorage storage = CoordinateStorage::Double;     // hazard polygon coordinates
+    size_t edgeGridMinPoints = EdgeGrid::kDefaultMinPoints;    // hazard polygons indexed per edge, 0 = none
+
+    // Parcels over the vertex budget, or quarantined with an unchanged
+    // source hash, are joined in the slow lane, and so are parcels whose
+    // join runs past the time budget; those are quarantined for later runs
+    GeometryBudget budget{2000.0, 100000};                      // a parcel join normally takes well under 1 ms
+    std::unordered_map<int, uint64_t> quarantinedParcels;      // parcel id -> source hash
+
+    // Progress checkpoints in a file, or in the intersect_checkpoints table
+    // with "db"; empty = none. A run whose inputs hash like the checkpoint's
+    // resumes from it.
+    std::string checkpointPath;
+    double checkpointInterval = 60.0;   // seconds between checkpoints
+};
+
+// Join output for one parcel touched by at least one hazard layer
+struct ParcelResult {
+    int id;
+    uint32_t ownerId;           // OwnerDictionary id
+    uint32_t hazardMask;        // bit i set if layer i matched the parcel
+    double burnedFraction;      // covered fraction for layer 0 (Overlap mode)
+    double distance;            // to the nearest layer 0 polygon, -1 if not computed or none in range
+    int nearestId;              // its stable polygon id, -1 if none
+};
+
+// Per-owner totals over the parcels the run fetched. Affected area is the
+// burned area in Overlap mode and the area of matched parcels otherwise.
+struct OwnerAggregate {
+    size_t parcelCount = 0;
+    size_t affectedCount = 0;
+    double totalArea = 0.0;
+    double affectedArea = 0.0;
+
+    void merge(const OwnerAggregate& other) {
+        parcelCount += other.parcelCount;
+        affectedCount += other.affectedCount;
+        totalArea += other.totalArea;
+        affectedArea += other.affectedArea;
+    }
+};
+
+using OwnerAggregateMap = std::unordered_map<uint32_t, OwnerAggregate>;
+
+// Busy time and item count of one pipeline stage
+struct StageStats {
+    std::atomic<long long> busyNanos{0};
+    std::atomic<size_t> items{0};
+    unsigned threads = 1;
+
+    void addBusy(std::chrono::steady_clock::duration d) {
+        busyNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+};
+
+// Staged intersection run:
+//
+//   hazard layer loads ────────┐
+//   parcel fetch ─[batches]─> join workers ─[results]─> report
+//                                  └─[slow parcels]─> slow lane ─┘
+//
+// Hazard layers load in parallel with each other and with the parcel cursor,
+// parcel batches flow through bounded queues as they arrive, and a full
+// queue blocks the producing stage instead of buffering the whole table in
+// memory. Every parcel is fetched once and tested against all layers.
+//
+// With parcelExtents > 0 the fetch waits for the layers and asks the
+// database only for parcels whose envelope overlaps the merged extents.
+// A join worker gives a parcel up as soon as its JoinDeadline passes,
+// polled inside the clipping and candidate loops, and hands it to the slow
+// lane, so a costly parcel never holds up a worker's batch for longer than
+// the time budget.
+//
+// Batches are numbered as fetched and the report stage commits them in that
+// order, so its totals always cover a prefix of the parcel stream; that
+// prefix (row count and last parcel id) is what a checkpoint records.
+class IntersectPipeline {
+private:
+    struct ParcelBatch {
+        size_t sequence = 0;
+        std::vector<LandProperty> parcels;
+    };
+
+    // Join output of a parcel batch: one part, or two when some of its
+    // parcels went through the slow lane
+    struct ResultBatch {
+        size_t sequence = 0;
+        unsigned parts = 1;
+        size_t rows = 0;            // parcels fetched in the batch (join worker part)
+        int lastId = -1;            // id of the last of them
+        std::vector<ParcelResult> results;
+        OwnerAggregateMap owners;
+        std::vector<QuarantineRecord> costs;    // over budget
+        std::vector<int> released;              // quarantined, now within budget
+
+        void merge(ResultBatch&& part);
+    };
+
+    PipelineConfig config;
+    std::vector<HazardLayer> hazards;
+    size_t affectedCount;
+    std::vector<size_t> layerAffectedCounts;
+    ParcelBitmap affectedParcels;
+    OwnerAggregateMap ownerAggregates;
+    std::vector<QuarantineRecord> quarantine;   // over budget in this run
+    std::vector<int> released;                  // quarantined, now within budget
+    size_t routedCount;                         // quarantined earlier, sent to the slow lane
+
+    std::unique_ptr<CheckpointStore> checkpoints;
+    uint64_t inputHash;
+    size_t committedRows;                       // stream prefix the totals cover, resumed rows included
+    int committedLastId;
+    double fingerprintSeconds;
+
+    StageStats loadStats;
+    StageStats fetchStats;
+    StageStats joinStats;
+    StageStats slowStats;
+    StageStats reportStats;
+
+    // Join the parcels; those for the slow lane are moved to slow
+    void joinBatch(std::vector<LandProperty>& parcels, ResultBatch& results,
+                   std::vector<LandProperty>& slow) const;
+    // False, with nothing recorded, if deadline cut the join short
+    bool joinParcel(const LandProperty& property, const FlatPolygon& parcel, ResultBatch& results,
+                    const JoinDeadline* deadline = nullptr) const;
+    bool routeToSlowLane(const LandProperty& property, const FlatPolygon& parcel) const;
+    bool matchLayer(size_t layer, const FlatPolygon& parcel, ParcelResult& result) const;
+    // Add a complete batch to the totals and the per-parcel CSV
+    void commitBatch(const ResultBatch& batch, std::ofstream& output);
+
+    // Hash of everything the results depend on: join settings, hazard
+    // source files and the tables read by the join
+    bool computeInputHash(DatabaseHandler& db);
+    // Restore the totals of a checkpoint with this run's input hash; resume
+    // tells the fetch where to continue
+    bool resumeCheckpoint(DatabaseHandler& db, StreamResume& resume);
+    void saveCheckpoint(std::ofstream& output);
+
+    void writeOwnerCsv() const;
+    void printStats(std::chrono::steady_clock::duration wall,
+                    const QueueStats& parcelQueue, const QueueStats& resultQueue) const;
+
+public:
+    explicit IntersectPipeline(const PipelineConfig& config);
+
+    // Runs all stages to completion; false if the parcel fetch failed.
+    // With checkpoints, a failed run leaves one for the next attempt.
+    bool run(DatabaseHandler& db);
+
+    // Parcels touched by any layer, and by each layer
+    size_t getAffectedCount() const;
+    const std::vector<size_t>& getLayerAffectedCounts() const;
+    const std::vector<HazardLayer>& getHazards() const;
+
+    // Ids of the parcels touched by any layer
+    const ParcelBitmap& getAffectedParcels() const;
+
+    // Merged per-owner totals, keyed by OwnerDictionary id
+    const OwnerAggregateMap& getOwnerAggregates() const;
+
+    // Quarantine changes to store after the run
+    const std::vector<QuarantineRecord>& getQuarantine() const;
+    const std::vector<int>& getReleased() const;
+};
+
+#endif // INTERSECT_PIPELINE_H
@@ -0,0 +1,58 @@
+#ifndef JOIN_DEADLINE_H
+#define JOIN_DEADLINE_H
+
+#include <chrono>
+
+// Time limit for the join of one parcel on the current thread while the
+// object lives. AreaClipper, PolygonDistance and HazardLayer poll passed()
+// in their edge and candidate loops and skip the rest of their work once it
+// is true, so whatever they return is partial and the caller must drop it.
+// Threads without a deadline (slow lane, daemon) are never cut short.
+class JoinDeadline {
+public:
+    // limitMs <= 0: no limit, the object only measures
+    explicit JoinDeadline(double limitMs)
+        : start(Clock::now()), limited(limitMs > 0.0), reached(false), polls(0), outer(active) {
+        deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(limitMs));
+        active = this;
+    }
+    ~JoinDeadline() {
+        active = outer;
+    }
+
+    JoinDeadline(const JoinDeadline&) = delete;
+    JoinDeadline& operator=(const JoinDeadline&) = delete;
+
+    // The deadline of this thread has passed. The clock is read every
+    // kPollInterval calls; once true it stays true.
+    static bool passed() {
+        JoinDeadline* current = active;
+        return current != nullptr && current->poll();
+    }
+
+    // Some loop saw the deadline pass and skipped work
+    bool cutShort() const { return reached; }
+    double elapsedMs() const { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr unsigned kPollInterval = 8;
+
+    Clock::time_point start;
+    Clock::time_point deadline;
+    bool limited;
+    bool reached;
+    unsigned polls;
+    JoinDeadline* outer;        // enclosing deadline of this thread, restored on exit
+
+    static inline thread_local JoinDeadline* active = nullptr;
+
+    bool poll() {
+        if (!reached && limited && ++polls % kPollInterval == 0) {
+            reached = Clock::now() >= deadline;
+        }
+        return reached;
+    }
+};
+
+#endif // JOIN_DEADLINE_H
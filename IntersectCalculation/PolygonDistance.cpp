@@ -0,0 +1,125 @@
+#include "PolygonDistance.h"
+#include "JoinDeadline.h"
+#include "RobustPredicates.h"
+#include <algorithm>
+#include <cmath>
+
+double PolygonDistance::pointSegmentSquared(double px, double py, double ax, double ay, double bx, double by) {
+    const double dx = bx - ax, dy = by - ay;
+    const double len2 = dx * dx + dy * dy;
+    double t = 0.0;
+    if (len2 > 0.0) {
+        t = std::clamp(((px - ax) * dx + (py - ay) * dy) / len2, 0.0, 1.0);
+    }
+    const double ex = ax + t * dx - px, ey = ay + t * dy - py;
+    return ex * ex + ey * ey;
+}
+
+double PolygonDistance::segmentSegmentSquared(double ax, double ay, double bx, double by,
+                                              double cx, double cy, double dx, double dy) {
+    if (RobustPredicates::segmentContact(ax, ay, bx, by, cx, cy, dx, dy) != RobustPredicates::SegmentContact::None) {
+        return 0.0;
+    }
+    // Disjoint segments: the closest pair always involves an endpoint
+    return std::min(std::min(pointSegmentSquared(ax, ay, cx, cy, dx, dy), pointSegmentSquared(bx, by, cx, cy, dx, dy)),
+                    std::min(pointSegmentSquared(cx, cy, ax, ay, bx, by), pointSegmentSquared(dx, dy, ax, ay, bx, by)));
+}
+
+// Squared gap between the box of a-b and a box
+static double segmentBoxSquared(double ax, double ay, double bx, double by,
+                                double minX, double minY, double maxX, double maxY) {
+    const double gx = std::max(0.0, std::max(std::min(ax, bx) - maxX, minX - std::max(ax, bx)));
+    const double gy = std::max(0.0, std::max(std::min(ay, by) - maxY, minY - std::max(ay, by)));
+    return gx * gx + gy * gy;
+}
+
+double PolygonDistance::distance(const FlatPolygon& a, const FlatPolygon& b, double cutoff) {
+    if (a.isEmpty() || b.isEmpty()) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    // Containment without touching boundaries: one polygon's first vertex
+    // lies inside the other. Every other overlap makes two edges meet.
+    if (a.envelopeIntersects(b)) {
+        const FlatRing ra = a.getRing(0);
+        const FlatRing rb = b.getRing(0);
+        if (AreaClipper::containsPoint(b, ra.coords[0], ra.coords[1]) ||
+            AreaClipper::containsPoint(a, rb.coords[0], rb.coords[1])) {
+            return 0.0;
+        }
+    }
+
+    double best = cutoff * cutoff;
+    for (int r = 0; r < a.getNumRings(); ++r) {
+        const FlatRing ring = a.getRing(r);
+        for (int i = 0; i + 1 < ring.numPoints && !JoinDeadline::passed(); ++i) {
+            const double* p = ring.coords + 2 * i;
+            if (segmentBoxSquared(p[0], p[1], p[2], p[3], b.getMinX(), b.getMinY(), b.getMaxX(), b.getMaxY()) >= best) {
+                continue;
+            }
+            for (int s = 0; s < b.getNumRings(); ++s) {
+                const FlatRing other = b.getRing(s);
+                for (int j = 0; j + 1 < other.numPoints; ++j) {
+                    const double* q = other.coords + 2 * j;
+                    // Box gap of the two edges, a lower bound on their distance
+                    const double gx = std::max(0.0, std::max(std::min(p[0], p[2]) - std::max(q[0], q[2]),
+                                                             std::min(q[0], q[2]) - std::max(p[0], p[2])));
+                    const double gy = std::max(0.0, std::max(std::min(p[1], p[3]) - std::max(q[1], q[3]),
+                                                             std::min(q[1], q[3]) - std::max(p[1], p[3])));
+                    if (gx * gx + gy * gy >= best) {
+                        continue;
+                    }
+                    best = std::min(best, segmentSegmentSquared(p[0], p[1], p[2], p[3], q[0], q[1], q[2], q[3]));
+                    if (best == 0.0) {
+                        return 0.0;
+                    }
+                }
+            }
+        }
+    }
+    return std::sqrt(best);
+}
+
+bool PolygonDistance::intersects(const FlatPolygon& a, const FlatPolygon& b, const EdgeGrid* bGrid) {
+    if (!a.envelopeIntersects(b)) {
+        return false;
+    }
+    const FlatRing ra = a.getRing(0);
+    const FlatRing rb = b.getRing(0);
+    if (AreaClipper::containsPoint(b, ra.coords[0], ra.coords[1], bGrid) ||
+        AreaClipper::containsPoint(a, rb.coords[0], rb.coords[1])) {
+        return true;
+    }
+
+    bool found = false;
+    for (int r = 0; r < a.getNumRings() && !found; ++r) {
+        const FlatRing ring = a.getRing(r);
+        for (int i = 0; i + 1 < ring.numPoints && !found && !JoinDeadline::passed(); ++i) {
+            const double* p = ring.coords + 2 * i;
+            const double minX = std::min(p[0], p[2]), maxX = std::max(p[0], p[2]);
+            const double minY = std::min(p[1], p[3]), maxY = std::max(p[1], p[3]);
+            if (segmentBoxSquared(p[0], p[1], p[2], p[3], b.getMinX(), b.getMinY(), b.getMaxX(), b.getMaxY()) > 0.0) {
+                continue;
+            }
+            auto touches = [&](const double* q) {
+                return std::max(q[0], q[2]) >= minX && std::min(q[0], q[2]) <= maxX &&
+                       std::max(q[1], q[3]) >= minY && std::min(q[1], q[3]) <= maxY &&
+                       RobustPredicates::segmentContact(p[0], p[1], p[2], p[3], q[0], q[1], q[2], q[3]) !=
+                           RobustPredicates::SegmentContact::None;
+            };
+            if (bGrid != nullptr) {
+                bGrid->forEachEdge(b, minX, minY, maxX, maxY, [&](int s, int j) {
+                    found = found || touches(b.getRing(s).coords + 2 * j);
+                });
+            } else {
+                for (int s = 0; s < b.getNumRings() && !found; ++s) {
+                    const FlatRing other = b.getRing(s);
+                    for (int j = 0; j + 1 < other.numPoints && !found; ++j) {
+                        found = touches(other.coords + 2 * j);
+                    }
+                }
+            }
+        }
+    }
+    return found;
+}
@@ -0,0 +1,34 @@
+#ifndef POLYGON_DISTANCE_H
+#define POLYGON_DISTANCE_H
+
+#include <limits>
+#include "AreaClipper.h"
+#include "EdgeGrid.h"
+
+// Exact Euclidean distances on FlatPolygon coordinates, without buffering.
+class PolygonDistance {
+public:
+    // Squared distance from (px, py) to the segment a-b
+    static double pointSegmentSquared(double px, double py, double ax, double ay, double bx, double by);
+
+    // Squared distance between segments a-b and c-d (0 when they meet)
+    static double segmentSegmentSquared(double ax, double ay, double bx, double by,
+                                        double cx, double cy, double dx, double dy);
+
+    // Distance between two polygons: 0 when they overlap, touch or one lies
+    // inside the other, otherwise the closest pair of boundary points.
+    // Edge pairs whose boxes are already further than the best distance so
+    // far (or than cutoff) are skipped; a result >= cutoff only means "at
+    // least cutoff".
+    static double distance(const FlatPolygon& a, const FlatPolygon& b,
+                           double cutoff = std::numeric_limits<double>::infinity());
+
+    // True if the polygons share at least one point: they overlap, one lies
+    // inside the other, or their boundaries touch. Boundary contacts use the
+    // exact segment predicates, so touching counts as it does for GEOS, and
+    // polygons without area still match. With bGrid (built from b) only b's
+    // edges near each edge of a are tested.
+    static bool intersects(const FlatPolygon& a, const FlatPolygon& b, const EdgeGrid* bGrid = nullptr);
+};
+
+#endif // POLYGON_DISTANCE_H
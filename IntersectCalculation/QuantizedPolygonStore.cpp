@@ -0,0 +1,226 @@
+#include "QuantizedPolygonStore.h"
+#include "RobustPredicates.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Grid points stay exact doubles (multiples of 2^-10 below 2^42 m)
+static constexpr double kMaxCoordinate = 4398046511104.0;   // 2^42
+
+QuantizedPolygonStore::QuantizedPolygonStore() : quantizedCount(0) {
+}
+
+uint32_t QuantizedPolygonStore::add(const FlatPolygon& polygon) {
+    Record record;
+    if (!quantize(polygon, record)) {
+        addFallback(polygon, record);
+    } else {
+        quantizedCount++;
+    }
+    records.push_back(record);
+    return static_cast<uint32_t>(records.size() - 1);
+}
+
+bool QuantizedPolygonStore::quantize(const FlatPolygon& polygon, Record& record) {
+    if (polygon.isEmpty() ||
+        !(std::fabs(polygon.getMinX()) < kMaxCoordinate && std::fabs(polygon.getMaxX()) < kMaxCoordinate &&
+          std::fabs(polygon.getMinY()) < kMaxCoordinate && std::fabs(polygon.getMaxY()) < kMaxCoordinate)) {
+        return false;
+    }
+    const double tileX = std::floor(polygon.getMinX() / kTileSize);
+    const double tileY = std::floor(polygon.getMinY() / kTileSize);
+    const double originX = tileX * kTileSize;
+    const double originY = tileY * kTileSize;
+
+    // Offsets must stay below 2^31 so edge determinants fit in int64
+    const double maxX = std::ceil((polygon.getMaxX() - originX) * kScale);
+    const double maxY = std::ceil((polygon.getMaxY() - originY) * kScale);
+    if (maxX > INT32_MAX || maxY > INT32_MAX) {
+        return false;
+    }
+    record.tileX = static_cast<int32_t>(tileX);
+    record.tileY = static_cast<int32_t>(tileY);
+    record.minX = static_cast<int32_t>(std::floor((polygon.getMinX() - originX) * kScale));
+    record.minY = static_cast<int32_t>(std::floor((polygon.getMinY() - originY) * kScale));
+    record.maxX = static_cast<int32_t>(maxX);
+    record.maxY = static_cast<int32_t>(maxY);
+    record.firstRing = static_cast<uint32_t>(ringStarts.size());
+    record.numRings = static_cast<uint32_t>(polygon.getNumRings());
+
+    for (int r = 0; r < polygon.getNumRings(); r++) {
+        const FlatRing ring = polygon.getRing(r);
+        ringStarts.push_back(static_cast<uint32_t>(points.size() / 2));
+        for (int i = 0; i < ring.numPoints; i++) {
+            points.push_back(static_cast<int32_t>(std::llround((ring.coords[2 * i] - originX) * kScale)));
+            points.push_back(static_cast<int32_t>(std::llround((ring.coords[2 * i + 1] - originY) * kScale)));
+        }
+    }
+    ringStarts.push_back(static_cast<uint32_t>(points.size() / 2));
+    return true;
+}
+
+void QuantizedPolygonStore::addFallback(const FlatPolygon& polygon, Record& record) {
+    record = Record{0, 0, 0, 0, 0, 0, static_cast<uint32_t>(fallback.size()), kFallback};
+    fallback.push_back(polygon);
+}
+
+size_t QuantizedPolygonStore::size() const {
+    return records.size();
+}
+
+bool QuantizedPolygonStore::isQuantized(uint32_t index) const {
+    return records[index].numRings != kFallback;
+}
+
+size_t QuantizedPolygonStore::getQuantizedCount() const {
+    return quantizedCount;
+}
+
+OGREnvelope QuantizedPolygonStore::getEnvelope(uint32_t index) const {
+    const Record& record = records[index];
+    if (record.numRings == kFallback) {
+        return fallback[record.firstRing].getEnvelope();
+    }
+    const double originX = record.tileX * kTileSize;
+    const double originY = record.tileY * kTileSize;
+    OGREnvelope env;
+    env.MinX = originX + record.minX / kScale;
+    env.MinY = originY + record.minY / kScale;
+    env.MaxX = originX + record.maxX / kScale;
+    env.MaxY = originY + record.maxY / kScale;
+    return env;
+}
+
+bool QuantizedPolygonStore::envelopeIntersects(uint32_t index, const OGREnvelope& box) const {
+    const Record& record = records[index];
+    if (record.numRings == kFallback) {
+        const FlatPolygon& polygon = fallback[record.firstRing];
+        return !polygon.isEmpty() && polygon.getMinX() <= box.MaxX && polygon.getMaxX() >= box.MinX &&
+               polygon.getMinY() <= box.MaxY && polygon.getMaxY() >= box.MinY;
+    }
+    // Widen the box to whole grid steps, then compare integers
+    const double originX = record.tileX * kTileSize;
+    const double originY = record.tileY * kTileSize;
+    const double boxMinX = std::floor((box.MinX - originX) * kScale);
+    const double boxMinY = std::floor((box.MinY - originY) * kScale);
+    const double boxMaxX = std::ceil((box.MaxX - originX) * kScale);
+    const double boxMaxY = std::ceil((box.MaxY - originY) * kScale);
+    return boxMaxX >= record.minX && boxMinX <= record.maxX && boxMaxY >= record.minY && boxMinY <= record.maxY;
+}
+
+int QuantizedPolygonStore::orientation(const Record& record, int64_t ax, int64_t ay, int64_t bx, int64_t by,
+                                       int64_t qx, int64_t qy, double x, double y) {
+    // The point lies within (q - 0.5, q + 1.5) grid steps of the grid
+    // point q, which moves the determinant by less than 2 * (|dx| + |dy|)
+    const int64_t dx = bx - ax;
+    const int64_t dy = by - ay;
+    const int64_t det = dx * (qy - ay) - dy * (qx - ax);
+    const int64_t bound = 2 * (std::llabs(dx) + std::llabs(dy));
+    if (det > bound) {
+        return 1;
+    }
+    if (det < -bound) {
+        return -1;
+    }
+    const double originX = record.tileX * kTileSize;
+    const double originY = record.tileY * kTileSize;
+    return RobustPredicates::orientation(originX + ax / kScale, originY + ay / kScale,
+                                         originX + bx / kScale, originY + by / kScale, x, y);
+}
+
+bool QuantizedPolygonStore::containsPoint(uint32_t index, double x, double y) const {
+    const Record& record = records[index];
+    if (record.numRings == kFallback) {
+        return AreaClipper::containsPoint(fallback[record.firstRing], x, y);
+    }
+    const double originX = record.tileX * kTileSize;
+    const double originY = record.tileY * kTileSize;
+    if (x < originX + record.minX / kScale || x > originX + record.maxX / kScale ||
+        y < originY + record.minY / kScale || y > originY + record.maxY / kScale) {
+        return false;
+    }
+    // Grid point below the query; the subtraction rounds by at most half a step
+    const int64_t qx = static_cast<int64_t>(std::floor((x - originX) * kScale));
+    const int64_t qy = static_cast<int64_t>(std::floor((y - originY) * kScale));
+
+    // Grid coordinates are exact doubles, so the comparisons near the
+    // query are exact; the rest are settled on integers
+    auto atOrBelow = [&](int64_t gy) {
+        return gy < qy || (gy <= qy + 1 && originY + gy / kScale <= y);
+    };
+    auto equalsY = [&](int64_t gy) {
+        return gy >= qy && gy <= qy + 1 && originY + gy / kScale == y;
+    };
+
+    // Even-odd crossings of a ray towards +x; the half-open rule on y
+    // counts a vertex on the ray once
+    bool inside = false;
+    for (uint32_t r = record.firstRing; r < record.firstRing + record.numRings; r++) {
+        const int32_t* p = points.data() + 2 * static_cast<size_t>(ringStarts[r]);
+        const uint32_t numPoints = ringStarts[r + 1] - ringStarts[r];
+        for (uint32_t i = 0; i + 1 < numPoints; i++) {
+            const int64_t ax = p[2 * i], ay = p[2 * i + 1];
+            const int64_t bx = p[2 * i + 2], by = p[2 * i + 3];
+            const bool aBelow = atOrBelow(ay);
+            const bool bBelow = atOrBelow(by);
+            const bool straddles = aBelow != bBelow;
+            // An edge that does not straddle the ray can only hold the point
+            // if it ends exactly on the ray
+            if (!straddles && !(aBelow && equalsY(std::max(ay, by)))) {
+                continue;
+            }
+            const int o = orientation(record, ax, ay, bx, by, qx, qy, x, y);
+            if (o == 0) {
+                // Collinear and within the edge's y range: on the edge if
+                // it straddles, else check the x range of the horizontal run
+                if (straddles || (x >= originX + std::min(ax, bx) / kScale &&
+                                  x <= originX + std::max(ax, bx) / kScale)) {
+                    return true;
+                }
+                continue;
+            }
+            if (straddles && (aBelow ? o > 0 : o < 0)) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+const FlatPolygon& QuantizedPolygonStore::get(uint32_t index, FlatPolygon& scratch) const {
+    const Record& record = records[index];
+    if (record.numRings == kFallback) {
+        return fallback[record.firstRing];
+    }
+    const double originX = record.tileX * kTileSize;
+    const double originY = record.tileY * kTileSize;
+    thread_local std::vector<double> ring;
+    scratch.clear();
+    for (uint32_t r = record.firstRing; r < record.firstRing + record.numRings; r++) {
+        const int32_t* p = points.data() + 2 * static_cast<size_t>(ringStarts[r]);
+        const uint32_t numPoints = ringStarts[r + 1] - ringStarts[r];
+        ring.resize(2 * static_cast<size_t>(numPoints));
+        for (uint32_t i = 0; i < numPoints; i++) {
+            ring[2 * i] = originX + p[2 * i] / kScale;
+            ring[2 * i + 1] = originY + p[2 * i + 1] / kScale;
+        }
+        scratch.addRing(ring.data(), static_cast<int>(numPoints));
+    }
+    return scratch;
+}
+
+void QuantizedPolygonStore::shrinkToFit() {
+    records.shrink_to_fit();
+    ringStarts.shrink_to_fit();
+    points.shrink_to_fit();
+    fallback.shrink_to_fit();
+}
+
+size_t QuantizedPolygonStore::getMemoryUsage() const {
+    size_t bytes = records.capacity() * sizeof(Record) + ringStarts.capacity() * sizeof(uint32_t) +
+                   points.capacity() * sizeof(int32_t);
+    for (const auto& polygon : fallback) {
+        bytes += polygon.getMemoryUsage();
+    }
+    return bytes;
+}
@@ -0,0 +1,84 @@
+#ifndef QUANTIZED_POLYGON_STORE_H
+#define QUANTIZED_POLYGON_STORE_H
+
+#include <cstdint>
+#include <vector>
+#include <ogrsf_frmts.h>
+#include "AreaClipper.h"
+
+// How resident polygons keep their coordinates
+enum class CoordinateStorage {
+    Double,     // FlatPolygon, 16 bytes per point
+    Quantized,  // QuantizedPolygonStore, 8 bytes per point
+};
+
+// Append-only polygon container holding coordinates as int32 offsets on a
+// 2^-10 m grid (~1 mm in the Web Mercator metres of our data) from the
+// corner of a 2^20 m tile, all polygons in one array. Grid points are exact
+// doubles, so the quantized polygon is an exact double polygon within half
+// a grid step of the source. Polygons that do not fit (wider than a tile,
+// non-finite or far out) are kept as FlatPolygons.
+//
+// Read-only once filled; queries are safe from any thread.
+class QuantizedPolygonStore {
+public:
+    static constexpr int kFractionBits = 10;
+    static constexpr double kScale = 1 << kFractionBits;          // grid steps per metre
+    static constexpr double kTileSize = double(1 << 30) / kScale;  // tile side in metres
+
+    QuantizedPolygonStore();
+
+    // Append a polygon, returns its index
+    uint32_t add(const FlatPolygon& polygon);
+
+    size_t size() const;
+    bool isQuantized(uint32_t index) const;
+    size_t getQuantizedCount() const;
+
+    // Conservative: contains both the source and the quantized polygon
+    OGREnvelope getEnvelope(uint32_t index) const;
+
+    // Integer envelope test, conservative to one grid step
+    bool envelopeIntersects(uint32_t index, const OGREnvelope& box) const;
+
+    // True if (x, y) lies inside the quantized polygon or on its boundary.
+    // Edge orientations are decided on the integer grid; only points too
+    // close to an edge for the integer bound go to RobustPredicates.
+    bool containsPoint(uint32_t index, double x, double y) const;
+
+    // The polygon as a FlatPolygon: a fallback polygon directly, otherwise
+    // the grid coordinates written into scratch, which is returned
+    const FlatPolygon& get(uint32_t index, FlatPolygon& scratch) const;
+
+    // Release the growth slack once loading is done
+    void shrinkToFit();
+
+    size_t getMemoryUsage() const;
+
+private:
+    static constexpr uint32_t kFallback = UINT32_MAX;
+
+    struct Record {
+        int32_t tileX, tileY;               // origin = tile * kTileSize
+        int32_t minX, minY, maxX, maxY;     // envelope in grid steps from the origin
+        uint32_t firstRing;                 // into ringStarts, or into fallback
+        uint32_t numRings;                  // kFallback for FlatPolygon entries
+    };
+
+    std::vector<Record> records;
+    std::vector<uint32_t> ringStarts;       // first point of each ring plus an end sentinel per polygon
+    std::vector<int32_t> points;            // interleaved x,y grid offsets
+    std::vector<FlatPolygon> fallback;
+    size_t quantizedCount;
+
+    bool quantize(const FlatPolygon& polygon, Record& record);
+    void addFallback(const FlatPolygon& polygon, Record& record);
+
+    // Sign of the orientation of grid edge a->b and the point (x, y), whose
+    // grid cell has lower corner q; exact, on integers unless p is too
+    // close to the edge's line
+    static int orientation(const Record& record, int64_t ax, int64_t ay, int64_t bx, int64_t by,
+                           int64_t qx, int64_t qy, double x, double y);
+};
+
+#endif // QUANTIZED_POLYGON_STORE_H
@@ -0,0 +1,264 @@
+#include "RunCheckpoint.h"
+#include "Logger.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+
+static constexpr uint32_t kCheckpointCookie = 0x504b4349;      // "ICKP"
+static constexpr uint32_t kCheckpointVersion = 1;
+
+template <typename T>
+static void put(std::vector<unsigned char>& out, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static void putBytes(std::vector<unsigned char>& out, const void* data, size_t size) {
+    put(out, static_cast<uint64_t>(size));
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+// Bounds-checked reads; any short read fails the whole checkpoint
+struct CheckpointReader {
+    const unsigned char* data;
+    size_t size;
+    size_t pos = 0;
+
+    template <typename T>
+    bool get(T& value) {
+        if (size - pos < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data + pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    bool getBytes(const unsigned char*& bytes, uint64_t& length) {
+        if (!get(length) || size - pos < length) {
+            return false;
+        }
+        bytes = data + pos;
+        pos += length;
+        return true;
+    }
+
+    bool getString(std::string& text) {
+        const unsigned char* bytes;
+        uint64_t length;
+        if (!getBytes(bytes, length)) {
+            return false;
+        }
+        text.assign(reinterpret_cast<const char*>(bytes), length);
+        return true;
+    }
+
+    // Element count of a vector, no larger than the bytes left could hold
+    bool getCount(uint64_t& count, size_t minElementSize) {
+        return get(count) && count <= (size - pos) / minElementSize;
+    }
+};
+
+void RunCheckpoint::serialize(std::vector<unsigned char>& out) const {
+    out.clear();
+    put(out, kCheckpointCookie);
+    put(out, kCheckpointVersion);
+    put(out, inputHash);
+    put(out, parcelRows);
+    put(out, lastParcelId);
+    put(out, outputBytes);
+    put(out, affectedCount);
+
+    put(out, static_cast<uint64_t>(layerAffectedCounts.size()));
+    for (uint64_t count : layerAffectedCounts) {
+        put(out, count);
+    }
+
+    std::vector<unsigned char> bitmap;
+    affectedParcels.serialize(bitmap);
+    putBytes(out, bitmap.data(), bitmap.size());
+
+    put(out, static_cast<uint64_t>(owners.size()));
+    for (const Owner& owner : owners) {
+        putBytes(out, owner.name.data(), owner.name.size());
+        put(out, owner.parcelCount);
+        put(out, owner.affectedCount);
+        put(out, owner.totalArea);
+        put(out, owner.affectedArea);
+    }
+
+    put(out, static_cast<uint64_t>(quarantine.size()));
+    for (const QuarantineRecord& record : quarantine) {
+        put(out, record.id);
+        put(out, record.sourceHash);
+        putBytes(out, record.operation.data(), record.operation.size());
+        put(out, static_cast<uint64_t>(record.vertexCount));
+        put(out, record.elapsedMs);
+    }
+
+    put(out, static_cast<uint64_t>(released.size()));
+    for (int id : released) {
+        put(out, id);
+    }
+}
+
+bool RunCheckpoint::deserialize(const unsigned char* data, size_t size) {
+    *this = RunCheckpoint();
+    CheckpointReader reader{data, size};
+    uint32_t cookie, version;
+    if (!reader.get(cookie) || cookie != kCheckpointCookie ||
+        !reader.get(version) || version != kCheckpointVersion) {
+        return false;
+    }
+    if (!reader.get(inputHash) || !reader.get(parcelRows) || !reader.get(lastParcelId) ||
+        !reader.get(outputBytes) || !reader.get(affectedCount)) {
+        return false;
+    }
+
+    uint64_t count;
+    if (!reader.getCount(count, sizeof(uint64_t))) {
+        return false;
+    }
+    layerAffectedCounts.resize(count);
+    for (uint64_t& layerCount : layerAffectedCounts) {
+        reader.get(layerCount);
+    }
+
+    const unsigned char* bytes;
+    uint64_t length;
+    if (!reader.getBytes(bytes, length) || !affectedParcels.deserialize(bytes, length)) {
+        return false;
+    }
+
+    if (!reader.getCount(count, sizeof(uint64_t) * 3 + sizeof(double) * 2)) {
+        return false;
+    }
+    owners.resize(count);
+    for (Owner& owner : owners) {
+        if (!reader.getString(owner.name) || !reader.get(owner.parcelCount) || !reader.get(owner.affectedCount) ||
+            !reader.get(owner.totalArea) || !reader.get(owner.affectedArea)) {
+            return false;
+        }
+    }
+
+    if (!reader.getCount(count, sizeof(int) + sizeof(uint64_t) * 3 + sizeof(double))) {
+        return false;
+    }
+    quarantine.resize(count);
+    for (QuarantineRecord& record : quarantine) {
+        uint64_t vertexCount;
+        if (!reader.get(record.id) || !reader.get(record.sourceHash) || !reader.getString(record.operation) ||
+            !reader.get(vertexCount) || !reader.get(record.elapsedMs)) {
+            return false;
+        }
+        record.vertexCount = static_cast<size_t>(vertexCount);
+    }
+
+    if (!reader.getCount(count, sizeof(int))) {
+        return false;
+    }
+    released.resize(count);
+    for (int& id : released) {
+        reader.get(id);
+    }
+    return reader.pos == size;
+}
+
+CheckpointStore::CheckpointStore(const std::string& location)
+    : location(location), saveCount(0), saveTime(0), lastSize(0) {
+    if (location == "db") {
+        table = std::make_unique<CheckpointTableHandler>();
+    }
+}
+
+const std::string& CheckpointStore::getLocation() const {
+    return location;
+}
+
+size_t CheckpointStore::getSaveCount() const {
+    return saveCount;
+}
+
+double CheckpointStore::getSaveSeconds() const {
+    return std::chrono::duration<double>(saveTime).count();
+}
+
+size_t CheckpointStore::getLastSize() const {
+    return lastSize;
+}
+
+bool CheckpointStore::load(uint64_t inputHash, RunCheckpoint& checkpoint, bool& found) {
+    found = false;
+    std::vector<unsigned char> state;
+    if (table) {
+        if (!table->getCheckpoint(inputHash, state, found)) {
+            return false;
+        }
+        if (!found) {
+            return true;
+        }
+    } else {
+        std::ifstream input(location, std::ios::binary);
+        if (!input) {
+            return true;
+        }
+        state.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+
+    if (!checkpoint.deserialize(state.data(), state.size())) {
+        LOG_WARN("Checkpoint in " << location << " is corrupt, ignored");
+        found = false;
+        return true;
+    }
+    // A file may hold the checkpoint of other inputs
+    found = checkpoint.inputHash == inputHash;
+    if (!found) {
+        LOG_INFO("Checkpoint in " << location << " is for other inputs, ignored");
+    }
+    return true;
+}
+
+bool CheckpointStore::save(const RunCheckpoint& checkpoint) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<unsigned char> state;
+    checkpoint.serialize(state);
+
+    bool ok;
+    if (table) {
+        ok = table->storeCheckpoint(checkpoint.inputHash, checkpoint.parcelRows, state);
+    } else {
+        // Written aside and renamed over the old one, so a crash mid-write
+        // leaves the previous checkpoint intact
+        const std::string temporary = location + ".tmp";
+        std::ofstream output(temporary, std::ios::binary | std::ios::trunc);
+        output.write(reinterpret_cast<const char*>(state.data()), static_cast<std::streamsize>(state.size()));
+        output.close();
+        std::error_code error;
+        ok = static_cast<bool>(output);
+        if (ok) {
+            std::filesystem::rename(temporary, location, error);
+            ok = !error;
+        }
+        if (!ok) {
+            LOG_ERROR("Cannot write checkpoint file " << location);
+        }
+    }
+
+    saveCount++;
+    saveTime += std::chrono::steady_clock::now() - start;
+    lastSize = state.size();
+    return ok;
+}
+
+bool CheckpointStore::remove(uint64_t inputHash) {
+    if (table) {
+        return table->deleteCheckpoint(inputHash);
+    }
+    std::error_code error;
+    std::filesystem::remove(location, error);
+    return !error;
+}
@@ -0,0 +1,69 @@
+#ifndef RUN_CHECKPOINT_H
+#define RUN_CHECKPOINT_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "CheckpointTableHandler.h"
+#include "GeometryBudget.h"
+#include "ParcelBitmap.h"
+
+// Progress of an intersection run at a batch boundary: the first parcelRows
+// parcels of the stream are joined and reported, and everything derived
+// from them is stored here. A restarted run with the same inputHash skips
+// those rows and continues from this state.
+struct RunCheckpoint {
+    struct Owner {
+        std::string name;           // owner names, not the process-local dictionary ids
+        uint64_t parcelCount = 0;
+        uint64_t affectedCount = 0;
+        double totalArea = 0.0;
+        double affectedArea = 0.0;
+    };
+
+    uint64_t inputHash = 0;
+    uint64_t parcelRows = 0;        // high-water mark: rows of the parcel stream done
+    int lastParcelId = -1;          // id of the last of them, checked on resume
+    uint64_t outputBytes = 0;       // length of the per-parcel CSV at this point
+    uint64_t affectedCount = 0;
+    std::vector<uint64_t> layerAffectedCounts;
+    ParcelBitmap affectedParcels;
+    std::vector<Owner> owners;
+    std::vector<QuarantineRecord> quarantine;
+    std::vector<int> released;
+
+    // Native byte order; checkpoints are read back on the same host type
+    void serialize(std::vector<unsigned char>& out) const;
+    // False if data is not a valid serialized checkpoint
+    bool deserialize(const unsigned char* data, size_t size);
+};
+
+// Where checkpoints are kept: the intersect_checkpoints table when location
+// is "db", else a local file, replaced atomically through a rename
+class CheckpointStore {
+public:
+    explicit CheckpointStore(const std::string& location);
+
+    // found is false if there is no checkpoint for inputHash
+    bool load(uint64_t inputHash, RunCheckpoint& checkpoint, bool& found);
+    bool save(const RunCheckpoint& checkpoint);
+    bool remove(uint64_t inputHash);
+
+    const std::string& getLocation() const;
+
+    // Overhead of save() so far
+    size_t getSaveCount() const;
+    double getSaveSeconds() const;
+    size_t getLastSize() const;
+
+private:
+    std::string location;
+    std::unique_ptr<CheckpointTableHandler> table;     // null for a file
+    size_t saveCount;
+    std::chrono::steady_clock::duration saveTime;
+    size_t lastSize;
+};
+
+#endif // RUN_CHECKPOINT_H
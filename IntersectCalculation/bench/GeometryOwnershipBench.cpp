@@ -0,0 +1,274 @@
+// Heap allocations and geometry copies of parcel and shapefile loading, on
+// the move-only path and on the copying path it replaced (kept here as
+// OldParcel / loadOldShapefile, the code before the rework).
+//
+//   GeometryOwnershipBench_bin [Parcel_data.shp] [parcels] [points per parcel]
+//
+// Parcels: JSONB text rows in a libpq result built in memory (no database)
+// -> LandProperty -> batch -> BoundedQueue -> consumer. Shapefile: loading
+// every polygon and taking it out of the loader. A global operator new
+// counts allocations and bytes; the old code counts its explicit polygon
+// copies (vector growth of OGRPolygon values only shows as allocations).
+// Owner names are interned before measuring, so both paths find them.
+#include "BoundedQueue.h"
+#include "DatabaseHandler.h"
+#include "LandProperty.h"
+#include "Logger.h"
+#include "OwnerDictionary.h"
+#include "ShapefileHandler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <libpq-fe.h>
+#include <ogrsf_frmts.h>
+
+static size_t allocationCount = 0;
+static size_t allocationBytes = 0;
+
+void* operator new(size_t size) {
+    allocationCount++;
+    allocationBytes += size;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+static size_t geometryCopies = 0;      // whole polygons copied
+static size_t parcelMoves = 0;         // OldParcel moves; they copy the polygon where OGRPolygon cannot move
+
+struct CopyCounter {
+    CopyCounter() = default;
+    CopyCounter(const CopyCounter&) { geometryCopies++; }
+    CopyCounter(CopyCounter&&) noexcept { parcelMoves++; }
+    CopyCounter& operator=(const CopyCounter&) { geometryCopies++; return *this; }
+    CopyCounter& operator=(CopyCounter&&) noexcept { parcelMoves++; return *this; }
+};
+
+// LandProperty before the rework: the polygon held by value, filled by
+// addProperty from a parsed OGRPolygon
+struct OldParcel {
+    int id = 0;
+    uint32_t ownerId = OwnerDictionary::instance().intern("");
+    OGRPolygon polygon;
+    CopyCounter counter;
+
+    void addProperty(int propId, std::string_view propOwner, const OGRPolygon& coords) {
+        id = propId;
+        ownerId = OwnerDictionary::instance().intern(propOwner);
+        polygon = coords;
+        geometryCopies++;
+    }
+};
+
+// DatabaseHandler::parseLandProperty before the rework
+static OldParcel parseOldParcel(PGresult* res, int row) {
+    int id = std::atoi(PQgetvalue(res, row, 0));
+    std::string_view owner(PQgetvalue(res, row, 1), PQgetlength(res, row, 1));
+    std::string polygonJson = PQgetvalue(res, row, 2);
+
+    OGRPolygon coords;
+    size_t start = polygonJson.find('[');
+    size_t end = polygonJson.rfind(']');
+    if (start != std::string::npos && end != std::string::npos) {
+        std::string coordsStr = polygonJson.substr(start + 1, end - start - 1);
+        size_t pos = 0;
+        OGRLinearRing ring;
+        while ((pos = coordsStr.find('[', pos)) != std::string::npos) {
+            size_t endBracket = coordsStr.find(']', pos);
+            if (endBracket == std::string::npos) {
+                break;
+            }
+            std::string pair = coordsStr.substr(pos + 1, endBracket - pos - 1);
+            size_t comma = pair.find(',');
+            if (comma != std::string::npos) {
+                ring.addPoint(std::stod(pair.substr(0, comma)), std::stod(pair.substr(comma + 1)));
+            }
+            pos = endBracket + 1;
+        }
+        coords.addRing(&ring);
+    }
+
+    OldParcel parcel;
+    parcel.addProperty(id, owner, coords);
+    return parcel;
+}
+
+// ShapefileHandler::loadPolygons before the rework: each feature polygon
+// copied into a vector of values, and the id vector copied by its reader
+static size_t loadOldShapefile(const std::string& path) {
+    std::vector<OGRPolygon> polygons;
+    std::vector<int> polygonIds;
+    GDALDataset* dataset = static_cast<GDALDataset*>(GDALOpenEx(path.c_str(), GDAL_OF_VECTOR, nullptr, nullptr, nullptr));
+    if (dataset == nullptr) {
+        return 0;
+    }
+    OGRLayer* layer = dataset->GetLayer(0);
+    OGRFeature* feature;
+    layer->ResetReading();
+    while ((feature = layer->GetNextFeature()) != nullptr) {
+        OGRGeometry* geometry = feature->GetGeometryRef();
+        const int baseId = static_cast<int>(feature->GetFID()) * ShapefileHandler::kMaxPartsPerFeature;
+        if (geometry != nullptr && wkbFlatten(geometry->getGeometryType()) == wkbPolygon) {
+            polygons.push_back(*geometry->toPolygon());
+            polygonIds.push_back(baseId);
+            geometryCopies++;
+        } else if (geometry != nullptr && wkbFlatten(geometry->getGeometryType()) == wkbMultiPolygon) {
+            OGRMultiPolygon* parts = geometry->toMultiPolygon();
+            for (int j = 0; j < parts->getNumGeometries() && j < ShapefileHandler::kMaxPartsPerFeature; j++) {
+                polygons.push_back(*parts->getGeometryRef(j)->toPolygon());
+                polygonIds.push_back(baseId + j);
+                geometryCopies++;
+            }
+        }
+        OGRFeature::DestroyFeature(feature);
+    }
+    GDALClose(dataset);
+    const std::vector<int> readerIds = polygonIds;
+    return readerIds.size();
+}
+
+static size_t loadNewShapefile(const std::string& path) {
+    ShapefileHandler handler(path);
+    std::vector<int> polygonIds = handler.takePolygonIds();
+    std::vector<std::unique_ptr<OGRPolygon>> polygons = handler.takePolygons();
+    return polygons.size();
+}
+
+// Rows of SELECT id, owner, polygon as libpq returns them in text format
+static PGresult* makeParcelRows(size_t parcels, int points) {
+    PGresult* res = PQmakeEmptyPGresult(nullptr, PGRES_TUPLES_OK);
+    PGresAttDesc columns[3] = {
+        {const_cast<char*>("id"), 0, 0, 0, 23, 4, -1},
+        {const_cast<char*>("owner"), 0, 0, 0, 25, -1, -1},
+        {const_cast<char*>("polygon"), 0, 0, 0, 3802, -1, -1}};
+    PQsetResultAttrs(res, 3, columns);
+
+    char number[64];
+    std::string polygon;
+    for (size_t row = 0; row < parcels; row++) {
+        // A small convex parcel on a Web Mercator grid, closed
+        const double cx = -13000000.0 + static_cast<double>(row % 1000) * 40.0;
+        const double cy = 4000000.0 + static_cast<double>(row / 1000) * 40.0;
+        polygon = "[";
+        for (int i = 0; i <= points; i++) {
+            const double angle = 2.0 * M_PI * (i % points) / points;
+            std::snprintf(number, sizeof(number), "%s[%.2f, %.2f]", i > 0 ? ", " : "",
+                          cx + 15.0 * std::cos(angle), cy + 15.0 * std::sin(angle));
+            polygon += number;
+        }
+        polygon += "]";
+        const std::string id = std::to_string(row + 1);
+        const std::string owner = "Owner " + std::to_string(row / 10);
+        PQsetvalue(res, static_cast<int>(row), 0, const_cast<char*>(id.c_str()), static_cast<int>(id.size()));
+        PQsetvalue(res, static_cast<int>(row), 1, const_cast<char*>(owner.c_str()), static_cast<int>(owner.size()));
+        PQsetvalue(res, static_cast<int>(row), 2, const_cast<char*>(polygon.c_str()), static_cast<int>(polygon.size()));
+    }
+    return res;
+}
+
+// Parse every row into batches of batchSize and pass them through a queue
+template <typename Parcel, typename Parse>
+static void streamParcels(PGresult* res, size_t batchSize, Parse&& parse) {
+    BoundedQueue<std::vector<Parcel>> queue(4);
+    const int rows = PQntuples(res);
+    for (int first = 0; first < rows; first += static_cast<int>(batchSize)) {
+        const int last = std::min(rows, first + static_cast<int>(batchSize));
+        std::vector<Parcel> batch;
+        batch.reserve(last - first);
+        for (int i = first; i < last; i++) {
+            batch.push_back(parse(res, i));
+        }
+        queue.push(std::move(batch));
+        queue.pop();
+    }
+}
+
+struct Measurement {
+    size_t allocations;
+    size_t bytes;
+    size_t copies;
+    size_t moves;
+    double ms;
+};
+
+template <typename Run>
+static Measurement measure(Run&& run) {
+    const size_t allocations = allocationCount, bytes = allocationBytes;
+    geometryCopies = 0;
+    parcelMoves = 0;
+    const auto start = std::chrono::steady_clock::now();
+    run();
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return Measurement{allocationCount - allocations, allocationBytes - bytes, geometryCopies, parcelMoves, ms};
+}
+
+static void report(const char* path, const Measurement& m, size_t items, const char* unit) {
+    std::printf("  %-5s %10zu allocations (%5.1f per %s) %9.1f MiB %9zu geometry copies %9zu moves %9.1f ms\n",
+                path, m.allocations, static_cast<double>(m.allocations) / static_cast<double>(items), unit,
+                static_cast<double>(m.bytes) / (1024.0 * 1024.0), m.copies, m.moves, m.ms);
+}
+
+int main(int argc, char* argv[]) {
+    const std::string shapefile = argc > 1 ? argv[1] : "";
+    const size_t parcels = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+    const int points = argc > 3 ? std::atoi(argv[3]) : 12;
+    if (parcels == 0 || points < 3) {
+        std::cerr << "Usage: " << argv[0] << " [Parcel_data.shp] [parcels] [points per parcel]" << std::endl;
+        return 2;
+    }
+    Logger::instance().setLevel(LogLevel::Warn);
+    GDALAllRegister();
+
+    PGresult* rows = makeParcelRows(parcels, points);
+    streamParcels<LandProperty>(rows, 1000, DatabaseHandler::parseLandProperty);     // interns the owners
+
+    std::printf("Parcels: %zu rows of %d points -> batch -> queue\n", parcels, points + 1);
+    const Measurement oldParcels = measure([&] { streamParcels<OldParcel>(rows, 1000, parseOldParcel); });
+    report("old", oldParcels, parcels, "parcel");
+    const Measurement newParcels = measure([&] {
+        streamParcels<LandProperty>(rows, 1000, DatabaseHandler::parseLandProperty);
+    });
+    report("new", newParcels, parcels, "parcel");
+    PQclear(rows);
+
+    if (shapefile.empty() || !std::filesystem::exists(shapefile)) {
+        std::printf("Shapefile: skipped, %s\n", shapefile.empty() ? "no path given" : (shapefile + " not found").c_str());
+        return 0;
+    }
+    std::printf("Shapefile: %s\n", shapefile.c_str());
+    size_t polygons = 0;
+    const Measurement oldLoad = measure([&] { polygons = loadOldShapefile(shapefile); });
+    report("old", oldLoad, std::max<size_t>(polygons, 1), "polygon");
+    const Measurement newLoad = measure([&] { polygons = loadNewShapefile(shapefile); });
+    report("new", newLoad, std::max<size_t>(polygons, 1), "polygon");
+    return 0;
+}
@@ -1,64 +1,280 @@
+#include "AffectedRunTableHandler.h"
 #include "DatabaseHandler.h"
-#include "IntersectCalculation.h"
-#include "LandProperty.h"
-#include "ShapefileHandler.h"
+#include "HazardDaemon.h"
+#include "InvalidPolygonTableHandler.h"
+#include "IntersectPipeline.h"
+#include "Logger.h"
+#include <algorithm>
 #include <iostream>
-#include <vector>
-#include <utility>
+#include <string>
+#include <thread>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
-#include <ogrsf_frmts.h>
-#include "InvalidPolygonTableHandler.h"
+#include <fstream>
 
-int main() {
+void printUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " [options]" << std::endl;
+    std::cout << "  --shapefile <path>       Shapefile of the first hazard layer (default: " << HazardLayerConfig().shapefilePath << ")" << std::endl;
+    std::cout << "  --hazard <name>=<path>   Add a hazard layer (repeatable, up to " << PipelineConfig::kMaxHazardLayers << "); the first one replaces the default wildfire layer" << std::endl;
+    std::cout << "  --batch-size <n>         Parcels per fetch/join batch (default: " << PipelineConfig().batchSize << ")" << std::endl;
+    std::cout << "  --queue-capacity <n>     Batches buffered between stages (default: " << PipelineConfig().queueCapacity << ")" << std::endl;
+    std::cout << "  --workers <n>            Join worker threads (default: hardware concurrency)" << std::endl;
+    std::cout << "  --log-level <level>      debug, info, warn or error (default: info; debug needs a -DLOG_COMPILE_LEVEL=LOG_LEVEL_DEBUG build)" << std::endl;
+    std::cout << "  --parcel-extents <n>     Fire extents used to filter parcels in the database, 0 = all parcels (default: " << PipelineConfig().parcelExtents << ")" << std::endl;
+    std::cout << "  --mode <mode>            overlap (default), within (a polygon within --distance) or nearest (distance to the nearest polygon)" << std::endl;
+    std::cout << "  --distance <m>           Range of the within / nearest modes (nearest default: unbounded)" << std::endl;
+    std::cout << "  --output <path>          Write one CSV line per matched parcel (mask, fraction, distance, nearest polygon id)" << std::endl;
+    std::cout << "  --owner-output <path>    Write per-owner parcel counts and total/affected area as CSV" << std::endl;
+    std::cout << "  --run-date <YYYY-MM-DD>  Store the affected parcel set for this date and diff it against the previous run" << std::endl;
+    std::cout << "  --diff-output <path>     With --run-date: write newly / no longer affected parcel ids as CSV" << std::endl;
+    std::cout << "  --where <predicate>      Load only polygons of the layer given before it (--shapefile or --hazard) matching an OGR SQL predicate, e.g. \"YEAR_ >= '2020'\"" << std::endl;
+    std::cout << "  --extent <minx,miny,maxx,maxy>  Load only polygons of the layer given before it meeting the extent (uses the .sbn index)" << std::endl;
+    std::cout << "  --coordinates <storage>  double (default) or quantized: int32 offsets on a ~1 mm grid, about half the memory" << std::endl;
+    std::cout << "  --edge-grid-min-points <n>  Index the edges of hazard polygons with at least n points, 0 = never (default: " << PipelineConfig().edgeGridMinPoints << ")" << std::endl;
+    std::cout << "  --time-budget <ms>       Join time per parcel before it is quarantined for the slow lane of later runs, 0 = none (default: " << PipelineConfig().budget.timeMs << ")" << std::endl;
+    std::cout << "  --vertex-budget <n>      Parcels with more points are joined in the slow lane, 0 = none (default: " << PipelineConfig().budget.maxVertices << ")" << std::endl;
+    std::cout << "  --checkpoint <path|db>   Save progress to a file, or to the intersect_checkpoints table with db; a rerun with the same inputs resumes from it" << std::endl;
+    std::cout << "  --checkpoint-interval <s>  Seconds between checkpoints (default: " << PipelineConfig().checkpointInterval << ")" << std::endl;
+    std::cout << "  --daemon <socket>        Serve hazard queries for the first layer on a Unix socket instead of a batch run" << std::endl;
+    std::cout << "  --reload-interval <s>    Daemon: seconds between shapefile / validity table change checks (default: " << DaemonConfig().reloadIntervalSeconds << ")" << std::endl;
+    std::cout << "  --max-connections <n>    Daemon: concurrent clients; more are answered busy (default: " << DaemonConfig().maxConnections << ")" << std::endl;
+}
 
-    // Initialize database handler with connection parameters
-    DatabaseHandler LandPropertyDB_Handler("polygons_db", "5432", "polygons_db", "polygons_user", "polygons_pass");
-    if (!LandPropertyDB_Handler.isConnected()) {
-        std::cerr << "Failed to connect to database. Exiting." << std::endl;
-        return 1;
+// Store the run's affected set in affected_runs together with its change
+// since the latest earlier run, optionally listing the changes as CSV
+static bool recordAffectedRun(const ParcelBitmap& affected, const std::string& runDate,
+                              const std::string& diffOutputPath) {
+    AffectedRunTableHandler runs;
+    if (!runs.isConnected()) {
+        return false;
     }
-    
-    // Retrieve land properties from the database
-    std::vector<LandProperty> landProperties = LandPropertyDB_Handler.getLandProperties();
-    if (landProperties.empty()) {
-        std::cerr << "No land properties retrieved. Exiting." << std::endl;
-        return 1;
+    AffectedRun run;
+    run.runDate = runDate;
+    run.parcels = affected;
+
+    AffectedRun previous;
+    bool found = false;
+    if (!runs.getPreviousAffectedRun(runDate, previous, found)) {
+        return false;
+    }
+    if (found) {
+        run.previousRunDate = previous.runDate;
+        run.newlyAffected = run.parcels.difference(previous.parcels);
+        run.noLongerAffected = previous.parcels.difference(run.parcels);
+    } else {
+        run.newlyAffected = run.parcels;
     }
+    if (!runs.storeAffectedRun(run)) {
+        return false;
+    }
+    LOG_INFO("Run " << runDate << ": " << run.parcels.cardinality() << " affected parcels ("
+             << run.parcels.getMemoryUsage() / 1024 << " KiB), " << run.newlyAffected.cardinality()
+             << " newly affected and " << run.noLongerAffected.cardinality() << " no longer affected since "
+             << (found ? previous.runDate : std::string("no earlier run")));
 
-    // California wildfire area bounding box (example)
-    ShapefileHandler wildfireAreaHandler("/opt/airflow/Dataset_Cali_Wildfire/Wildfires.shp");
-    auto wildfirePolygons = wildfireAreaHandler.getPolygons();
+    if (!diffOutputPath.empty()) {
+        std::ofstream output(diffOutputPath);
+        if (!output) {
+            LOG_ERROR("Cannot open diff output file " << diffOutputPath);
+            return false;
+        }
+        output << "parcel_id,change\n";
+        run.newlyAffected.forEach([&](uint32_t id) { output << id << ",newly_affected\n"; });
+        run.noLongerAffected.forEach([&](uint32_t id) { output << id << ",no_longer_affected\n"; });
+    }
+    return true;
+}
 
-    // Initialize invalid wildfire lookup (invalid_wildfire table)
-    InvalidPolygonTableHandler invalidHandler("polygons_db", "5432", "polygons_db", "polygons_user", "polygons_pass");
-    bool invalidTableAvailable = invalidHandler.isConnected();
+int main(int argc, char* argv[]) {
+    PipelineConfig config;
+    DaemonConfig daemonConfig;
+    bool daemonMode = false;
+    bool hazardsGiven = false;
+    std::string runDate;
+    std::string diffOutputPath;
+    config.joinWorkers = std::max(1u, std::thread::hardware_concurrency());
 
-    // Check intersections
-    std::vector<bool> isaffected(landProperties.size(), false);
-    for (size_t i = 0; i < landProperties.size(); i++) {
-        for (size_t j = 0; j < wildfirePolygons.size(); j++) {
-            // Skip wildfire polygon if marked invalid in DB (1=invalid)
-            if (invalidTableAvailable) {
-                bool wfInvalid = false;
-                if (invalidHandler.isWildfireInvalid(static_cast<int>(j), wfInvalid) && wfInvalid) {
-                    continue;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--shapefile") {
+            config.hazards.front().shapefilePath = value;
+        } else if (arg == "--hazard") {
+            HazardLayerConfig layer;
+            size_t eq = value.find('=');
+            layer.name = value.substr(0, eq);
+            layer.shapefilePath = eq == std::string::npos ? "" : value.substr(eq + 1);
+            if (!hazardsGiven) {
+                // A filter given so far belongs to the default layer, which
+                // this layer replaces
+                const ShapefileFilter& filter = config.hazards.front().filter;
+                if (!filter.where.empty() || filter.hasExtent) {
+                    LOG_ERROR("--where and --extent filter the layer before them; give them after --hazard " << value);
+                    printUsage(argv[0]);
+                    Logger::instance().flush();
+                    return 1;
                 }
+                config.hazards.clear();
+                hazardsGiven = true;
             }
-
-            OGRGeometry* intersection = landProperties[i].getPolygon().Intersection(&wildfirePolygons[j]);
-
-            if (intersection != nullptr && !intersection->IsEmpty()) {
-                std::cout << "Land Property ID " << landProperties[i].getId() 
-                          << " owned by " << landProperties[i].getOwner() 
-                          << " intersects with wildfire area." << std::endl;
-                OGRGeometryFactory::destroyGeometry(intersection);
-                isaffected[i] = true;
-                break;
+            bool duplicate = std::any_of(config.hazards.begin(), config.hazards.end(),
+                                         [&](const HazardLayerConfig& l) { return l.name == layer.name; });
+            if (layer.shapefilePath.empty() || duplicate ||
+                !InvalidPolygonTableHandler::isValidHazardName(layer.name) ||
+                config.hazards.size() >= PipelineConfig::kMaxHazardLayers) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.hazards.push_back(layer);
+        } else if (arg == "--batch-size") {
+            config.batchSize = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (arg == "--queue-capacity") {
+            config.queueCapacity = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (arg == "--workers") {
+            config.joinWorkers = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--parcel-extents") {
+            config.parcelExtents = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (arg == "--mode") {
+            if (value == "overlap") {
+                config.mode = JoinMode::Overlap;
+            } else if (value == "within") {
+                config.mode = JoinMode::Within;
+            } else if (value == "nearest") {
+                config.mode = JoinMode::Nearest;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--distance") {
+            config.distance = std::strtod(value.c_str(), nullptr);
+            if (!(config.distance >= 0.0)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--output") {
+            config.outputPath = value;
+        } else if (arg == "--owner-output") {
+            config.ownerOutputPath = value;
+        } else if (arg == "--run-date") {
+            if (!AffectedRunTableHandler::isValidRunDate(value)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            runDate = value;
+        } else if (arg == "--diff-output") {
+            diffOutputPath = value;
+        } else if (arg == "--where") {
+            config.hazards.back().filter.where = value;
+        } else if (arg == "--extent") {
+            OGREnvelope& extent = config.hazards.back().filter.extent;
+            if (std::sscanf(value.c_str(), "%lf,%lf,%lf,%lf", &extent.MinX, &extent.MinY, &extent.MaxX, &extent.MaxY) != 4 ||
+                extent.MinX > extent.MaxX || extent.MinY > extent.MaxY) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            config.hazards.back().filter.hasExtent = true;
+        } else if (arg == "--coordinates") {
+            if (value == "double") {
+                config.storage = CoordinateStorage::Double;
+            } else if (value == "quantized") {
+                config.storage = CoordinateStorage::Quantized;
             } else {
-                OGRGeometryFactory::destroyGeometry(intersection);
+                printUsage(argv[0]);
+                return 1;
             }
+        } else if (arg == "--time-budget") {
+            config.budget.timeMs = std::strtod(value.c_str(), nullptr);
+        } else if (arg == "--vertex-budget") {
+            config.budget.maxVertices = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (arg == "--edge-grid-min-points") {
+            config.edgeGridMinPoints = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (arg == "--checkpoint") {
+            config.checkpointPath = value;
+        } else if (arg == "--checkpoint-interval") {
+            config.checkpointInterval = std::strtod(value.c_str(), nullptr);
+        } else if (arg == "--daemon") {
+            daemonMode = true;
+            daemonConfig.socketPath = value;
+        } else if (arg == "--reload-interval") {
+            daemonConfig.reloadIntervalSeconds = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--max-connections") {
+            daemonConfig.maxConnections = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--log-level") {
+            LogLevel level;
+            if (!parseLogLevel(value, level)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            Logger::instance().setLevel(level);
+        } else {
+            printUsage(argv[0]);
+            return 1;
         }
     }
-    
+
+    if (config.mode == JoinMode::Within && std::isinf(config.distance)) {
+        LOG_ERROR("--mode within needs --distance");
+        printUsage(argv[0]);
+        Logger::instance().flush();
+        return 1;
+    }
+
+    if (daemonMode) {
+        // Keep parcels, wildfires and indexes resident and answer queries
+        daemonConfig.shapefilePath = config.hazards.front().shapefilePath;
+        daemonConfig.wildfireFilter = config.hazards.front().filter;
+        daemonConfig.hazardName = config.hazards.front().name;
+        daemonConfig.storage = config.storage;
+        daemonConfig.edgeGridMinPoints = config.edgeGridMinPoints;
+        HazardDaemon daemon(daemonConfig);
+        int rc = daemon.run();
+        Logger::instance().flush();
+        return rc;
+    }
+
+    // Initialize database handler with connection parameters
+    DatabaseHandler LandPropertyDB_Handler("polygons_db", "5432", "polygons_db", "polygons_user", "polygons_pass");
+    if (!LandPropertyDB_Handler.isConnected()) {
+        LOG_ERROR("Failed to connect to database. Exiting.");
+        Logger::instance().flush();
+        return 1;
+    }
+
+    // Parcels quarantined by earlier runs go to the slow lane
+    if (!LandPropertyDB_Handler.getQuarantinedParcels(config.quarantinedParcels)) {
+        LOG_WARN("Could not read quarantined parcels; all parcels start on the main pass.");
+    }
+
+    // Layer loads and parcel fetch overlap; batches are joined against every layer as they arrive
+    IntersectPipeline pipeline(config);
+    if (!pipeline.run(LandPropertyDB_Handler)) {
+        LOG_ERROR("Failed to retrieve land properties. Exiting.");
+        Logger::instance().flush();
+        return 1;
+    }
+    if (!LandPropertyDB_Handler.updateQuarantinedParcels(pipeline.getQuarantine(), pipeline.getReleased())) {
+        LOG_WARN("Failed to update quarantined parcels.");
+    }
+
+    LOG_INFO(pipeline.getAffectedCount() << " land properties intersect with hazard areas.");
+    for (size_t layer = 0; layer < pipeline.getHazards().size(); layer++) {
+        LOG_INFO("  bit " << layer << " " << pipeline.getHazards()[layer].getName() << ": "
+                 << pipeline.getLayerAffectedCounts()[layer] << " land properties");
+    }
+    if (!runDate.empty() && !recordAffectedRun(pipeline.getAffectedParcels(), runDate, diffOutputPath)) {
+        LOG_ERROR("Failed to record the affected parcels of run " << runDate << ".");
+        Logger::instance().flush();
+        return 1;
+    }
+    Logger::instance().flush();
     return 0;
-}
\ No newline at end of file
+}
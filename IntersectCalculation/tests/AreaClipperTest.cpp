@@ -0,0 +1,307 @@
+// AreaClipper and PolygonDistance::intersects checked against GEOS through
+// OGR: hand-made degenerate cases, then parcels cut around the boundaries of
+// real perimeters and pairs of overlapping perimeters.
+//
+//   AreaClipperTest_bin [Wildfires.shp [Parcel_data.shp]]
+//
+// The hand-made cases always run; the dataset cases are skipped, with a
+// note, when a shapefile is not there (the .shp files are not tracked).
+// Exits non-zero if any result differs from GEOS beyond the tolerance.
+#include "AreaClipper.h"
+#include "EdgeGrid.h"
+#include "PolygonDistance.h"
+#include "ShapefileHandler.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <ogrsf_frmts.h>
+
+// Relative to the smaller input area, plus an absolute floor in m²
+static constexpr double kRelativeTolerance = 1e-7;
+static constexpr double kAbsoluteTolerance = 1e-6;
+
+static constexpr size_t kSampledParcels = 2000;
+static constexpr size_t kSampledFirePairs = 200;
+
+static size_t checks = 0;
+static size_t failures = 0;
+static size_t skipped = 0;
+
+using Ring = std::vector<double>;   // x0,y0,x1,y1,... without the closing point
+
+static std::unique_ptr<OGRPolygon> makePolygon(const std::vector<Ring>& rings, double ox = 0.0, double oy = 0.0) {
+    auto polygon = std::make_unique<OGRPolygon>();
+    for (const Ring& coords : rings) {
+        OGRLinearRing ring;
+        for (size_t i = 0; i + 1 < coords.size(); i += 2) {
+            ring.addPoint(ox + coords[i], oy + coords[i + 1]);
+        }
+        ring.addPoint(ox + coords[0], oy + coords[1]);
+        polygon->addRing(&ring);
+    }
+    return polygon;
+}
+
+static std::unique_ptr<OGRPolygon> reversed(const OGRPolygon& polygon) {
+    auto result = std::make_unique<OGRPolygon>();
+    for (int r = -1; r < polygon.getNumInteriorRings(); r++) {
+        const OGRLinearRing* source = r < 0 ? polygon.getExteriorRing() : polygon.getInteriorRing(r);
+        OGRLinearRing ring;
+        for (int i = source->getNumPoints() - 1; i >= 0; i--) {
+            ring.addPoint(source->getX(i), source->getY(i));
+        }
+        result->addRing(&ring);
+    }
+    return result;
+}
+
+// Area of an OGR result, which may be a polygon, a multipolygon or a
+// collection holding the lines and points of touching boundaries
+static double resultArea(const OGRGeometry* geometry) {
+    if (geometry == nullptr || geometry->IsEmpty()) {
+        return 0.0;
+    }
+    switch (wkbFlatten(geometry->getGeometryType())) {
+        case wkbPolygon:
+            return geometry->toPolygon()->get_Area();
+        case wkbMultiPolygon:
+        case wkbGeometryCollection:
+            return geometry->toGeometryCollection()->get_Area();
+        default:
+            return 0.0;
+    }
+}
+
+static void expectArea(const std::string& name, double got, double expected, double scale) {
+    checks++;
+    const double tolerance = kRelativeTolerance * scale + kAbsoluteTolerance;
+    if (std::fabs(got - expected) > tolerance) {
+        failures++;
+        std::cout << "FAIL " << name << ": area " << got << ", GEOS " << expected << std::endl;
+    }
+}
+
+static void expectIntersects(const std::string& name, bool got, bool expected) {
+    checks++;
+    if (got != expected) {
+        failures++;
+        std::cout << "FAIL " << name << ": intersects " << got << ", GEOS " << expected << std::endl;
+    }
+}
+
+// subject ∩ clip, both ways round, with and without the clip's edge grid
+static void comparePair(const std::string& name, const OGRPolygon& subject, const OGRPolygon& clip) {
+    std::unique_ptr<OGRGeometry> intersection(subject.Intersection(&clip));
+    if (intersection == nullptr) {
+        skipped++;
+        return;
+    }
+    const double expected = resultArea(intersection.get());
+    const bool touches = subject.Intersects(&clip);
+
+    const FlatPolygon flatSubject(subject);
+    const FlatPolygon flatClip(clip);
+    const EdgeGrid subjectGrid(flatSubject);
+    const EdgeGrid clipGrid(flatClip);
+    const double scale = std::min(flatSubject.getArea(), flatClip.getArea());
+    expectArea(name, AreaClipper::intersectionArea(flatSubject, flatClip), expected, scale);
+    expectArea(name + " (grid)", AreaClipper::intersectionArea(flatSubject, flatClip, &clipGrid), expected, scale);
+    expectArea(name + " (swapped)", AreaClipper::intersectionArea(flatClip, flatSubject, &subjectGrid), expected, scale);
+    expectIntersects(name, PolygonDistance::intersects(flatSubject, flatClip), touches);
+    expectIntersects(name + " (grid)", PolygonDistance::intersects(flatSubject, flatClip, &clipGrid), touches);
+}
+
+// Area of subject covered by the union of the clips
+static void compareUnion(const std::string& name, const OGRPolygon& subject, const std::vector<const OGRPolygon*>& clips) {
+    std::unique_ptr<OGRGeometry> covered;
+    for (const OGRPolygon* clip : clips) {
+        std::unique_ptr<OGRGeometry> piece(subject.Intersection(clip));
+        if (piece == nullptr) {
+            skipped++;
+            return;
+        }
+        if (covered != nullptr) {
+            piece.reset(covered->Union(piece.get()));
+            if (piece == nullptr) {
+                skipped++;
+                return;
+            }
+        }
+        covered = std::move(piece);
+    }
+
+    const FlatPolygon flatSubject(subject);
+    std::vector<FlatPolygon> flatClips;
+    flatClips.reserve(clips.size());
+    for (const OGRPolygon* clip : clips) {
+        flatClips.emplace_back(*clip);
+    }
+    std::vector<AreaClipper::Clip> clipViews;
+    for (const FlatPolygon& clip : flatClips) {
+        clipViews.push_back(AreaClipper::Clip{&clip, nullptr});
+    }
+    expectArea(name + " (union)", AreaClipper::unionIntersectionArea(flatSubject, clipViews),
+               resultArea(covered.get()), flatSubject.getArea());
+}
+
+static void runDegenerateCases() {
+    // Web Mercator magnitudes, where cancellation hurts
+    const double ox = -13600000.0, oy = 4500000.0;
+    auto square = [&](double x0, double y0, double x1, double y1) {
+        return makePolygon({{x0, y0, x1, y0, x1, y1, x0, y1}}, ox, oy);
+    };
+
+    auto base = square(0, 0, 100, 100);
+    struct Case {
+        const char* name;
+        std::unique_ptr<OGRPolygon> clip;
+    };
+    std::vector<Case> cases;
+    cases.push_back({"identical", square(0, 0, 100, 100)});
+    cases.push_back({"shared edge, outside", square(100, 0, 200, 100)});
+    cases.push_back({"shared edge, inside", square(50, 0, 100, 100)});
+    cases.push_back({"collinear partial overlap", square(100, 30, 150, 160)});
+    cases.push_back({"collinear overlap inside", square(20, 0, 70, 40)});
+    cases.push_back({"corner touch", square(100, 100, 150, 150)});
+    cases.push_back({"vertex on edge", makePolygon({{50, 100, 80, 150, 20, 150}}, ox, oy)});
+    cases.push_back({"vertex on edge, inside", makePolygon({{50, 0, 100, 50, 50, 100, 0, 50}}, ox, oy)});
+    cases.push_back({"contained", square(10, 10, 20, 20)});
+    cases.push_back({"containing", square(-10, -10, 110, 110)});
+    cases.push_back({"crossing", square(50, -50, 150, 50)});
+    cases.push_back({"disjoint", square(200, 200, 300, 300)});
+    cases.push_back({"near miss", square(100.001, 0, 200, 100)});
+    cases.push_back({"teeth on edge", makePolygon({{100, 10, 130, 20, 100, 30, 130, 40, 100, 50, 140, 60, 140, 0}}, ox, oy)});
+
+    for (const Case& c : cases) {
+        comparePair(c.name, *base, *c.clip);
+        comparePair(std::string(c.name) + ", reversed", *base, *reversed(*c.clip));
+    }
+
+    // Holes: the parcel inside, straddling and touching a hole
+    auto holed = makePolygon({{0, 0, 100, 0, 100, 100, 0, 100}, {20, 20, 20, 60, 60, 60, 60, 20}}, ox, oy);
+    comparePair("in hole", *square(30, 30, 40, 40), *holed);
+    comparePair("straddling hole", *square(10, 10, 50, 50), *holed);
+    comparePair("hole edge shared", *square(20, 20, 40, 60), *holed);
+    comparePair("hole edge touched", *square(60, 30, 70, 40), *holed);
+    comparePair("hole filled", *square(20, 20, 60, 60), *holed);
+
+    // Perimeters overlapping each other over the parcel
+    auto left = square(-10, -10, 60, 110);
+    auto right = square(40, -10, 110, 110);
+    auto middle = square(30, 30, 70, 70);
+    auto adjacent = square(60, -10, 110, 110);
+    compareUnion("overlapping pair", *base, {left.get(), right.get()});
+    compareUnion("overlapping triple", *base, {left.get(), right.get(), middle.get()});
+    compareUnion("adjacent pair", *base, {left.get(), adjacent.get()});
+    compareUnion("duplicate", *base, {left.get(), left.get()});
+    compareUnion("holed and filling", *base, {holed.get(), middle.get()});
+}
+
+// Parcel-sized polygons around random boundary vertices of real perimeters
+static void runSampledParcels(const std::vector<std::unique_ptr<OGRPolygon>>& fires,
+                              const std::vector<FlatPolygon>& flatFires) {
+    static const double kCorners[4][2] = {{-0.5, -0.5}, {0.5, -0.5}, {0.5, 0.5}, {-0.5, 0.5}};
+    std::mt19937 random(20241019);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (size_t n = 0; n < kSampledParcels; n++) {
+        const size_t f = random() % fires.size();
+        const OGRLinearRing* ring = fires[f]->getExteriorRing();
+        if (ring == nullptr || ring->getNumPoints() < 4) {
+            continue;
+        }
+        const int vertex = static_cast<int>(random() % (ring->getNumPoints() - 1));
+        const double cx = ring->getX(vertex) + (unit(random) - 0.5) * 40.0;
+        const double cy = ring->getY(vertex) + (unit(random) - 0.5) * 40.0;
+        const double width = 10.0 + unit(random) * 50.0;
+        const double height = 10.0 + unit(random) * 50.0;
+        const double angle = unit(random) * M_PI;
+        Ring corners;
+        for (const auto& [u, v] : kCorners) {
+            corners.push_back(cx + u * width * std::cos(angle) - v * height * std::sin(angle));
+            corners.push_back(cy + u * width * std::sin(angle) + v * height * std::cos(angle));
+        }
+        auto parcel = makePolygon({corners});
+        const FlatPolygon flatParcel(*parcel);
+
+        std::vector<const OGRPolygon*> candidates;
+        for (size_t i = 0; i < fires.size(); i++) {
+            if (flatParcel.envelopeIntersects(flatFires[i])) {
+                comparePair("parcel " + std::to_string(n) + " / fire " + std::to_string(i), *parcel, *fires[i]);
+                candidates.push_back(fires[i].get());
+            }
+        }
+        if (candidates.size() > 1) {
+            compareUnion("parcel " + std::to_string(n), *parcel, candidates);
+        }
+    }
+}
+
+// Perimeters of different years overlapping each other
+static void runFirePairs(const std::vector<std::unique_ptr<OGRPolygon>>& fires,
+                         const std::vector<FlatPolygon>& flatFires) {
+    size_t pairs = 0;
+    for (size_t i = 0; i < fires.size() && pairs < kSampledFirePairs; i++) {
+        for (size_t j = i + 1; j < fires.size() && pairs < kSampledFirePairs; j++) {
+            if (flatFires[i].envelopeIntersects(flatFires[j])) {
+                comparePair("fire " + std::to_string(i) + " / fire " + std::to_string(j), *fires[i], *fires[j]);
+                pairs++;
+            }
+        }
+    }
+}
+
+// Valid polygons of a shapefile; GEOS results on invalid ones mean nothing
+static std::vector<std::unique_ptr<OGRPolygon>> loadValid(const std::string& path) {
+    ShapefileHandler handler(path);
+    std::vector<std::unique_ptr<OGRPolygon>> polygons = handler.takePolygons();
+    std::erase_if(polygons, [](const auto& polygon) { return !polygon->IsValid(); });
+    return polygons;
+}
+
+static void printSummary() {
+    std::cout << checks << " checks, " << failures << " failed, " << skipped << " skipped (GEOS error)" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    runDegenerateCases();
+
+    if (argc < 2 || !std::filesystem::exists(argv[1])) {
+        std::cout << "SKIP dataset cases: " << (argc < 2 ? std::string("no wildfire shapefile given")
+                                                          : std::string(argv[1]) + " not found") << std::endl;
+        printSummary();
+        return failures == 0 ? 0 : 1;
+    }
+    std::vector<std::unique_ptr<OGRPolygon>> fires = loadValid(argv[1]);
+    if (fires.empty()) {
+        std::cout << "FAIL no valid polygons in " << argv[1] << std::endl;
+        return 1;
+    }
+    std::vector<FlatPolygon> flatFires;
+    flatFires.reserve(fires.size());
+    for (const auto& fire : fires) {
+        flatFires.emplace_back(*fire);
+    }
+    runSampledParcels(fires, flatFires);
+    runFirePairs(fires, flatFires);
+
+    if (argc > 2 && !std::filesystem::exists(argv[2])) {
+        std::cout << "SKIP Parcel_data cases: " << argv[2] << " not found" << std::endl;
+    } else if (argc > 2) {
+        for (const auto& parcel : loadValid(argv[2])) {
+            const FlatPolygon flatParcel(*parcel);
+            for (size_t i = 0; i < fires.size(); i++) {
+                if (flatParcel.envelopeIntersects(flatFires[i])) {
+                    comparePair("Parcel_data / fire " + std::to_string(i), *parcel, *fires[i]);
+                }
+            }
+        }
+    }
+
+    printSummary();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,331 @@
+#include "ParcelLoader.h"
+#include "BoundedQueue.h"
+#include "HilbertCurve.h"
+#include "Logger.h"
+#include "ShapefileHandler.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double toSeconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+// COPY binary framing: signature, flags and header extension length
+static const char kCopyHeader[] = "PGCOPY\n\377\r\n\0\0\0\0\0\0\0\0\0";
+static constexpr size_t kCopyHeaderSize = 19;
+static constexpr int16_t kFieldCount = 9;
+
+static void putInt16(std::string& out, int16_t value) {
+    uint16_t be = htons(static_cast<uint16_t>(value));
+    out.append(reinterpret_cast<const char*>(&be), 2);
+}
+
+static void putInt32(std::string& out, int32_t value) {
+    uint32_t be = htonl(static_cast<uint32_t>(value));
+    out.append(reinterpret_cast<const char*>(&be), 4);
+}
+
+static void putFloat8(std::string& out, double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, 8);
+    putInt32(out, 8);
+    putInt32(out, static_cast<int32_t>(bits >> 32));
+    putInt32(out, static_cast<int32_t>(bits));
+}
+
+// Shortest text that reads back as the same double
+static void appendDouble(std::string& out, double value) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+ParcelLoader::ParcelLoader(const LoaderConfig& config)
+    : config(config), rowCount(0), skippedCount(0), readFailed(false) {
+    if (this->config.readers == 0) {
+        this->config.readers = 1;
+    }
+    if (this->config.chunkFeatures == 0) {
+        this->config.chunkFeatures = 1;
+    }
+}
+
+size_t ParcelLoader::getRowCount() const {
+    return rowCount;
+}
+
+std::string ParcelLoader::staging() const {
+    return config.table + "_staging";
+}
+
+bool ParcelLoader::encodeRow(std::string& out, long long fid, const char* owner, const OGRGeometry& geometry) {
+    // The JSONB column keeps the one-ring format the join reads: the
+    // exterior of the largest part
+    const OGRPolygon* polygon = nullptr;
+    OGRwkbGeometryType type = wkbFlatten(geometry.getGeometryType());
+    if (type == wkbPolygon) {
+        polygon = geometry.toPolygon();
+    } else if (type == wkbMultiPolygon) {
+        const OGRMultiPolygon* parts = geometry.toMultiPolygon();
+        double largest = -1.0;
+        for (int i = 0; i < parts->getNumGeometries(); i++) {
+            const OGRPolygon* part = parts->getGeometryRef(i)->toPolygon();
+            if (part->get_Area() > largest) {
+                largest = part->get_Area();
+                polygon = part;
+            }
+        }
+    }
+    const OGRLinearRing* ring = polygon ? polygon->getExteriorRing() : nullptr;
+    if (ring == nullptr || ring->getNumPoints() == 0 || geometry.IsEmpty()) {
+        return false;
+    }
+    OGREnvelope envelope;
+    ring->getEnvelope(&envelope);
+
+    putInt16(out, kFieldCount);
+    putInt32(out, 4);
+    putInt32(out, static_cast<int32_t>(fid + 1));
+
+    if (owner == nullptr) {
+        putInt32(out, -1);
+    } else {
+        const int32_t length = static_cast<int32_t>(std::strlen(owner));
+        putInt32(out, length);
+        out.append(owner, length);
+    }
+
+    // jsonb binary input: version byte 1, then the JSON text
+    const size_t lengthAt = out.size();
+    putInt32(out, 0);
+    out.push_back('\1');
+    out.push_back('[');
+    for (int i = 0; i < ring->getNumPoints(); i++) {
+        out.append(i == 0 ? "[" : ",[");
+        appendDouble(out, ring->getX(i));
+        out.push_back(',');
+        appendDouble(out, ring->getY(i));
+        out.push_back(']');
+    }
+    out.push_back(']');
+    const uint32_t jsonLength = htonl(static_cast<uint32_t>(out.size() - lengthAt - 4));
+    std::memcpy(&out[lengthAt], &jsonLength, 4);
+
+    putFloat8(out, envelope.MinX);
+    putFloat8(out, envelope.MinY);
+    putFloat8(out, envelope.MaxX);
+    putFloat8(out, envelope.MaxY);
+
+    putInt32(out, 8);
+    const uint64_t hilbert = static_cast<uint64_t>(HilbertCurve::key(envelope));
+    putInt32(out, static_cast<int32_t>(hilbert >> 32));
+    putInt32(out, static_cast<int32_t>(hilbert));
+
+    const size_t wkbSize = geometry.WkbSize();
+    putInt32(out, static_cast<int32_t>(wkbSize));
+    const size_t wkbAt = out.size();
+    out.resize(wkbAt + wkbSize);
+    geometry.exportToWkb(wkbNDR, reinterpret_cast<unsigned char*>(&out[wkbAt]), wkbVariantIso);
+    return true;
+}
+
+bool ParcelLoader::createStaging(DatabaseHandler& db) {
+    // No keys or indexes yet: they are built once after the COPY
+    std::string ddl =
+        "DROP TABLE IF EXISTS " + staging() + ";"
+        "CREATE TABLE " + staging() + " ("
+        "    id INTEGER NOT NULL,"
+        "    owner TEXT,"
+        "    polygon JSONB,"
+        "    minx DOUBLE PRECISION,"
+        "    miny DOUBLE PRECISION,"
+        "    maxx DOUBLE PRECISION,"
+        "    maxy DOUBLE PRECISION,"
+        "    hilbert BIGINT,"
+        "    geom_wkb BYTEA"
+        ")";
+    return db.execCommand(ddl.c_str());
+}
+
+bool ParcelLoader::copyRows(DatabaseHandler& db, long long featureCount) {
+    const long long chunkCount = (featureCount + static_cast<long long>(config.chunkFeatures) - 1) /
+                                 static_cast<long long>(config.chunkFeatures);
+    BoundedQueue<std::string> chunks(config.queueCapacity);
+    std::atomic<long long> nextChunk{0};
+    std::atomic<unsigned> activeReaders{config.readers};
+    std::atomic<long long> readNanos{0};
+
+    // Each reader opens its own dataset and claims FID ranges until none are left
+    std::vector<std::thread> readers;
+    for (unsigned r = 0; r < config.readers; r++) {
+        readers.emplace_back([&] {
+            long long chunk;
+            while (!readFailed && (chunk = nextChunk++) < chunkCount) {
+                auto start = Clock::now();
+                const long long first = chunk * static_cast<long long>(config.chunkFeatures);
+                const long long end = std::min(featureCount, first + static_cast<long long>(config.chunkFeatures));
+                std::string data;
+                data.reserve(config.chunkFeatures * 512);
+                size_t rows = 0;
+                bool ok = ShapefileHandler::readFeatureRange(config.shapefilePath, first, end, config.ownerField,
+                    [&](long long fid, const char* owner, const OGRGeometry& geometry) {
+                        if (encodeRow(data, fid, owner, geometry)) {
+                            rows++;
+                        } else {
+                            skippedCount++;
+                        }
+                        return true;
+                    });
+                readNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+                if (!ok) {
+                    readFailed = true;
+                    break;
+                }
+                rowCount += rows;
+                if (!chunks.push(std::move(data))) {
+                    break;
+                }
+            }
+            if (--activeReaders == 0) {
+                chunks.close();
+            }
+        });
+    }
+
+    // The header goes first and the trailer last; everything between is
+    // whole tuples in whatever order the readers finish
+    ProgressSummary progress("Parcel chunks copied");
+    bool headerSent = false;
+    bool trailerSent = false;
+    auto copyStart = Clock::now();
+    bool ok = db.copyFrom("COPY " + staging() + " (id, owner, polygon, minx, miny, maxx, maxy, hilbert, geom_wkb) "
+                          "FROM STDIN (FORMAT binary)",
+        [&](std::string& chunk) {
+            if (!headerSent) {
+                chunk.assign(kCopyHeader, kCopyHeaderSize);
+                headerSent = true;
+                return true;
+            }
+            if (auto data = chunks.pop()) {
+                chunk = std::move(*data);
+                progress.add();
+                return true;
+            }
+            if (!trailerSent) {
+                putInt16(chunk, -1);
+                trailerSent = true;
+                return true;
+            }
+            return false;
+        });
+    // On a COPY error stop the readers instead of letting them block
+    chunks.close();
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    progress.finish();
+
+    const QueueStats queueStats = chunks.getStats();
+    LOG_INFO(std::fixed << std::setprecision(3)
+             << "  read+encode " << readNanos.load() / 1e9 << " s over " << config.readers << " readers, copy wall "
+             << toSeconds(Clock::now() - copyStart) << " s, " << toSeconds(queueStats.popWait)
+             << " s waiting for readers, " << toSeconds(queueStats.pushWait) << " s waiting for the server");
+    if (readFailed) {
+        LOG_ERROR("Reading " << config.shapefilePath << " failed");
+        return false;
+    }
+    return ok;
+}
+
+bool ParcelLoader::indexStaging(DatabaseHandler& db) {
+    std::string keys =
+        "ALTER TABLE " + staging() + " ADD CONSTRAINT " + staging() + "_pkey PRIMARY KEY (id);"
+        "CREATE INDEX " + staging() + "_hilbert_idx ON " + staging() + " (hilbert)";
+    if (!db.execCommand(keys.c_str())) {
+        return false;
+    }
+
+    // Rewrite the rows in curve order before the remaining indexes exist,
+    // so sequential and cursor reads walk the map tile by tile
+    if (config.cluster) {
+        auto start = Clock::now();
+        std::string cluster = "CLUSTER " + staging() + " USING " + staging() + "_hilbert_idx";
+        if (!db.execCommand(cluster.c_str())) {
+            return false;
+        }
+        LOG_INFO(std::fixed << std::setprecision(3) << "  clustered on the Hilbert key in "
+                 << toSeconds(Clock::now() - start) << " s");
+    }
+
+    // The box expression DatabaseHandler's extent queries use, so the GiST index serves them
+    std::string ddl =
+        "CREATE INDEX " + staging() + "_envelope_idx ON " + staging() +
+        "    USING gist (box(point(minx, miny), point(maxx, maxy)));"
+        "CREATE INDEX " + staging() + "_no_envelope_idx ON " + staging() + " (id) WHERE minx IS NULL;"
+        "ANALYZE " + staging();
+    return db.execCommand(ddl.c_str());
+}
+
+bool ParcelLoader::swapStaging(DatabaseHandler& db) {
+    const std::string& t = config.table;
+    std::string swap =
+        "BEGIN;"
+        "DROP TABLE IF EXISTS " + t + ";"
+        "ALTER TABLE " + staging() + " RENAME TO " + t + ";"
+        "ALTER TABLE " + t + " RENAME CONSTRAINT " + staging() + "_pkey TO " + t + "_pkey;"
+        "ALTER INDEX " + staging() + "_hilbert_idx RENAME TO " + t + "_hilbert_idx;"
+        "ALTER INDEX " + staging() + "_envelope_idx RENAME TO " + t + "_envelope_idx;"
+        "ALTER INDEX " + staging() + "_no_envelope_idx RENAME TO " + t + "_no_envelope_idx;"
+        "COMMIT";
+    if (!db.execCommand(swap.c_str())) {
+        db.execCommand("ROLLBACK");
+        return false;
+    }
+    return true;
+}
+
+bool ParcelLoader::run(DatabaseHandler& db) {
+    auto runStart = Clock::now();
+    const long long featureCount = ShapefileHandler::countFeatures(config.shapefilePath);
+    if (featureCount < 0) {
+        return false;
+    }
+    LOG_INFO("Loading " << featureCount << " features from " << config.shapefilePath << " into " << config.table);
+
+    if (!createStaging(db)) {
+        return false;
+    }
+    auto copyStart = Clock::now();
+    if (!copyRows(db, featureCount)) {
+        LOG_ERROR("COPY into " << staging() << " failed; " << config.table << " is unchanged");
+        return false;
+    }
+    auto indexStart = Clock::now();
+    if (!indexStaging(db)) {
+        return false;
+    }
+    auto swapStart = Clock::now();
+    if (!swapStaging(db)) {
+        LOG_ERROR("Swapping " << staging() << " into " << config.table << " failed; " << config.table << " is unchanged");
+        return false;
+    }
+    auto end = Clock::now();
+
+    const double copySeconds = toSeconds(indexStart - copyStart);
+    const double totalSeconds = toSeconds(end - runStart);
+    LOG_INFO(std::fixed << std::setprecision(3)
+             << "Loaded " << rowCount.load() << " parcels (" << skippedCount.load() << " empty skipped): copy "
+             << copySeconds << " s (" << std::setprecision(0) << (copySeconds > 0 ? rowCount / copySeconds : 0.0)
+             << " rows/s), " << std::setprecision(3) << "index " << toSeconds(swapStart - indexStart)
+             << " s, swap " << toSeconds(end - swapStart) << " s, total " << totalSeconds << " s ("
+             << std::setprecision(0) << (totalSeconds > 0 ? rowCount / totalSeconds : 0.0) << " rows/s)");
+    return true;
+}
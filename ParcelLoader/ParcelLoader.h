@@ -0,0 +1,59 @@
+#ifndef PARCEL_LOADER_H
+#define PARCEL_LOADER_H
+
+#include <atomic>
+#include <string>
+#include "DatabaseHandler.h"
+
+struct LoaderConfig {
+    std::string shapefilePath = "/opt/airflow/Parcel_Data/Parcel_data.shp";
+    std::string table = "parcels_data";
+    std::string ownerField = "Owner";
+    unsigned readers = 4;           // shapefile reader / row encoder threads
+    size_t chunkFeatures = 4096;    // features per reader task and per COPY chunk
+    size_t queueCapacity = 16;      // encoded chunks buffered ahead of COPY
+    bool cluster = true;            // store rows in Hilbert key order
+};
+
+// Bulk parcel load into PostgreSQL:
+//
+//   readers (FID ranges) ─[binary COPY chunks]─> COPY into <table>_staging
+//   ─> keys, CLUSTER on the Hilbert key, GiST envelope index, ANALYZE
+//   ─> swap with <table>
+//
+// Reader threads fetch disjoint FID ranges of the shapefile and encode rows
+// in the COPY binary format; the calling thread streams the chunks on one
+// connection. Indexes are built after the data is in, and the staging table
+// replaces the live one in a single transaction, so readers of <table> see
+// either the old or the new parcels, never a partial load.
+//
+// Rows: id = FID + 1, owner, polygon = exterior ring of the largest part as
+// JSONB [[x,y],...] (what IntersectCalculation reads), its envelope, the
+// Hilbert key of the envelope centre (HilbertCurve::key, the order parcels
+// are fetched in) and geom_wkb = the full feature geometry (all parts and
+// holes) as WKB.
+class ParcelLoader {
+private:
+    LoaderConfig config;
+    std::atomic<size_t> rowCount;
+    std::atomic<size_t> skippedCount;
+    std::atomic<bool> readFailed;
+
+    std::string staging() const;
+    bool createStaging(DatabaseHandler& db);
+    bool copyRows(DatabaseHandler& db, long long featureCount);
+    bool indexStaging(DatabaseHandler& db);
+    bool swapStaging(DatabaseHandler& db);
+
+    // Append one COPY binary tuple; false if the geometry has no polygon
+    static bool encodeRow(std::string& out, long long fid, const char* owner, const OGRGeometry& geometry);
+
+public:
+    explicit ParcelLoader(const LoaderConfig& config);
+
+    bool run(DatabaseHandler& db);
+
+    size_t getRowCount() const;
+};
+
+#endif // PARCEL_LOADER_H
@@ -0,0 +1,98 @@
+#include "DatabaseHandler.h"
+#include "Logger.h"
+#include "ParcelLoader.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <thread>
+
+void printUsage(const char* progName) {
+    std::cout << "Usage: " << progName << " [shapefile_path] [options]" << std::endl;
+    std::cout << "Loads parcels into PostgreSQL with binary COPY through a staging table." << std::endl;
+    std::cout << "  shapefile_path           Parcel shapefile (default: " << LoaderConfig().shapefilePath << ")" << std::endl;
+    std::cout << "  --table <name>           Target table (default: " << LoaderConfig().table << ")" << std::endl;
+    std::cout << "  --owner-field <name>     Owner attribute (default: " << LoaderConfig().ownerField << ")" << std::endl;
+    std::cout << "  --readers <n>            Shapefile reader threads (default: hardware concurrency)" << std::endl;
+    std::cout << "  --chunk <n>              Features per reader task / COPY chunk (default: " << LoaderConfig().chunkFeatures << ")" << std::endl;
+    std::cout << "  --cluster <on|off>       Store rows in Hilbert order of their envelope centres (default: on)" << std::endl;
+    std::cout << "  --log-level <level>      debug, info, warn or error (default: info; debug needs a -DLOG_COMPILE_LEVEL=LOG_LEVEL_DEBUG build)" << std::endl;
+}
+
+// Table names are spliced into SQL, so only plain lower-case identifiers
+static bool isPlainIdentifier(const std::string& name) {
+    if (name.empty() || name.size() > 48 || !std::islower(static_cast<unsigned char>(name[0]))) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return std::islower(static_cast<unsigned char>(c)) || std::isdigit(static_cast<unsigned char>(c)) || c == '_';
+    });
+}
+
+int main(int argc, char* argv[]) {
+    LoaderConfig config;
+    config.readers = std::max(1u, std::thread::hardware_concurrency());
+
+    int i = 1;
+    if (i < argc && argv[i][0] != '-') {
+        config.shapefilePath = argv[i++];
+    }
+    for (; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--table" && isPlainIdentifier(value)) {
+            config.table = value;
+        } else if (arg == "--owner-field") {
+            config.ownerField = value;
+        } else if (arg == "--readers") {
+            config.readers = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--chunk") {
+            config.chunkFeatures = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (arg == "--cluster" && (value == "on" || value == "off")) {
+            config.cluster = value == "on";
+        } else if (arg == "--log-level") {
+            LogLevel level;
+            if (!parseLogLevel(value, level)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            Logger::instance().setLevel(level);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        DatabaseHandler db("polygons_db", "5432", "polygons_db", "polygons_user", "polygons_pass");
+        if (!db.isConnected()) {
+            LOG_ERROR("Failed to connect to database. Exiting.");
+            Logger::instance().flush();
+            return 1;
+        }
+
+        ParcelLoader loader(config);
+        if (!loader.run(db)) {
+            LOG_ERROR("Parcel load failed.");
+            Logger::instance().flush();
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("Parcel load failed: " << e.what());
+        Logger::instance().flush();
+        return 1;
+    }
+
+    Logger::instance().flush();
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include "GeosDeadline.h"
+#include <mutex>
+#include <geos_c.h>
+
+static thread_local GeosDeadline* activeDeadline = nullptr;
+static std::once_flag callbackRegistered;
+
+GeosDeadline::GeosDeadline(double limitMs)
+    : start(Clock::now()), limited(limitMs > 0.0), interrupted(false), outer(activeDeadline) {
+    deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(limitMs));
+    std::call_once(callbackRegistered, [] { GEOS_interruptRegister(&GeosDeadline::onInterruptCheck); });
+    activeDeadline = this;
+}
+
+GeosDeadline::~GeosDeadline() {
+    activeDeadline = outer;
+}
+
+void GeosDeadline::onInterruptCheck() {
+    // Runs on the thread inside GEOS; only that thread's deadline counts
+    GeosDeadline* current = activeDeadline;
+    if (current == nullptr || !current->limited || Clock::now() < current->deadline) {
+        return;
+    }
+    current->interrupted = true;
+    GEOS_interruptRequest();
+}
+
+bool GeosDeadline::expired() const {
+    return interrupted || (limited && Clock::now() >= deadline);
+}
+
+double GeosDeadline::elapsedMs() const {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
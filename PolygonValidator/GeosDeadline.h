@@ -0,0 +1,39 @@
+#ifndef GEOS_DEADLINE_H
+#define GEOS_DEADLINE_H
+
+#include <chrono>
+
+// Time limit for the GEOS calls (through OGR) made by the current thread
+// while the object lives. GEOS polls an interrupt callback inside its long
+// loops; ours requests the interrupt once the deadline has passed, and the
+// interrupted call fails (IsValid() false, Buffer() nullptr).
+//
+// The GEOS interrupt flag is process-wide: a call running on another thread
+// when the deadline passes could be interrupted in place of ours. Callers
+// must keep every GEOS call on one thread while a deadline is in use.
+class GeosDeadline {
+public:
+    // limitMs <= 0: no limit, the object only measures
+    explicit GeosDeadline(double limitMs);
+    ~GeosDeadline();
+
+    GeosDeadline(const GeosDeadline&) = delete;
+    GeosDeadline& operator=(const GeosDeadline&) = delete;
+
+    // An interrupt was requested for this deadline, or the time is up
+    bool expired() const;
+    double elapsedMs() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start;
+    Clock::time_point deadline;
+    bool limited;
+    bool interrupted;
+    GeosDeadline* outer;        // enclosing deadline of this thread, restored on exit
+
+    static void onInterruptCheck();
+};
+
+#endif // GEOS_DEADLINE_H
@@ -0,0 +1,209 @@
+#include "HoleAnalysis.h"
+#include "RobustPredicates.h"
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+using RobustPredicates::SegmentContact;
+
+namespace {
+
+enum class Location { Inside, Outside, Boundary };
+
+struct Rings {
+    std::vector<OGRRawPoint> points;    // all rings, each closed
+    std::vector<uint32_t> ringStart;    // ring r is points[ringStart[r], ringStart[r + 1])
+    std::vector<uint32_t> segmentStart; // segment s runs points[segmentStart[s]] -> next point
+    std::vector<uint32_t> segmentRing;
+    SpatialIndex segments;              // ids are segment numbers
+
+    int numRings() const { return static_cast<int>(ringStart.size()) - 1; }
+
+    void build(const OGRPolygon& poly) {
+        auto addRing = [this](const OGRLinearRing* ring) {
+            const int n = ring->getNumPoints();
+            const size_t start = points.size();
+            ringStart.push_back(static_cast<uint32_t>(start));
+            points.resize(start + n);
+            ring->getPoints(points.data() + start);
+            if (n > 0 && (points[start].x != points.back().x || points[start].y != points.back().y)) {
+                points.push_back(points[start]);
+            }
+        };
+        addRing(poly.getExteriorRing());
+        for (int i = 0; i < poly.getNumInteriorRings(); i++) {
+            addRing(poly.getInteriorRing(i));
+        }
+        ringStart.push_back(static_cast<uint32_t>(points.size()));
+
+        std::vector<OGREnvelope> envelopes;
+        for (int r = 0; r < numRings(); r++) {
+            for (uint32_t i = ringStart[r]; i + 1 < ringStart[r + 1]; i++) {
+                OGREnvelope env;
+                env.MinX = std::min(points[i].x, points[i + 1].x);
+                env.MaxX = std::max(points[i].x, points[i + 1].x);
+                env.MinY = std::min(points[i].y, points[i + 1].y);
+                env.MaxY = std::max(points[i].y, points[i + 1].y);
+                envelopes.push_back(env);
+                segmentStart.push_back(i);
+                segmentRing.push_back(static_cast<uint32_t>(r));
+            }
+        }
+        segments.build(envelopes);
+    }
+
+    OGREnvelope ringEnvelope(int r) const {
+        OGREnvelope env;
+        env.MinX = env.MinY = std::numeric_limits<double>::infinity();
+        env.MaxX = env.MaxY = -std::numeric_limits<double>::infinity();
+        for (uint32_t i = ringStart[r]; i < ringStart[r + 1]; i++) {
+            env.MinX = std::min(env.MinX, points[i].x);
+            env.MaxX = std::max(env.MaxX, points[i].x);
+            env.MinY = std::min(env.MinY, points[i].y);
+            env.MaxY = std::max(env.MaxY, points[i].y);
+        }
+        return env;
+    }
+
+    // Winding number of ring r around p (Sunday's crossing rule), counting
+    // only segments whose box meets the ray from p towards +x
+    Location locate(int r, const OGRRawPoint& p) const {
+        OGREnvelope ray;
+        ray.MinX = p.x;
+        ray.MaxX = std::numeric_limits<double>::infinity();
+        ray.MinY = ray.MaxY = p.y;
+
+        int winding = 0;
+        bool onBoundary = false;
+        segments.query(ray, [&](uint32_t segment) {
+            if (onBoundary || segmentRing[segment] != static_cast<uint32_t>(r)) {
+                return;
+            }
+            const OGRRawPoint& a = points[segmentStart[segment]];
+            const OGRRawPoint& b = points[segmentStart[segment] + 1];
+            const int side = RobustPredicates::orientation(a.x, a.y, b.x, b.y, p.x, p.y);
+            if (side == 0 && std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x) &&
+                std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y)) {
+                onBoundary = true;
+            } else if (a.y <= p.y) {
+                if (b.y > p.y && side > 0) {
+                    winding++;
+                }
+            } else if (b.y <= p.y && side < 0) {
+                winding--;
+            }
+        });
+        if (onBoundary) {
+            return Location::Boundary;
+        }
+        return winding != 0 ? Location::Inside : Location::Outside;
+    }
+
+    // Where ring inner lies relative to ring outer, judged by its first
+    // vertex that is not on outer's boundary
+    Location locateRing(int inner, int outer) const {
+        for (uint32_t i = ringStart[inner]; i + 1 < ringStart[inner + 1]; i++) {
+            Location loc = locate(outer, points[i]);
+            if (loc != Location::Boundary) {
+                return loc;
+            }
+        }
+        return Location::Boundary;
+    }
+};
+
+uint64_t pairKey(uint32_t a, uint32_t b) {
+    return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+}
+
+} // namespace
+
+HoleReport HoleAnalysis::analyze(const OGRPolygon& poly) {
+    HoleReport report;
+    if (poly.getNumInteriorRings() == 0 || poly.getExteriorRing() == nullptr) {
+        return report;
+    }
+
+    Rings rings;
+    rings.build(poly);
+    const int numRings = rings.numRings();
+
+    // Strongest boundary contact per ring pair, from candidate segment pairs only
+    std::unordered_map<uint64_t, SegmentContact> contacts;
+    for (int r = 1; r < numRings; r++) {
+        for (uint32_t i = rings.ringStart[r]; i + 1 < rings.ringStart[r + 1]; i++) {
+            const OGRRawPoint& a = rings.points[i];
+            const OGRRawPoint& b = rings.points[i + 1];
+            OGREnvelope env;
+            env.MinX = std::min(a.x, b.x);
+            env.MaxX = std::max(a.x, b.x);
+            env.MinY = std::min(a.y, b.y);
+            env.MaxY = std::max(a.y, b.y);
+            rings.segments.query(env, [&](uint32_t segment) {
+                const uint32_t other = rings.segmentRing[segment];
+                if (other >= static_cast<uint32_t>(r)) {
+                    return;     // same ring, or a pair visited from the other side
+                }
+                const OGRRawPoint& c = rings.points[rings.segmentStart[segment]];
+                const OGRRawPoint& d = rings.points[rings.segmentStart[segment] + 1];
+                SegmentContact contact = RobustPredicates::segmentContact(a.x, a.y, b.x, b.y, c.x, c.y, d.x, d.y);
+                if (contact != SegmentContact::None) {
+                    SegmentContact& best = contacts[pairKey(other, r)];
+                    best = std::max(best, contact);
+                }
+            });
+        }
+    }
+    auto contactOf = [&contacts](int a, int b) {
+        auto it = contacts.find(pairKey(a, b));
+        return it == contacts.end() ? SegmentContact::None : it->second;
+    };
+
+    // Keep the most severe problem; ties go to the first holes found
+    auto note = [&report](HoleProblem problem, int holeA, int holeB) {
+        if (report.problem == HoleProblem::None || problem < report.problem) {
+            report.problem = problem;
+            report.holeA = holeA;
+            report.holeB = holeB;
+        }
+    };
+
+    // Each hole against the exterior ring
+    for (int r = 1; r < numRings; r++) {
+        SegmentContact contact = contactOf(0, r);
+        Location loc = contact == SegmentContact::Cross ? Location::Outside : rings.locateRing(r, 0);
+        if (loc == Location::Outside) {
+            note(HoleProblem::HoleOutsideOuter, r - 1, -1);
+        } else if (contact != SegmentContact::None || loc == Location::Boundary) {
+            note(HoleProblem::HoleTouchesOuter, r - 1, -1);
+        }
+    }
+
+    // Hole pairs whose envelopes meet: crossing, nesting or touching
+    std::vector<OGREnvelope> holeEnvelopes;
+    for (int r = 1; r < numRings; r++) {
+        holeEnvelopes.push_back(rings.ringEnvelope(r));
+    }
+    SpatialIndex holes;
+    holes.build(holeEnvelopes);
+    for (int h = 0; h < static_cast<int>(holeEnvelopes.size()); h++) {
+        holes.query(holeEnvelopes[h], [&](uint32_t other) {
+            const int g = static_cast<int>(other);
+            if (g <= h) {
+                return;
+            }
+            const int ringH = h + 1;
+            const int ringG = g + 1;
+            SegmentContact contact = contactOf(ringH, ringG);
+            if (contact == SegmentContact::Cross ||
+                rings.locateRing(ringG, ringH) == Location::Inside ||
+                rings.locateRing(ringH, ringG) == Location::Inside) {
+                note(HoleProblem::HolesOverlap, h, g);
+            } else if (contact == SegmentContact::Touch) {
+                note(HoleProblem::HolesTouch, h, g);
+            }
+        });
+    }
+    return report;
+}
@@ -0,0 +1,32 @@
+#ifndef HOLE_ANALYSIS_H
+#define HOLE_ANALYSIS_H
+
+#include <vector>
+#include <ogrsf_frmts.h>
+
+// Worst relationship found between the rings of a polygon, most severe first
+enum class HoleProblem {
+    None,
+    HolesOverlap,       // two holes share area (crossing or nested)
+    HoleOutsideOuter,   // hole not inside the exterior ring
+    HoleTouchesOuter,   // hole inside, but its boundary meets the exterior ring
+    HolesTouch,         // two holes share boundary points only
+};
+
+struct HoleReport {
+    HoleProblem problem = HoleProblem::None;
+    int holeA = -1;     // interior ring index
+    int holeB = -1;     // second interior ring for hole/hole problems
+};
+
+// One pass over all hole relationships of a polygon. Ring segments go into
+// an R-tree, so only segment pairs with overlapping envelopes are compared,
+// and point-in-ring tests only visit segments crossing the test ray. All
+// decisions use exact orientation predicates. Coordinates are read once into
+// a flat array; no temporary polygons are built.
+class HoleAnalysis {
+public:
+    static HoleReport analyze(const OGRPolygon& poly);
+};
+
+#endif // HOLE_ANALYSIS_H
@@ -1,4 +1,6 @@
 #include "PolygonValidator.h"
+#include "SegmentSweep.h"
+#include "HoleAnalysis.h"
 #include <iostream>
 #include <cmath>
 #include <sstream>
@@ -29,15 +31,44 @@ bool PolygonValidator::isValid(const OGRPolygon& poly, std::string* err) {
         if (!hasCorrectWindingOrder(hole, false, err)) return false;
         if (!isNotCollinear(hole, err)) return false;
     }
-    if(!hasOverlappingHoles(poly, err)) return false;
-    
-    if (!holesAreContainedInOuter(poly, err)) return false;
-    if (!holesDoNotTouchOuter(poly, err)) return false;
-    if (!ringsDoNotOverlap(poly, err)) return false;
-    if (!geosIsValid(poly, err)) return false;
+    if (!holesAreConsistent(poly, err)) return false;
+    if (!isNotSelfIntersecting(poly, err)) return false;
     return true;
 }
 
+// Add every polygon found in geom to out
+static void collectPolygons(const OGRGeometry* geom, OGRMultiPolygon* out) {
+    OGRwkbGeometryType type = wkbFlatten(geom->getGeometryType());
+    if (type == wkbPolygon) {
+        out->addGeometry(geom);
+    } else if (type == wkbMultiPolygon || type == wkbGeometryCollection) {
+        const OGRGeometryCollection* collection = dynamic_cast<const OGRGeometryCollection*>(geom);
+        for (int i = 0; collection && i < collection->getNumGeometries(); ++i) {
+            collectPolygons(collection->getGeometryRef(i), out);
+        }
+    }
+}
+
+OGRGeometry* PolygonValidator::repair(const OGRPolygon& poly) {
+    OGRGeometry* fixed = poly.MakeValid();
+    if (fixed == nullptr) {
+        fixed = poly.Buffer(0.0); // GEOS older than 3.8 has no MakeValid
+    }
+    if (fixed == nullptr) {
+        return nullptr;
+    }
+
+    // MakeValid keeps collapsed parts as lines and points; only areas matter
+    OGRMultiPolygon* areas = new OGRMultiPolygon();
+    collectPolygons(fixed, areas);
+    delete fixed;
+    if (areas->IsEmpty()) {
+        delete areas;
+        return nullptr;
+    }
+    return areas;
+}
+
 bool PolygonValidator::hasExteriorRing(const OGRPolygon& poly, std::string* err) {
     const OGRLinearRing* ring = poly.getExteriorRing();
     if (ring == nullptr) {
@@ -170,9 +201,12 @@ bool PolygonValidator::hasMinimumDistinctPoints(const OGRLinearRing* ring, std::
 }
 
 bool PolygonValidator::isNotSelfIntersecting(const OGRPolygon& poly, std::string* err) {
-    // This is primarily handled by GEOS IsValid(), but we keep it as a separate check
-    // for clarity. GEOS will catch self-intersections.
-    return true;
+    // Exact sweep over all rings; only polygons where segments actually meet
+    // pay for GEOS, which decides whether the overlap is within tolerance
+    if (!SegmentSweep::findIntersection(poly)) {
+        return true;
+    }
+    return geosIsValid(poly, err);
 }
 
 bool PolygonValidator::hasCorrectWindingOrder(const OGRLinearRing* ring, bool isOuter, std::string* err) {
@@ -214,110 +248,33 @@ bool PolygonValidator::isNotCollinear(const OGRLinearRing* ring, std::string* er
     return true;
 }
 
-bool PolygonValidator::holesAreContainedInOuter(const OGRPolygon& poly, std::string* err) {
-    
-    OGRPolygon outerPoly;
-    outerPoly.addRing(const_cast<OGRLinearRing*>(poly.getExteriorRing()));
-    int n = poly.getNumInteriorRings();
-    for (int i = 0; i < n; ++i) {
-        OGRPolygon holePoly;
-        holePoly.addRing(const_cast<OGRLinearRing*>(poly.getInteriorRing(i)));
-        
-        if(!outerPoly.Contains(&holePoly)) {
-            if (err) *err = "Interior ring (hole) is not contained within outer ring";
-            return false;
-        }
-
-    }
-    return true;
-}
-
-
-
-bool PolygonValidator::holesDoNotTouchOuter(const OGRPolygon& poly, std::string* err) {
-    const OGRLinearRing* outer = poly.getExteriorRing();
-    if (!outer) return true;
-
-    double eps = 1e-9; // tolerance for collinearity
-
-    for (int i = 0; i < poly.getNumInteriorRings(); ++i) {
-        const OGRLinearRing* hole = poly.getInteriorRing(i);
-
-        // Compare each segment of hole with each segment of outer ring
-        for (int j = 0; j < hole->getNumPoints() - 1; ++j) {
-            double hx1 = hole->getX(j), hy1 = hole->getY(j);
-            double hx2 = hole->getX(j + 1), hy2 = hole->getY(j + 1);
-
-            for (int k = 0; k < outer->getNumPoints() - 1; ++k) {
-
-                double ox = outer->getX(k), oy = outer->getY(k);
-
-                if (areCollinear(hx1, hy1, hx2, hy2, ox, oy, eps)) {
-                    if (err) *err = "Interior ring touches outer ring (collinear point)";
-                    return false;
-                }
-
-            }
-        }
-    }
-    return true;
-}
-
-
-
-bool PolygonValidator::ringsDoNotOverlap(const OGRPolygon& poly, std::string* err) {
-    // Check if interior rings overlap with each other
-    for (int i = 0; i < poly.getNumInteriorRings(); ++i) {
-        const OGRLinearRing* ring1 = poly.getInteriorRing(i);
-        OGRPolygon poly1;
-        poly1.addRing(const_cast<OGRLinearRing*>(ring1));
-        
-        for (int j = i + 1; j < poly.getNumInteriorRings(); ++j) {
-            const OGRLinearRing* ring2 = poly.getInteriorRing(j);
-            OGRPolygon poly2;
-            poly2.addRing(const_cast<OGRLinearRing*>(ring2));
-            
-            OGRGeometry* intersection = poly1.Intersection(&poly2);
-            if (intersection && !intersection->IsEmpty()) {
-                delete intersection;
-                if (err) *err = "Interior rings overlap";
-                return false;
-            }
-            if (intersection) delete intersection;
-        }
+bool PolygonValidator::holesAreConsistent(const OGRPolygon& poly, std::string* err) {
+    HoleReport report = HoleAnalysis::analyze(poly);
+    const char* reason = nullptr;
+    switch (report.problem) {
+        case HoleProblem::None:
+            return true;
+        case HoleProblem::HolesOverlap:
+            reason = "Two or more interior rings (holes) overlap";
+            break;
+        case HoleProblem::HoleOutsideOuter:
+            reason = "Interior ring (hole) is not contained within outer ring";
+            break;
+        case HoleProblem::HoleTouchesOuter:
+            reason = "Interior ring touches outer ring";
+            break;
+        case HoleProblem::HolesTouch:
+            reason = "Interior rings touch";
+            break;
     }
-    return true;
-}
-
-bool PolygonValidator::hasOverlappingHoles(const OGRPolygon& poly, std::string* err) {
-    // Check if any two interior rings (holes) overlap with each other
-    int numHoles = poly.getNumInteriorRings();
-    
-    for (int i = 0; i < numHoles; ++i) {
-        const OGRLinearRing* hole1 = poly.getInteriorRing(i);
-        OGRPolygon poly1;
-        poly1.addRing(const_cast<OGRLinearRing*>(hole1));
-        
-        for (int j = i + 1; j < numHoles; ++j) {
-            const OGRLinearRing* hole2 = poly.getInteriorRing(j);
-            OGRPolygon poly2;
-            poly2.addRing(const_cast<OGRLinearRing*>(hole2));
-            
-            // Check if the two holes intersect
-            OGRGeometry* intersection = poly1.Intersection(&poly2);
-            if (intersection && !intersection->IsEmpty()) {
-                // Check if the intersection is more than just a point or line (i.e., an area overlap)
-                if (intersection->getGeometryType() == wkbPolygon || 
-                    intersection->getGeometryType() == wkbMultiPolygon) {
-                delete intersection;
-                    if (err) *err = "Two or more interior rings (holes) overlap";
-                    return false;
-                }
-            }
-            if (intersection) delete intersection;
-        }
+    if (err) {
+        std::ostringstream oss;
+        oss << reason << " (hole " << report.holeA;
+        if (report.holeB >= 0) oss << " and " << report.holeB;
+        oss << ")";
+        *err = oss.str();
     }
-    return true;
+    return false;
 }
 
 double PolygonValidator::computeSignedArea(const OGRLinearRing* ring) {
@@ -10,11 +10,17 @@ public:
     // Optional err will contain a concise reason when invalid.
     static bool isValid(const OGRPolygon& poly, std::string* err = nullptr);
 
+    // Polygonal repair of an invalid polygon (MakeValid, Buffer(0) as fallback)
+    // as an OGRMultiPolygon owned by the caller, or nullptr if nothing is left.
+    static OGRGeometry* repair(const OGRPolygon& poly);
+
 private:
     static bool hasExteriorRing(const OGRPolygon& poly, std::string* err);
     static bool ringHasMinimumPoints(const OGRLinearRing* ring, std::string* err);
     static bool ringIsClosed(const OGRLinearRing* ring, std::string* err);
     static bool coordsAreFinite(const OGRLinearRing* ring, std::string* err);
+    // GEOS IsValid + Buffer(0) area tolerance; only reached when the
+    // segment sweep finds rings that touch or cross
     static bool geosIsValid(const OGRPolygon& poly, std::string* err);
     
     // Additional validation checks for specific invalid cases
@@ -23,10 +29,9 @@ private:
     static bool isNotSelfIntersecting(const OGRPolygon& poly, std::string* err);
     static bool hasCorrectWindingOrder(const OGRLinearRing* ring, bool isOuter, std::string* err);
     static bool isNotCollinear(const OGRLinearRing* ring, std::string* err);
-    static bool holesAreContainedInOuter(const OGRPolygon& poly, std::string* err);
-    static bool holesDoNotTouchOuter(const OGRPolygon& poly, std::string* err);
-    static bool ringsDoNotOverlap(const OGRPolygon& poly, std::string* err);
-    static bool hasOverlappingHoles(const OGRPolygon& poly, std::string* err);
+    // Holes inside the outer ring, not touching it or each other; one
+    // indexed pass over all rings (see HoleAnalysis)
+    static bool holesAreConsistent(const OGRPolygon& poly, std::string* err);
     
     // Helper functions
     static double computeSignedArea(const OGRLinearRing* ring);
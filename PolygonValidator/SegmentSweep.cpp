@@ -0,0 +1,219 @@
+#include "SegmentSweep.h"
+#include "RobustPredicates.h"
+#include <algorithm>
+#include <set>
+
+namespace {
+
+using Point = SegmentSweep::Point;
+
+struct Segment {
+    Point left;         // lexicographically smaller endpoint
+    Point right;
+    int ring;
+    int index;          // position in its ring
+    int ringSize;       // number of segments in its ring
+    int id;
+};
+
+bool lexLess(const Point& a, const Point& b) {
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+bool samePoint(const Point& a, const Point& b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+int orientation(const Point& a, const Point& b, const Point& c) {
+    return RobustPredicates::orientation(a.x, a.y, b.x, b.y, c.x, c.y);
+}
+
+// c is known to be collinear with a-b
+bool withinBox(const Point& a, const Point& b, const Point& c) {
+    return std::min(a.x, b.x) <= c.x && c.x <= std::max(a.x, b.x) &&
+           std::min(a.y, b.y) <= c.y && c.y <= std::max(a.y, b.y);
+}
+
+bool segmentsIntersect(const Segment& s, const Segment& t) {
+    return RobustPredicates::segmentContact(s.left.x, s.left.y, s.right.x, s.right.y,
+                                            t.left.x, t.left.y, t.right.x, t.right.y) !=
+           RobustPredicates::SegmentContact::None;
+}
+
+bool areAdjacent(const Segment& s, const Segment& t) {
+    if (s.ring != t.ring) {
+        return false;
+    }
+    const int diff = std::abs(s.index - t.index);
+    return diff == 1 || diff == s.ringSize - 1;
+}
+
+// Adjacent segments may only share their common vertex: they must not
+// be collinear with the far endpoint of one lying on the other.
+bool adjacentOverlap(const Segment& s, const Segment& t) {
+    const Point* far[2] = {&t.left, &t.right};
+    for (const Point* p : far) {
+        if (samePoint(*p, s.left) || samePoint(*p, s.right)) {
+            continue;
+        }
+        if (orientation(s.left, s.right, *p) == 0 && withinBox(s.left, s.right, *p)) {
+            return true;
+        }
+    }
+    const Point* own[2] = {&s.left, &s.right};
+    for (const Point* p : own) {
+        if (samePoint(*p, t.left) || samePoint(*p, t.right)) {
+            continue;
+        }
+        if (orientation(t.left, t.right, *p) == 0 && withinBox(t.left, t.right, *p)) {
+            return true;
+        }
+    }
+    // Folding straight back along the same segment
+    return samePoint(s.left, t.left) && samePoint(s.right, t.right);
+}
+
+bool disallowed(const Segment& s, const Segment& t) {
+    if (areAdjacent(s, t)) {
+        return adjacentOverlap(s, t);
+    }
+    return segmentsIntersect(s, t);
+}
+
+// Order of non-crossing segments along the sweep line, bottom to top
+struct BelowInSweep {
+    bool operator()(const Segment* a, const Segment* b) const {
+        if (a == b) {
+            return false;
+        }
+        if (!lexLess(b->left, a->left)) {
+            int o = orientation(a->left, a->right, b->left);
+            if (o == 0) {
+                o = orientation(a->left, a->right, b->right);
+            }
+            return o != 0 ? o > 0 : a->id < b->id;
+        }
+        int o = orientation(b->left, b->right, a->left);
+        if (o == 0) {
+            o = orientation(b->left, b->right, a->right);
+        }
+        return o != 0 ? o < 0 : a->id < b->id;
+    }
+};
+
+struct Event {
+    Point point;
+    bool insert;
+    int segment;
+};
+
+} // namespace
+
+bool SegmentSweep::findIntersection(const OGRPolygon& poly, SegmentIntersection* hit) {
+    std::vector<std::vector<Point>> rings;
+    auto addRing = [&rings](const OGRLinearRing* ring) {
+        std::vector<Point> points;
+        if (ring != nullptr) {
+            points.reserve(ring->getNumPoints());
+            for (int i = 0; i < ring->getNumPoints(); ++i) {
+                points.push_back(Point{ring->getX(i), ring->getY(i)});
+            }
+        }
+        rings.push_back(std::move(points));
+    };
+    addRing(poly.getExteriorRing());
+    for (int i = 0; i < poly.getNumInteriorRings(); ++i) {
+        addRing(poly.getInteriorRing(i));
+    }
+    return findIntersection(rings, hit);
+}
+
+bool SegmentSweep::findIntersection(const std::vector<std::vector<Point>>& rings, SegmentIntersection* hit) {
+    std::vector<Segment> segments;
+    for (size_t r = 0; r < rings.size(); ++r) {
+        // Drop repeated vertices so every segment has a length
+        std::vector<Point> ring;
+        for (const Point& p : rings[r]) {
+            if (ring.empty() || !samePoint(ring.back(), p)) {
+                ring.push_back(p);
+            }
+        }
+        if (ring.size() > 1 && samePoint(ring.front(), ring.back())) {
+            ring.pop_back();
+        }
+        if (ring.size() < 2) {
+            continue;
+        }
+
+        const int ringSize = static_cast<int>(ring.size());
+        for (int i = 0; i < ringSize; ++i) {
+            Point a = ring[i];
+            Point b = ring[(i + 1) % ringSize];
+            if (lexLess(b, a)) {
+                std::swap(a, b);
+            }
+            segments.push_back(Segment{a, b, static_cast<int>(r), i, ringSize,
+                                       static_cast<int>(segments.size())});
+        }
+    }
+
+    std::vector<Event> events;
+    events.reserve(segments.size() * 2);
+    for (const Segment& s : segments) {
+        events.push_back(Event{s.left, true, s.id});
+        events.push_back(Event{s.right, false, s.id});
+    }
+    // Inserts before removals at a shared point, so segments that only
+    // touch there are neighbours at least once
+    std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        if (!samePoint(a.point, b.point)) {
+            return lexLess(a.point, b.point);
+        }
+        return a.insert > b.insert;
+    });
+
+    auto report = [&](const Segment& s, const Segment& t) {
+        if (hit != nullptr) {
+            const Segment& first = s.ring < t.ring || (s.ring == t.ring && s.index < t.index) ? s : t;
+            const Segment& second = &first == &s ? t : s;
+            hit->ringA = first.ring;
+            hit->segmentA = first.index;
+            hit->ringB = second.ring;
+            hit->segmentB = second.index;
+            // The later left endpoint lies at or just before the meeting point
+            const Point& p = lexLess(s.left, t.left) ? t.left : s.left;
+            hit->x = p.x;
+            hit->y = p.y;
+        }
+        return true;
+    };
+
+    using Status = std::set<const Segment*, BelowInSweep>;
+    Status status;
+    std::vector<Status::iterator> positions(segments.size(), status.end());
+
+    for (const Event& event : events) {
+        const Segment& s = segments[event.segment];
+        if (event.insert) {
+            auto it = status.insert(&s).first;
+            positions[s.id] = it;
+            if (it != status.begin() && disallowed(s, **std::prev(it))) {
+                return report(s, **std::prev(it));
+            }
+            if (std::next(it) != status.end() && disallowed(s, **std::next(it))) {
+                return report(s, **std::next(it));
+            }
+        } else {
+            auto it = positions[s.id];
+            auto above = std::next(it);
+            if (it != status.begin() && above != status.end()) {
+                const Segment& below = **std::prev(it);
+                if (disallowed(below, **above)) {
+                    return report(below, **above);
+                }
+            }
+            status.erase(it);
+        }
+    }
+    return false;
+}
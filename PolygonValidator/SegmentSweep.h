@@ -0,0 +1,40 @@
+#ifndef SEGMENT_SWEEP_H
+#define SEGMENT_SWEEP_H
+
+#include <vector>
+#include <ogrsf_frmts.h>
+
+// Where two ring segments meet in a way a valid polygon does not allow.
+// Ring 0 is the exterior ring, rings 1.. are the holes.
+struct SegmentIntersection {
+    int ringA = -1;
+    int segmentA = -1;
+    int ringB = -1;
+    int segmentB = -1;
+    double x = 0.0;     // approximate location, for messages
+    double y = 0.0;
+};
+
+// Shamos-Hoey sweep over every segment of a polygon's rings, in
+// O(n log n). All decisions use exact orientation predicates, so collinear
+// and touching configurations are classified without tolerances.
+//
+// Reported: proper crossings, touching or overlapping non-adjacent segments
+// (in one ring or between rings) and adjacent segments that fold back over
+// each other. Consecutive segments sharing their common vertex are fine.
+class SegmentSweep {
+public:
+    // First disallowed intersection found, if any. Consecutive duplicate
+    // vertices are ignored and open rings are closed implicitly.
+    static bool findIntersection(const OGRPolygon& poly, SegmentIntersection* hit = nullptr);
+
+    struct Point {
+        double x, y;
+    };
+
+    // Same on raw rings
+    static bool findIntersection(const std::vector<std::vector<Point>>& rings,
+                                 SegmentIntersection* hit = nullptr);
+};
+
+#endif // SEGMENT_SWEEP_H
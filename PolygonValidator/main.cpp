@@ -1,75 +1,286 @@
 #include "PolygonValidator.h"
 #include "../Common/ShapefileHandler.h"
+#include "GeometryBudget.h"
+#include "GeometryHash.h"
+#include "GeosDeadline.h"
 #include "InvalidPolygonTableHandler.h"
+#include "Logger.h"
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <unordered_map>
 #include <string>
 #include <vector>
 
 void printUsage(const char* progName) {
-    std::cout << "Usage: " << progName << " <shapefile_path>" << std::endl;
+    std::cout << "Usage: " << progName << " <shapefile_path> [--hazard <name>] [--log-level debug|info|warn|error]"
+              << " [--time-budget <ms>] [--vertex-budget <n>]" << std::endl;
     std::cout << "Validates all polygons in the given shapefile." << std::endl;
-    std::cout << "If shapefile is wildfire data, stores validity in database." << std::endl;
+    std::cout << "Stores validity in invalid_<name> and repairs in repaired_<name> (default name: wildfire)." << std::endl;
+    std::cout << "Polygons whose GEOS checks exceed the time budget (default " << GeometryBudget().timeMs
+              << " ms per operation) or the vertex budget (default " << GeometryBudget().maxVertices
+              << ", 0 = none) go to quarantine_<name> and are validated without a deadline after the main pass." << std::endl;
+}
+
+// Per-lane counts, added up for the summary
+struct ValidationTotals {
+    int validCount = 0;
+    int invalidCount = 0;
+    int repairedCount = 0;
+    int reusedRepairCount = 0;
+    int unrepairableCount = 0;
+    int quarantinedCount = 0;   // exceeded the budget on the main pass
+    int releasedCount = 0;      // slow lane finished within the budget
+    std::map<std::string, int> invalidReasons;
+
+    void merge(const ValidationTotals& other) {
+        validCount += other.validCount;
+        invalidCount += other.invalidCount;
+        repairedCount += other.repairedCount;
+        reusedRepairCount += other.reusedRepairCount;
+        unrepairableCount += other.unrepairableCount;
+        quarantinedCount += other.quarantinedCount;
+        releasedCount += other.releasedCount;
+        for (const auto& [reason, count] : other.invalidReasons) {
+            invalidReasons[reason] += count;
+        }
+    }
+};
+
+static size_t countVertices(const OGRPolygon& polygon) {
+    size_t count = polygon.getExteriorRing() ? polygon.getExteriorRing()->getNumPoints() : 0;
+    for (int i = 0; i < polygon.getNumInteriorRings(); ++i) {
+        count += polygon.getInteriorRing(i)->getNumPoints();
+    }
+    return count;
+}
+
+// Validate one polygon, store its flag and, if invalid, its repair. With a
+// budget the GEOS calls run under a deadline; a polygon that exceeds it is
+// not stored, cost describes it and the result is false.
+static bool validatePolygon(const OGRPolygon& polygon, int polygonId, uint64_t sourceHash,
+                            InvalidPolygonTableHandler* db, const std::unordered_map<int, uint64_t>& repairedHashes,
+                            const GeometryBudget* budget, ValidationTotals& totals, QuarantineRecord& cost) {
+    const size_t vertices = countVertices(polygon);
+    cost = QuarantineRecord{polygonId, sourceHash, "validate", vertices, 0.0};
+    if (budget && budget->overVertices(vertices)) {
+        return false;
+    }
+
+    std::string err;
+    bool isValid = false;
+    if (budget) {
+        GeosDeadline deadline(budget->timeMs);
+        isValid = PolygonValidator::isValid(polygon, &err);
+        cost.elapsedMs = deadline.elapsedMs();
+        if (deadline.expired()) {
+            return false;
+        }
+    } else {
+        GeosDeadline timer(0.0);
+        isValid = PolygonValidator::isValid(polygon, &err);
+        cost.elapsedMs = timer.elapsedMs();
+    }
+
+    // Repairs are redone only when the source geometry hash changed
+    OGRGeometry* repaired = nullptr;
+    bool reused = false;
+    if (db && !isValid) {
+        auto stored = repairedHashes.find(polygonId);
+        reused = stored != repairedHashes.end() && stored->second == sourceHash;
+        if (!reused && budget) {
+            GeosDeadline deadline(budget->timeMs);
+            repaired = PolygonValidator::repair(polygon);
+            if (deadline.expired()) {
+                delete repaired;
+                cost.operation = "repair";
+                cost.elapsedMs = deadline.elapsedMs();
+                return false;
+            }
+        } else if (!reused) {
+            GeosDeadline timer(0.0);
+            repaired = PolygonValidator::repair(polygon);
+            if (timer.elapsedMs() > cost.elapsedMs) {
+                cost.operation = "repair";
+                cost.elapsedMs = timer.elapsedMs();
+            }
+        }
+    }
+
+    if (isValid) {
+        LOG_DEBUG("Polygon " << polygonId << ": VALID");
+        totals.validCount++;
+    } else {
+        LOG_DEBUG("Polygon " << polygonId << ": INVALID - " << err);
+        // Group by reason, not by the per-polygon numbers in parentheses
+        totals.invalidReasons[err.substr(0, err.find(" ("))]++;
+        totals.invalidCount++;
+    }
+    if (!db) {
+        delete repaired;
+        return true;
+    }
+
+    // Store result in database (1 = invalid, 0 = valid), keyed by the
+    // stable feature id so filtered loads can still find their flags
+    if (!db->setWildfireValidity(polygonId, !isValid)) {
+        LOG_WARN("Failed to store validity for polygon " << polygonId);
+    }
+    if (reused) {
+        totals.reusedRepairCount++;
+    } else if (repaired) {
+        RepairedGeometry repair{polygonId, sourceHash, std::vector<unsigned char>(repaired->WkbSize())};
+        repaired->exportToWkb(wkbNDR, repair.wkb.data());
+        delete repaired;
+        if (db->storeRepairedWildfire(repair)) {
+            totals.repairedCount++;
+        } else {
+            LOG_WARN("Failed to store repair for polygon " << polygonId);
+        }
+    } else if (!isValid) {
+        LOG_DEBUG("Polygon " << polygonId << ": repair left no area");
+        totals.unrepairableCount++;
+    }
+    return true;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc < 2 || argc % 2 != 0) {
         printUsage(argv[0]);
         return 1;
     }
+    std::string hazard = "wildfire";
+    GeometryBudget budget;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--log-level") {
+            LogLevel level;
+            if (!parseLogLevel(argv[i + 1], level)) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            Logger::instance().setLevel(level);
+        } else if (arg == "--hazard" && InvalidPolygonTableHandler::isValidHazardName(argv[i + 1])) {
+            hazard = argv[i + 1];
+        } else if (arg == "--time-budget") {
+            budget.timeMs = std::strtod(argv[i + 1], nullptr);
+        } else if (arg == "--vertex-budget") {
+            budget.maxVertices = std::strtoul(argv[i + 1], nullptr, 10);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
 
     std::string shapefilePath = argv[1];
     
-    // Connect to database and auto-create table if needed
-    InvalidPolygonTableHandler db("polygons_db", "5432", "polygons_db", "polygons_user", "polygons_pass");
+    // Connect to database and auto-create the hazard's tables if needed
+    InvalidPolygonTableHandler db("polygons_db", "5432", "polygons_db", "polygons_user", "polygons_pass", hazard);
     bool dbConnected = db.isConnected();
     
     if (!dbConnected) {
-        std::cout << "Warning: Database not connected. Validation results won't be stored." << std::endl;
+        LOG_WARN("Database not connected. Validation results won't be stored.");
     }
     
-    std::cout << "Loading shapefile: " << shapefilePath << std::endl;
+    LOG_INFO("Loading shapefile: " << shapefilePath);
     ShapefileHandler handler(shapefilePath);
     
-    const auto& polygons = handler.getPolygons();
+    const auto polygons = handler.takePolygons();
+    const auto& polygonIds = handler.getPolygonIds();
     
     if (polygons.empty()) {
-        std::cerr << "No polygons found in shapefile." << std::endl;
+        LOG_ERROR("No polygons found in shapefile.");
+        Logger::instance().flush();
         return 1;
     }
     
-    std::cout << "Found " << polygons.size() << " polygons." << std::endl;
-    std::cout << "\nValidating polygons...\n" << std::endl;
+    LOG_INFO("Found " << polygons.size() << " polygons. Validating...");
     
-    int validCount = 0;
-    int invalidCount = 0;
+    std::unordered_map<int, uint64_t> repairedHashes;
+    if (dbConnected && !db.getRepairedWildfireHashes(repairedHashes)) {
+        LOG_WARN("Could not read stored repairs; invalid polygons will be repaired again.");
+    }
+    std::unordered_map<int, QuarantineRecord> quarantined;
+    if (dbConnected && !db.getQuarantined(quarantined)) {
+        LOG_WARN("Could not read the quarantine; every polygon starts on the main pass.");
+    }
+
+    // Slow lane: quarantined polygons, from earlier runs or found over
+    // budget now, validated without a deadline once the main pass is done.
+    // Same thread: the GEOS interrupt is process-wide, so no GEOS call may
+    // run beside one under a deadline.
+    std::vector<size_t> slowQueue;
+    ValidationTotals totals;
+    size_t routedCount = 0;
+    ProgressSummary progress("Polygons validated");
     
     for (size_t i = 0; i < polygons.size(); ++i) {
-        std::string err;
-        bool isValid = PolygonValidator::isValid(polygons[i], &err);
-        
-        if (isValid) {
-            std::cout << "✓ Polygon " << i << ": VALID" << std::endl;
-            validCount++;
-        } else {
-            std::cout << "✗ Polygon " << i << ": INVALID - " << err << std::endl;
-            invalidCount++;
+        uint64_t sourceHash = hashPolygon(*polygons[i]);
+        auto known = quarantined.find(polygonIds[i]);
+        if (known != quarantined.end() && known->second.sourceHash == sourceHash) {
+            routedCount++;
+            slowQueue.push_back(i);
+            progress.add();
+            continue;
         }
-        
-        // Store result in database (1 = invalid, 0 = valid)
-        if (dbConnected) {
-            bool isInvalid = !isValid;
-            if (!db.setWildfireValidity(static_cast<int>(i), isInvalid)) {
-                std::cerr << "Warning: Failed to store validity for polygon " << i << std::endl;
+
+        QuarantineRecord cost;
+        if (!validatePolygon(*polygons[i], polygonIds[i], sourceHash, dbConnected ? &db : nullptr, repairedHashes,
+                             &budget, totals, cost)) {
+            LOG_WARN("Polygon " << cost.id << " exceeded the budget in " << cost.operation << " ("
+                     << cost.vertexCount << " vertices, " << cost.elapsedMs << " ms); moved to the slow lane");
+            totals.quarantinedCount++;
+            if (dbConnected && !db.storeQuarantined(cost)) {
+                LOG_WARN("Failed to quarantine polygon " << cost.id);
             }
+            slowQueue.push_back(i);
+        } else if (known != quarantined.end() && dbConnected && db.releaseQuarantined(cost.id)) {
+            // Changed since it was quarantined and now within the budget
+            totals.releasedCount++;
         }
+        progress.add();
     }
+    progress.finish();
+
+    auto slowStart = std::chrono::steady_clock::now();
+    for (size_t index : slowQueue) {
+        const OGRPolygon& polygon = *polygons[index];
+        QuarantineRecord cost;
+        validatePolygon(polygon, polygonIds[index], hashPolygon(polygon), dbConnected ? &db : nullptr,
+                        repairedHashes, nullptr, totals, cost);
+        LOG_INFO("Slow lane: polygon " << cost.id << " (" << cost.vertexCount << " vertices) took "
+                 << cost.elapsedMs << " ms");
+        if (!dbConnected) {
+            continue;
+        }
+        // Stays quarantined while it is still over budget
+        if (budget.overVertices(cost.vertexCount) || budget.overTime(cost.elapsedMs)) {
+            db.storeQuarantined(cost);
+        } else if (db.releaseQuarantined(cost.id)) {
+            totals.releasedCount++;
+        }
+    }
+    double slowSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - slowStart).count();
+
+    LOG_INFO("========================================");
+    LOG_INFO("Validation Summary:");
+    LOG_INFO("  Total polygons: " << polygons.size());
+    LOG_INFO("  Valid:          " << totals.validCount);
+    LOG_INFO("  Invalid:        " << totals.invalidCount);
+    for (const auto& [reason, count] : totals.invalidReasons) {
+        LOG_INFO("    " << count << " x " << reason);
+    }
+    if (dbConnected) {
+        LOG_INFO("  Repaired:       " << totals.repairedCount << " new, " << totals.reusedRepairCount
+                 << " unchanged since last run, " << totals.unrepairableCount << " without area");
+    }
+    LOG_INFO("  Slow lane:      " << slowQueue.size() << " polygons (" << routedCount << " quarantined earlier, "
+             << totals.quarantinedCount << " over budget now, " << totals.releasedCount
+             << " released) in " << slowSeconds << " s after the main pass");
+    LOG_INFO("========================================");
+    Logger::instance().flush();
     
-    std::cout << "\n========================================" << std::endl;
-    std::cout << "Validation Summary:" << std::endl;
-    std::cout << "  Total polygons: " << polygons.size() << std::endl;
-    std::cout << "  Valid:          " << validCount << std::endl;
-    std::cout << "  Invalid:        " << invalidCount << std::endl;
-    std::cout << "========================================" << std::endl;
-    
-    return (invalidCount > 100) ? 1 : 0;
+    return (totals.invalidCount > 100) ? 1 : 0;
 }
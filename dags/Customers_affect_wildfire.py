@@ -3,11 +3,8 @@ import logging
 import os
 
 from airflow import DAG
-from airflow.operators.python import PythonOperator
 from airflow.operators.bash import BashOperator
 
-from LoadParceltoPostgre.LoadParceltoPostgre import load_parcel_to_postgres_array as load_parcel_to_postgres_array
-
 with DAG(
     dag_id="WildFire_Customers_DAG",
     start_date=datetime(2023, 1, 1),
@@ -29,9 +26,12 @@ with DAG(
 
     # sequential task that runs after hello_task
 
-    Download_task = PythonOperator(
+    # Bulk parcel load: binary COPY into a staging table, swapped in atomically
+    ParcelLoader_bin = os.path.normpath(os.path.join(os.path.dirname(__file__),"bin", "ParcelLoader_bin"))
+
+    Download_task = BashOperator(
         task_id="Download_task",
-        python_callable=load_parcel_to_postgres_array,
+        bash_command=f"{ParcelLoader_bin} /opt/airflow/Parcel_Data/Parcel_data.shp",
     )
 
     # a task that runs in parallel with the sequential task (both depend on hello_task)
@@ -39,7 +39,8 @@ with DAG(
 
     IntersectCalculation = BashOperator(
         task_id="IntersectCalculation",
-        bash_command=IntersectCalculation_bin,
+        # The run date keys the stored affected set and its diff against the previous run
+        bash_command=IntersectCalculation_bin + " --run-date {{ ds }} --checkpoint db",
     )
 
     VerifyDB = BashOperator(
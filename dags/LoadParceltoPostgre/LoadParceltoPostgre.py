@@ -60,15 +60,48 @@ def create_table(table_name="parcels_data"):
         CREATE TABLE IF NOT EXISTS {table_name} (
             id SERIAL PRIMARY KEY,
             owner VARCHAR(255),
-            polygon JSONB
+            polygon JSONB,
+            minx DOUBLE PRECISION,
+            miny DOUBLE PRECISION,
+            maxx DOUBLE PRECISION,
+            maxy DOUBLE PRECISION
         )
     """)
     conn.commit()
+    ensure_envelope_columns(table_name)
     print(f"✓ Table '{table_name}' created successfully")
     
     cur.close()
     conn.close()
 
+def ensure_envelope_columns(table_name="parcels_data"):
+    """Add envelope columns and the GiST box index used by IntersectCalculation"""
+    conn = psycopg2.connect(
+        host="polygons_db",
+        port=5432,
+        database="polygons_db",
+        user="polygons_user",
+        password="polygons_pass"
+    )
+    cur = conn.cursor()
+
+    # Must match the box expression used in DatabaseHandler's extent query
+    cur.execute(f"""
+        ALTER TABLE {table_name}
+            ADD COLUMN IF NOT EXISTS minx DOUBLE PRECISION,
+            ADD COLUMN IF NOT EXISTS miny DOUBLE PRECISION,
+            ADD COLUMN IF NOT EXISTS maxx DOUBLE PRECISION,
+            ADD COLUMN IF NOT EXISTS maxy DOUBLE PRECISION;
+        CREATE INDEX IF NOT EXISTS {table_name}_envelope_idx ON {table_name}
+            USING gist (box(point(minx, miny), point(maxx, maxy)));
+        CREATE INDEX IF NOT EXISTS {table_name}_no_envelope_idx ON {table_name} (id)
+            WHERE minx IS NULL;
+    """)
+    conn.commit()
+
+    cur.close()
+    conn.close()
+
 def clear_table(table_name="parcels_data"):
     """Clear all data from the table to avoid duplicates"""
     conn = psycopg2.connect(
@@ -96,6 +129,8 @@ def load_parcel_to_postgres_array():
 
     if not check_and_print_table(table_name):
         create_table(table_name)
+    else:
+        ensure_envelope_columns(table_name)
 
     gdf = gpd.read_file(shapefile_path)
     clear_table(table_name)
@@ -118,11 +153,14 @@ def load_parcel_to_postgres_array():
         # Convert polygon to list of coordinate pairs
         coords = [list(c) for c in geom.exterior.coords]  # [[x,y], [x,y], ...]
 
+        # Envelope of the stored exterior ring, for server-side bbox filtering
+        minx, miny, maxx, maxy = geom.exterior.bounds
+
         # Insert into table - convert coords to JSON string for JSONB column
         
         cur.execute(
-            f"INSERT INTO {table_name} (owner, polygon) VALUES (%s, %s::jsonb)",
-            (owner, json.dumps(coords))
+            f"INSERT INTO {table_name} (owner, polygon, minx, miny, maxx, maxy) VALUES (%s, %s::jsonb, %s, %s, %s, %s)",
+            (owner, json.dumps(coords), minx, miny, maxx, maxy)
         )
 
     conn.commit()